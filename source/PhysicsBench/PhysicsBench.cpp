@@ -0,0 +1,520 @@
+// Headless physics benchmark, links the physics core only (no GLFW, glad or assimp).
+// Spawns spheres, boxes and jointed chains over a ground plane or a heightfield, runs a fixed number of steps and prints the results as JSON.
+//
+//   physics_bench --spheres 2000 --boxes 2000 --steps 600 --broadphase tree --output result.json
+
+#include "../PhysicsEngine/PhysicsScene.h"
+#include "../PhysicsEngine/JobSystem.h"
+#include "../PhysicsEngine/Sphere.h"
+#include "../PhysicsEngine/Box.h"
+#include "../PhysicsEngine/Plane.h"
+#include "../PhysicsEngine/Heightfield.h"
+#include "../PhysicsEngine/Joint.h"
+#include "../PhysicsEngine/RigidBody.h"
+#include "../PhysicsEngine/PhysicsProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace ntn;
+
+struct BenchConfig
+{
+	int spheres = 1000;
+	int boxes = 1000;
+	int chains = 0;					// ball socket chains hanging above the pile
+	int chainLinks = 10;
+	int staticBoxes = 0;			// static boxes tiling the ground under the pile
+	int steps = 600;
+	int warmupSteps = 60;
+	float timeStep = 1.0f / 60.0f;
+	float spacing = 2.5f;			// distance between spawn points
+	BroadphaseType broadphase = BroadphaseType::DynamicTree;
+	int threads = 0;				// 0 keeps the job system default
+	int churn = 0;					// loose spheres deleted and respawned every measured step, chain links stay
+	int snapshotEvery = 0;			// steps between snapshots, 0 for none
+	bool sleeping = true;
+	bool continuous = true;
+	ContactResponse response = ContactResponse::SequentialImpulse;
+	int velocityIterations = 8;
+	bool heightfield = false;		// rolling heightfield instead of the plane
+	unsigned int seed = 1;
+	std::string output;				// stdout when empty
+	std::string csv;				// profile of every measured step, none when empty
+};
+
+struct BenchResult
+{
+	double seconds = 0.0;
+	double candidatePairs = 0.0;	// per step averages
+	double testedPairs = 0.0;
+	double contacts = 0.0;
+	double sweptBodies = 0.0;
+	double sweptHits = 0.0;
+	double manifolds = 0.0;
+	double warmStarted = 0.0;
+	double joints = 0.0;
+	double colors = 0.0;
+	double allocations = 0.0;
+	double allocatedBytes = 0.0;
+	PhysicsTimings timings;			// per step averages in milliseconds
+	int sleepingBodies = 0;
+	unsigned int pooledBodies = 0;	// rigid body pool at the end of the run
+	unsigned int poolCapacity = 0;
+	int snapshots = 0;				// averages over the snapshots taken
+	double snapshotBytes = 0.0;
+	double deltaBytes = 0.0;		// against the snapshot before
+	double saveMilliseconds = 0.0;
+	double deltaMilliseconds = 0.0;
+	double restoreMilliseconds = 0.0;
+	int islands = 0;
+};
+
+static const char* BroadphaseName(BroadphaseType type)
+{
+	switch (type)
+	{
+	case BroadphaseType::SweepAndPrune:
+		return "sap";
+	case BroadphaseType::SpatialHash:
+		return "hash";
+	default:
+		return "tree";
+	}
+}
+
+static bool ParseBroadphase(const std::string& name, BroadphaseType& type)
+{
+	if (name == "sap") type = BroadphaseType::SweepAndPrune;
+	else if (name == "tree") type = BroadphaseType::DynamicTree;
+	else if (name == "hash") type = BroadphaseType::SpatialHash;
+	else return false;
+	return true;
+}
+
+static void PrintUsage()
+{
+	std::cerr <<
+		"usage: physics_bench [options]\n"
+		"  --spheres N        number of spheres (1000)\n"
+		"  --boxes N          number of boxes (1000)\n"
+		"  --chains N         ball socket chains of spheres (0)\n"
+		"  --links N          spheres per chain (10)\n"
+		"  --static-boxes N   static boxes tiling the ground (0)\n"
+		"  --steps N          measured steps (600)\n"
+		"  --warmup N         steps run before measuring (60)\n"
+		"  --dt SECONDS       fixed time step (1/60)\n"
+		"  --spacing METERS   distance between spawn points (2.5)\n"
+		"  --broadphase NAME  sap, tree or hash (tree)\n"
+		"  --threads N        job system threads, 0 for all cores (0)\n"
+		"  --churn N          loose spheres despawned and spawned again every step (0)\n"
+		"  --snapshot N       save, delta encode and restore a snapshot every N steps (0)\n"
+		"  --no-sleep         keep every body awake\n"
+		"  --no-ccd           discrete collisions only\n"
+		"  --solver NAME      impulse or forces (impulse)\n"
+		"  --iterations N     velocity iterations of the impulse solver (8)\n"
+		"  --ground NAME      plane or heightfield (plane)\n"
+		"  --seed N           random seed (1)\n"
+		"  --output FILE      write the JSON there instead of stdout\n"
+		"  --csv FILE         stream the profile of every measured step there\n";
+}
+
+static bool ParseArguments(int argc, char** argv, BenchConfig& config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--spheres" && hasValue) config.spheres = std::atoi(argv[++i]);
+		else if (arg == "--boxes" && hasValue) config.boxes = std::atoi(argv[++i]);
+		else if (arg == "--chains" && hasValue) config.chains = std::atoi(argv[++i]);
+		else if (arg == "--links" && hasValue) config.chainLinks = std::atoi(argv[++i]);
+		else if (arg == "--static-boxes" && hasValue) config.staticBoxes = std::atoi(argv[++i]);
+		else if (arg == "--steps" && hasValue) config.steps = std::atoi(argv[++i]);
+		else if (arg == "--warmup" && hasValue) config.warmupSteps = std::atoi(argv[++i]);
+		else if (arg == "--dt" && hasValue) config.timeStep = (float)std::atof(argv[++i]);
+		else if (arg == "--spacing" && hasValue) config.spacing = (float)std::atof(argv[++i]);
+		else if (arg == "--threads" && hasValue) config.threads = std::atoi(argv[++i]);
+		else if (arg == "--churn" && hasValue) config.churn = std::atoi(argv[++i]);
+		else if (arg == "--snapshot" && hasValue) config.snapshotEvery = std::atoi(argv[++i]);
+		else if (arg == "--seed" && hasValue) config.seed = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		else if (arg == "--output" && hasValue) config.output = argv[++i];
+		else if (arg == "--csv" && hasValue) config.csv = argv[++i];
+		else if (arg == "--no-sleep") config.sleeping = false;
+		else if (arg == "--no-ccd") config.continuous = false;
+		else if (arg == "--iterations" && hasValue) config.velocityIterations = std::atoi(argv[++i]);
+		else if (arg == "--solver" && hasValue)
+		{
+			std::string solver = argv[++i];
+			if (solver != "impulse" && solver != "forces")
+			{
+				std::cerr << "unknown solver " << solver << "\n";
+				return false;
+			}
+			config.response = solver == "impulse" ? ContactResponse::SequentialImpulse : ContactResponse::Forces;
+		}
+		else if (arg == "--ground" && hasValue)
+		{
+			std::string ground = argv[++i];
+			if (ground != "plane" && ground != "heightfield")
+			{
+				std::cerr << "unknown ground " << ground << "\n";
+				return false;
+			}
+			config.heightfield = ground == "heightfield";
+		}
+		else if (arg == "--broadphase" && hasValue)
+		{
+			if (!ParseBroadphase(argv[++i], config.broadphase))
+			{
+				std::cerr << "unknown broadphase " << argv[i] << "\n";
+				return false;
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return config.spheres >= 0 && config.boxes >= 0 && config.chains >= 0 && config.staticBoxes >= 0 && config.churn >= 0 && config.snapshotEvery >= 0 && config.chainLinks > 0 && config.steps > 0 && config.warmupSteps >= 0 && config.timeStep > 0.0f;
+}
+
+// bodies on a jittered grid above the plane, the scene owns and deletes them
+static void SpawnScene(PhysicsScene& scene, const BenchConfig& config)
+{
+	std::mt19937 random(config.seed);
+	std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+	std::uniform_real_distribution<float> size(0.3f, 0.9f);
+	std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+	int count = config.spheres + config.boxes;
+	int side = std::max(1, (int)std::ceil(std::sqrt((float)count / 4.0f)));
+	for (int i = 0; i < count; i++)
+	{
+		int x = i % side;
+		int z = (i / side) % side;
+		int y = i / (side * side);
+		glm::vec3 position((x - side * 0.5f) * config.spacing + jitter(random),
+			2.0f + y * config.spacing + jitter(random),
+			(z - side * 0.5f) * config.spacing + jitter(random));
+		glm::vec3 velocity(speed(random), 0.0f, speed(random));
+
+		// alternate the shapes so both kinds mix in the pile
+		bool sphere = (i % 2 == 0) ? i / 2 < config.spheres : i / 2 >= config.boxes;
+		if (sphere)
+		{
+			scene.addObject(new Sphere(position, velocity, 1.0f, size(random)));
+		}
+		else
+		{
+			float extent = size(random);
+			scene.addObject(new Box(position, velocity, 1.0f, glm::vec3(extent)));
+		}
+	}
+
+	// chains start horizontal from a pivot fixed in the world and swing down through each other
+	float top = 4.0f + (float)(count / (side * side) + 1) * config.spacing + config.chainLinks;
+	for (int chain = 0; chain < config.chains; chain++)
+	{
+		glm::vec3 pivot((chain % side - side * 0.5f) * config.spacing, top, (chain / side % side - side * 0.5f) * config.spacing);
+		PhysicsObject* previous = nullptr;
+		for (int link = 0; link < config.chainLinks; link++)
+		{
+			Sphere* sphere = new Sphere(pivot + glm::vec3(link + 1.0f, 0.0f, 0.0f), glm::vec3(0.0f), 1.0f, 0.4f);
+			scene.addObject(sphere);
+			glm::vec3 anchor = previous != nullptr ? previous->GetPosition() : pivot;
+			scene.addObject(new Joint(JointType::BallSocket, previous, sphere, anchor));
+			previous = sphere;
+		}
+	}
+
+	// a field of pillars one meter apart, bodies come to rest on and between them
+	int staticSide = (int)std::ceil(std::sqrt((float)config.staticBoxes));
+	for (int i = 0; i < config.staticBoxes; i++)
+	{
+		glm::vec3 position((i % staticSide - staticSide * 0.5f), 0.25f, (i / staticSide - staticSide * 0.5f));
+		Box* pillar = new Box(position, glm::vec3(0.0f), 1.0f, glm::vec3(0.25f));
+		pillar->Rigidbody()->setStatic(true);
+		scene.addObject(pillar);
+	}
+
+	if (!config.heightfield)
+	{
+		scene.addObject(new Plane(glm::vec3(0.0f, 1.0f, 0.0f), 0.0f));
+		return;
+	}
+	// one sample per meter, covering the spawn grid with a margin, gentle hills below y = 0
+	unsigned int samples = (unsigned int)std::ceil(side * config.spacing) + 16;
+	std::vector<float> heights(samples * samples);
+	for (unsigned int z = 0; z < samples; z++)
+	{
+		for (unsigned int x = 0; x < samples; x++)
+		{
+			heights[z * samples + x] = std::sin(x * 0.3f) * std::cos(z * 0.2f) - 1.0f;
+		}
+	}
+	Heightfield* ground = new Heightfield();
+	ground->SetHeights(std::move(heights), samples, samples, glm::vec2(-(float)samples / 2.0f));
+	scene.addObject(ground);
+}
+
+static BenchResult RunBench(const BenchConfig& config)
+{
+	PhysicsScene scene;
+	scene.m_properties = PhysicsProperties(true, true, true);
+	scene.m_properties.broadphase = config.broadphase;
+	scene.m_properties.sleeping = config.sleeping;
+	scene.m_properties.continuousCollisions = config.continuous;
+	scene.m_properties.response = config.response;
+	scene.m_properties.solver.velocityIterations = config.velocityIterations;
+	scene.setGravity(glm::vec3(0.0f, -9.81f, 0.0f));
+	scene.setTimeStep(config.timeStep);
+	SpawnScene(scene, config);
+
+	// chain links stay, a joint must never outlive its bodies
+	std::vector<PhysicsObject*> jointed;
+	for (PhysicsObject* object : scene.getAllObjects())
+	{
+		if (object->getShapeID() == JOINT)
+		{
+			Joint* joint = static_cast<Joint*>(object);
+			jointed.push_back(joint->getObjectA());
+			jointed.push_back(joint->getObjectB());
+		}
+	}
+	std::sort(jointed.begin(), jointed.end());
+
+	// the spheres that can be churned, by handle since they come and go
+	std::vector<PoolHandle> spheres;
+	for (PhysicsObject* object : scene.getAllObjects())
+	{
+		if (object->getShapeID() == SPHERE && !std::binary_search(jointed.begin(), jointed.end(), object))
+		{
+			PoolHandle handle = ObjectPool<Sphere>::getInstance().HandleOf(static_cast<Sphere*>(object));
+			if (handle.isValid())
+			{
+				spheres.push_back(handle);
+			}
+		}
+	}
+	std::mt19937 random(config.seed + 1);
+
+	for (int step = 0; step < config.warmupSteps; step++)
+	{
+		scene.Update(config.timeStep);
+	}
+
+	PhysicsProfiler profiler;
+	if (!config.csv.empty() && !profiler.StartCsv(config.csv))
+	{
+		std::cerr << "cannot write " << config.csv << "\n";
+	}
+
+	BenchResult result;
+	PhysicsSnapshot snapshot;
+	PhysicsSnapshot previousSnapshot;
+	std::vector<uint8_t> delta;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int step = 0; step < config.steps; step++)
+	{
+		// a sphere is replaced by a new one dropped from the top of the pile
+		for (int i = 0; i < config.churn && !spheres.empty(); i++)
+		{
+			PoolHandle& handle = spheres[random() % spheres.size()];
+			Sphere* sphere = ObjectPool<Sphere>::getInstance().Get(handle);
+			if (sphere == nullptr)
+			{
+				continue;
+			}
+			glm::vec3 position = sphere->GetStartPosition();
+			float radius = sphere->GetRadius();
+			scene.removeObject(sphere);
+			delete sphere;
+			sphere = new Sphere(position, glm::vec3(0.0f), 1.0f, radius);
+			scene.addObject(sphere);
+			handle = ObjectPool<Sphere>::getInstance().HandleOf(sphere);
+		}
+
+		scene.Update(config.timeStep);
+		profiler.Record(scene.getProfile());
+
+		// restoring what was just saved leaves the run as it was, only the cost shows
+		if (config.snapshotEvery > 0 && step % config.snapshotEvery == 0)
+		{
+			auto saveStart = std::chrono::high_resolution_clock::now();
+			scene.SaveSnapshot(snapshot);
+			auto deltaStart = std::chrono::high_resolution_clock::now();
+			snapshot.EncodeDelta(previousSnapshot, delta);
+			auto restoreStart = std::chrono::high_resolution_clock::now();
+			scene.RestoreSnapshot(snapshot);
+			auto restoreEnd = std::chrono::high_resolution_clock::now();
+
+			result.snapshots++;
+			result.snapshotBytes += snapshot.size();
+			result.deltaBytes += delta.size();
+			result.saveMilliseconds += std::chrono::duration<double, std::milli>(deltaStart - saveStart).count();
+			result.deltaMilliseconds += std::chrono::duration<double, std::milli>(restoreStart - deltaStart).count();
+			result.restoreMilliseconds += std::chrono::duration<double, std::milli>(restoreEnd - restoreStart).count();
+			std::swap(snapshot, previousSnapshot);
+		}
+
+		const CollisionStats& stats = scene.getCollisionStats();
+		result.candidatePairs += stats.candidatePairs;
+		result.testedPairs += stats.testedPairs;
+		result.contacts += stats.contacts;
+		result.sweptBodies += stats.sweptBodies;
+		result.sweptHits += stats.sweptHits;
+		result.manifolds += stats.manifolds;
+		result.warmStarted += stats.warmStarted;
+		result.joints += stats.joints;
+		result.colors += stats.colors;
+		result.allocations += scene.getProfile().allocations;
+		result.allocatedBytes += scene.getProfile().allocatedBytes;
+
+		const PhysicsTimings& timings = scene.getTimings();
+		result.timings.integrate += timings.integrate;
+		result.timings.broadphase += timings.broadphase;
+		result.timings.continuous += timings.continuous;
+		result.timings.narrowphase += timings.narrowphase;
+		result.timings.response += timings.response;
+		result.timings.islands += timings.islands;
+		result.timings.total += timings.total;
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	float steps = (float)config.steps;
+	result.candidatePairs /= steps;
+	result.testedPairs /= steps;
+	result.contacts /= steps;
+	result.sweptBodies /= steps;
+	result.sweptHits /= steps;
+	result.manifolds /= steps;
+	result.warmStarted /= steps;
+	result.joints /= steps;
+	result.colors /= steps;
+	result.allocations /= steps;
+	result.allocatedBytes /= steps;
+	result.timings.integrate /= steps;
+	result.timings.broadphase /= steps;
+	result.timings.continuous /= steps;
+	result.timings.narrowphase /= steps;
+	result.timings.response /= steps;
+	result.timings.islands /= steps;
+	result.timings.total /= steps;
+	if (result.snapshots > 0)
+	{
+		result.snapshotBytes /= result.snapshots;
+		result.deltaBytes /= result.snapshots;
+		result.saveMilliseconds /= result.snapshots;
+		result.deltaMilliseconds /= result.snapshots;
+		result.restoreMilliseconds /= result.snapshots;
+	}
+	result.sleepingBodies = scene.numberOfSleepingBodies();
+	result.pooledBodies = ObjectPool<RigidBody>::getInstance().numberOfLive();
+	result.poolCapacity = ObjectPool<RigidBody>::getInstance().capacity();
+	result.islands = scene.numberOfIslands();
+	return result;
+}
+
+static std::string ToJson(const BenchConfig& config, const BenchResult& result)
+{
+	std::ostringstream json;
+	json.precision(6);
+	json << std::fixed;
+	json << "{\n";
+	json << "  \"config\": {\n";
+	json << "    \"spheres\": " << config.spheres << ",\n";
+	json << "    \"boxes\": " << config.boxes << ",\n";
+	json << "    \"chains\": " << config.chains << ",\n";
+	json << "    \"chain_links\": " << config.chainLinks << ",\n";
+	json << "    \"static_boxes\": " << config.staticBoxes << ",\n";
+	json << "    \"steps\": " << config.steps << ",\n";
+	json << "    \"warmup_steps\": " << config.warmupSteps << ",\n";
+	json << "    \"time_step\": " << config.timeStep << ",\n";
+	json << "    \"broadphase\": \"" << BroadphaseName(config.broadphase) << "\",\n";
+	json << "    \"churn\": " << config.churn << ",\n";
+	json << "    \"snapshot_every\": " << config.snapshotEvery << ",\n";
+	json << "    \"threads\": " << JobSystem::getInstance().numberOfThreads() << ",\n";
+	json << "    \"sleeping\": " << (config.sleeping ? "true" : "false") << ",\n";
+	json << "    \"continuous\": " << (config.continuous ? "true" : "false") << ",\n";
+	json << "    \"solver\": \"" << (config.response == ContactResponse::SequentialImpulse ? "impulse" : "forces") << "\",\n";
+	json << "    \"velocity_iterations\": " << config.velocityIterations << ",\n";
+	json << "    \"ground\": \"" << (config.heightfield ? "heightfield" : "plane") << "\",\n";
+	json << "    \"seed\": " << config.seed << "\n";
+	json << "  },\n";
+	json << "  \"seconds\": " << result.seconds << ",\n";
+	json << "  \"steps_per_second\": " << (result.seconds > 0.0 ? config.steps / result.seconds : 0.0) << ",\n";
+	json << "  \"candidate_pairs\": " << result.candidatePairs << ",\n";
+	json << "  \"tested_pairs\": " << result.testedPairs << ",\n";
+	json << "  \"contacts\": " << result.contacts << ",\n";
+	json << "  \"swept_bodies\": " << result.sweptBodies << ",\n";
+	json << "  \"swept_hits\": " << result.sweptHits << ",\n";
+	json << "  \"manifolds\": " << result.manifolds << ",\n";
+	json << "  \"warm_started\": " << result.warmStarted << ",\n";
+	json << "  \"joints\": " << result.joints << ",\n";
+	json << "  \"colors\": " << result.colors << ",\n";
+	json << "  \"allocations\": " << result.allocations << ",\n";
+	json << "  \"allocated_bytes\": " << result.allocatedBytes << ",\n";
+	json << "  \"sleeping_bodies\": " << result.sleepingBodies << ",\n";
+	json << "  \"pooled_bodies\": " << result.pooledBodies << ",\n";
+	json << "  \"pool_capacity\": " << result.poolCapacity << ",\n";
+	json << "  \"snapshots\": " << result.snapshots << ",\n";
+	json << "  \"snapshot_bytes\": " << result.snapshotBytes << ",\n";
+	json << "  \"delta_bytes\": " << result.deltaBytes << ",\n";
+	json << "  \"snapshot_ms\": { \"save\": " << result.saveMilliseconds << ", \"delta\": " << result.deltaMilliseconds
+		<< ", \"restore\": " << result.restoreMilliseconds << " },\n";
+	json << "  \"islands\": " << result.islands << ",\n";
+	json << "  \"phase_ms\": {\n";
+	json << "    \"integrate\": " << result.timings.integrate << ",\n";
+	json << "    \"broadphase\": " << result.timings.broadphase << ",\n";
+	json << "    \"continuous\": " << result.timings.continuous << ",\n";
+	json << "    \"narrowphase\": " << result.timings.narrowphase << ",\n";
+	json << "    \"response\": " << result.timings.response << ",\n";
+	json << "    \"islands\": " << result.timings.islands << ",\n";
+	json << "    \"total\": " << result.timings.total << "\n";
+	json << "  }\n";
+	json << "}\n";
+	return json.str();
+}
+
+int main(int argc, char** argv)
+{
+	BenchConfig config;
+	if (!ParseArguments(argc, argv, config))
+	{
+		PrintUsage();
+		return 1;
+	}
+	if (config.threads > 0)
+	{
+		JobSystem::getInstance().setNumberOfThreads(config.threads);
+	}
+
+	BenchResult result = RunBench(config);
+	std::string json = ToJson(config, result);
+
+	if (config.output.empty())
+	{
+		std::cout << json;
+	}
+	else
+	{
+		std::ofstream file(config.output);
+		if (!file)
+		{
+			std::cerr << "cannot write " << config.output << "\n";
+			return 1;
+		}
+		file << json;
+	}
+	return 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "glm/glm.hpp"
+
+#include <limits>
+
+namespace ntn
+{
+	// Axis aligned box used by the physics broadphase.
+	// Kept free of any rendering dependency, see BoundingBox for the render side.
+	struct AABB
+	{
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+		AABB() = default;
+		AABB(const glm::vec3& minBound, const glm::vec3& maxBound) : min(minBound), max(maxBound) {}
+
+		static AABB FromCenterExtents(const glm::vec3& center, const glm::vec3& halfExtents)
+		{
+			return AABB(center - halfExtents, center + halfExtents);
+		}
+
+		glm::vec3 GetCenter() const { return 0.5f * (min + max); }
+		glm::vec3 GetExtents() const { return 0.5f * (max - min); }
+
+		bool Overlaps(const AABB& other) const
+		{
+			if (max.x < other.min.x || min.x > other.max.x) return false;
+			if (max.y < other.min.y || min.y > other.max.y) return false;
+			if (max.z < other.min.z || min.z > other.max.z) return false;
+			return true;
+		}
+
+		bool Contains(const AABB& other) const
+		{
+			return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+				   max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+		}
+
+		static AABB Union(const AABB& a, const AABB& b)
+		{
+			return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+		}
+
+		// half the surface area, enough to compare insertion costs
+		float HalfSurfaceArea() const
+		{
+			glm::vec3 size = max - min;
+			return size.x * size.y + size.y * size.z + size.z * size.x;
+		}
+
+		// slab test, distance is the entry point along the ray (0 when the origin is inside)
+		bool RayIntersect(const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance, float& distance) const
+		{
+			glm::vec3 t0 = (min - origin) * invDirection;
+			glm::vec3 t1 = (max - origin) * invDirection;
+			glm::vec3 tNear = glm::min(t0, t1);
+			glm::vec3 tFar = glm::max(t0, t1);
+
+			float tEnter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+			float tExit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+			if (tEnter > tExit)
+			{
+				return false;
+			}
+			distance = tEnter;
+			return true;
+		}
+	};
+}
@@ -0,0 +1,75 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace ntn
+{
+
+static std::atomic<uint64_t> s_allocations{ 0 };
+static std::atomic<uint64_t> s_allocatedBytes{ 0 };
+static thread_local bool t_counted = false;
+
+void AllocationCounter::CountThisThread(bool count)
+{
+	t_counted = count;
+}
+
+bool AllocationCounter::isCountingThisThread()
+{
+	return t_counted;
+}
+
+uint64_t AllocationCounter::numberOfAllocations()
+{
+	return s_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::allocatedBytes()
+{
+	return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+}
+
+/*********************************************************************************************************
+* Global allocation functions
+**********************************************************************************************************/
+// the array and nothrow forms call these, aligned allocations are not counted
+void* operator new(size_t size)
+{
+	if (ntn::t_counted)
+	{
+		ntn::s_allocations.fetch_add(1, std::memory_order_relaxed);
+		ntn::s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+	if (size == 0)
+	{
+		size = 1;
+	}
+	for (;;)
+	{
+		void* pointer = std::malloc(size);
+		if (pointer != nullptr)
+		{
+			return pointer;
+		}
+		std::new_handler handler = std::get_new_handler();
+		if (handler == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		handler();
+	}
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	std::free(pointer);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+namespace ntn
+{
+	// Heap allocations counted through the replaced global operator new.
+	// Only the threads that opted in are counted: a PhysicsScene counts its Update on the calling thread,
+	// the job system workers are counted all the time.
+	class AllocationCounter
+	{
+	public:
+		// count the allocations of the calling thread from now on, or stop
+		static void CountThisThread(bool count);
+		static bool isCountingThisThread();
+
+		// totals of every counted thread since the program started
+		static uint64_t numberOfAllocations();
+		static uint64_t allocatedBytes();
+	};
+}
@@ -0,0 +1,145 @@
+#define NOMINMAX
+#include "BoxModel.h"
+
+#include <sstream>
+#include "glm/glm.hpp"
+#include "glm/gtc/type_ptr.hpp"
+#include "glm/gtx/transform.hpp"
+namespace ntn
+{
+    BoxModel::BoxModel(const std::string& pathToModel, const glm::vec3& position,
+        glm::vec3 velocity, float mass, glm::vec3 size, const glm::vec3& scale) :
+        Box(position, velocity, mass, size)
+    {
+        LoadModel(pathToModel);
+        ComputeBoundingBox();
+        m_size = m_bbox.GetDimensions() / 2.0f;
+    }
+
+    BoxModel::BoxModel(BoxModel& other) :Box(other)
+    {
+        // Copy the Model (assuming Model has a copy constructor or supports cloning)
+        if (other.m_model) {
+            m_model = std::make_unique<Model>(*other.m_model);
+        }
+        else {
+            m_model = nullptr;
+        }
+        ComputeBoundingBox();
+        m_size = m_bbox.GetDimensions() / 2.0f;
+    }
+
+    void BoxModel::Copy(const BoxModel& other)
+    {
+        // Copy the base class part
+        Box::Copy(other);
+        if (other.m_model) {
+            m_model = std::make_unique<Model>(*other.m_model);
+        }
+        else {
+            m_model = nullptr;
+        }
+    }
+    void BoxModel::LoadModel(const std::string& pathToModel)
+    {
+        m_model = std::make_unique<Model>(pathToModel);
+    }
+    void BoxModel::Render(Shader& shader, const glm::vec3& position, const glm::vec3& rotation)
+    {
+        if (!m_model)
+            return;
+        // Update the model matrix based on the position
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+
+        //Apply transtion 
+        modelMatrix = glm::translate(modelMatrix, position);
+
+        // Apply rotation
+        modelMatrix = glm::rotate(modelMatrix, rotation.z, glm::vec3(0, 0, 1));
+        modelMatrix = glm::rotate(modelMatrix, rotation.y, glm::vec3(0, 1, 0));
+        modelMatrix = glm::rotate(modelMatrix, rotation.x, glm::vec3(1, 0, 0));
+
+        // Apply scaling 
+        modelMatrix = glm::scale(modelMatrix, m_scale);
+
+        shader.setMat4("model", modelMatrix);
+        m_model->Render(shader);
+    }
+
+    void BoxModel::ComputeBoundingBox()
+    {
+        if (m_model->meshes.empty())
+        {
+            return;
+        }
+        m_bbox.Reset();
+        // Initialize temporary bounds with the position of the first vertex
+        glm::vec3 pos = GetPosition();
+        glm::vec3 minBound_temp = m_model->meshes[0].vertices[0].Position + pos;
+        glm::vec3 maxBound_temp = minBound_temp;
+
+        // Iterate over each mesh within the model
+        for (const Mesh& mesh : m_model->meshes)
+        {
+            // Iterate over each vertex within the mesh
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                // Apply the model's position to the vertex
+                glm::vec3 vertexPosition = vertex.Position + pos;
+
+                // Update the temporary bounds more efficiently
+                minBound_temp = glm::min(minBound_temp, vertexPosition);
+                maxBound_temp = glm::max(maxBound_temp, vertexPosition);
+            }
+        }
+
+        // Update the model's bounding box with scale
+        minBound_temp *= m_scale;
+        maxBound_temp *= m_scale;
+
+        m_bbox.setMinBound(minBound_temp);
+        m_bbox.setMaxBound(maxBound_temp);
+        m_bboxPosition = pos;
+    }
+
+    const BoundingBox& BoxModel::GetBoundingBox() const
+    {
+        glm::vec3 pos = GetPosition();
+        if (pos != m_bboxPosition)
+        {
+            m_bbox.Move(pos - m_bboxPosition);
+            m_bboxPosition = pos;
+        }
+        return m_bbox;
+    }
+
+    BoundingBox BoxModel::GetBoundingBoxAt(const glm::vec3& position) const
+    {
+        BoundingBox bbox = m_bbox;
+        bbox.Move(position - m_bboxPosition);
+        return bbox;
+    }
+
+    void BoxModel::Translation(const glm::vec3&& deltaPos)
+    {
+        SetPosition(GetPosition() + deltaPos);
+    }
+
+    std::string BoxModel::GetInfo()
+    {
+        return GetInfo(GetPosition(), GetRotation());
+    }
+
+    std::string BoxModel::GetInfo(const glm::vec3& position, const glm::vec3& rotation) const
+    {
+        std::stringstream ss;
+        ss << "BoxModel Position: " << std::to_string(position.x) << " " <<
+            std::to_string(position.y) << " " <<
+            std::to_string(position.z) << "\n ";
+
+        ss << "Rotation: " << std::to_string(rotation.x) << " " <<
+            std::to_string(rotation.y) << " " <<
+            std::to_string(rotation.z);
+        return ss.str();
+    }
+}
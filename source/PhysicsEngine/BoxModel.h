@@ -0,0 +1,66 @@
+#pragma once
+
+#include"Box.h"
+#include"../Model.h"
+#include"../BoundingBox.h"
+
+#include<memory>
+
+namespace ntn
+{
+	// Box rendered with a model, the physics side stays in Box
+	class BoxModel : public Box
+	{
+	public:
+		BoxModel() = default;
+
+		BoxModel(const std::string& pathToModel, const glm::vec3& position = glm::vec3(0.0f),
+			glm::vec3 velocity = glm::vec3(1.0f, 0.0f, 0.0f),
+			float mass = 100.f, glm::vec3 size = glm::vec3(0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+		BoxModel(BoxModel& other);
+
+		void Copy(const BoxModel& other);
+
+		virtual ~BoxModel() {};
+
+		// larger than a Box, the cubes get their own pool
+		static void* operator new(size_t size) { return ObjectPool<BoxModel>::Allocate(size); }
+		static void operator delete(void* pointer, size_t size) { ObjectPool<BoxModel>::Free(pointer, size); }
+
+		std::string GetInfo();
+		// from a published transform, other threads must not read the live body
+		std::string GetInfo(const glm::vec3& position, const glm::vec3& rotation) const;
+
+		//	glm::vec3 GetPosition() override;
+
+		//	void SetRotation(const glm::vec3& newRotation);
+		//	inline glm::vec3 GetRotation() const { return m_rotation; }
+
+		inline void SetScale(const glm::vec3& newScale) { m_scale = newScale; }
+		inline glm::vec3 GetScale() const { return m_scale; }
+
+		void Translation(const glm::vec3&& deltaPos = glm::vec3(0.0f));
+
+		inline void SetModel(Model* model) { m_model.reset(model); }
+		inline const std::unique_ptr<Model>& GetModel() const { return m_model; }
+
+		// at the transform published by the physics thread, not the live one it is stepping
+		void Render(Shader& shader, const glm::vec3& position, const glm::vec3& rotation);
+
+		void ComputeBoundingBox();
+
+		// the box follows the body lazily, integration does not touch it
+		const BoundingBox& GetBoundingBox() const;
+		// the same box around a published position, leaves the cached one alone
+		BoundingBox GetBoundingBoxAt(const glm::vec3& position) const;
+
+	private:
+		std::unique_ptr<Model> m_model = nullptr;
+		void LoadModel(const std::string& pathToModel);
+		glm::vec3 m_scale = glm::vec3(1.0f);
+		mutable BoundingBox m_bbox;
+		mutable glm::vec3 m_bboxPosition = glm::vec3(0.0f);	// body position the box was last moved to
+
+	};
+}
\ No newline at end of file
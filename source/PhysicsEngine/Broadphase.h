@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+#include <functional>
+#include <memory>
+
+#include "AABB.h"
+
+namespace ntn
+{
+	class PhysicsObject;
+
+	struct BroadphasePair
+	{
+		PhysicsObject* objA = nullptr;
+		PhysicsObject* objB = nullptr;
+	};
+
+	// returns the new max distance of the ray: 0 stops the query, the current max distance ignores the object
+	typedef std::function<float(PhysicsObject* object, const glm::vec3& origin, const glm::vec3& direction, float maxDistance)> RayCastCallback;
+
+	class Broadphase
+	{
+	public:
+		virtual ~Broadphase() = default;
+
+		virtual void Insert(PhysicsObject* object) = 0;
+		virtual void Remove(PhysicsObject* object) = 0;
+		virtual void Clear() = 0;
+
+		// pick up the bodies that moved since the last step
+		virtual void Update(float timeStep) = 0;
+		// pairs whose bounds overlap, in a stable order
+		virtual const std::vector<BroadphasePair>& ComputePairs() = 0;
+
+		virtual void QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results) = 0;
+		// bounds of the object as of the last update, false when it has no proxy here
+		virtual bool GetBounds(const PhysicsObject* object, AABB& bounds) const = 0;
+		virtual void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback) = 0;
+
+		virtual int numberOfProxies() const = 0;
+		// copy of the whole structure, for snapshots
+		virtual std::unique_ptr<Broadphase> Clone() const = 0;
+	};
+}
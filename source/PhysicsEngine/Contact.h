@@ -0,0 +1,32 @@
+#pragma once
+#include "glm/glm.hpp"
+
+namespace ntn
+{
+	class PhysicsObject;
+
+	// pair kinds with a response, objA/objB follow the order in the name
+	enum class ContactType
+	{
+		SphereSphere = 0,
+		SpherePlane,
+		BoxSphere,
+		BoxPlane,
+		BoxBox,
+		SphereHeightfield,
+		BoxHeightfield
+	};
+
+	// Result of a narrowphase test. Detection only fills contacts,
+	// bodies are changed later when the contacts are resolved.
+	struct Contact
+	{
+		PhysicsObject* objA = nullptr;
+		PhysicsObject* objB = nullptr;
+		ContactType type = ContactType::SphereSphere;
+		glm::vec3 normal = glm::vec3(0.0f);		// from A towards B, surface normal for plane and heightfield contacts
+		glm::vec3 overlap = glm::vec3(0.0f);	// per axis overlap of box contacts
+		float distance = 0.0f;					// center distance of spheres, plane and heightfield penetration
+		int order = 0;							// index of the pair, contacts are resolved in this order
+	};
+}
@@ -0,0 +1,482 @@
+#include "ContactSolver.h"
+#include "PhysicsObject.h"
+#include "RigidBody.h"
+#include "RigidBodyWorld.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Box.h"
+#include "Heightfield.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ntn
+{
+
+// colors a constraint can take, the ones left over go to one more color solved on the calling thread
+static const int MaxColors = 63;
+
+static float Elasticity(PhysicsObject* object)
+{
+	switch (object->getShapeID())
+	{
+	case PLANE:
+		return static_cast<Plane*>(object)->getElasticity();
+	case HEIGHTFIELD:
+		return static_cast<Heightfield*>(object)->getElasticity();
+	default:
+		return object->Rigidbody() != nullptr ? object->Rigidbody()->m_data.elasticity : 0.0f;
+	}
+}
+
+// normal and depth between two axis aligned boxes, along the axis of least overlap
+static void BoxBoxNormal(Box& boxA, Box& boxB, glm::vec3& normal, float& penetration)
+{
+	glm::vec3 centerDist = boxB.GetPosition() - boxA.GetPosition();
+	glm::vec3 overlap = boxA.GetSize() + boxB.GetSize() - glm::abs(centerDist);
+	int axis = 0;
+	if (overlap.y < overlap[axis]) axis = 1;
+	if (overlap.z < overlap[axis]) axis = 2;
+	normal = glm::vec3(0.0f);
+	normal[axis] = centerDist[axis] < 0.0f ? -1.0f : 1.0f;
+	penetration = overlap[axis];
+}
+
+// normal from the box towards the sphere and depth, through the closest point of the box
+static void BoxSphereNormal(Box& box, Sphere& sphere, glm::vec3& normal, float& penetration)
+{
+	glm::vec3 center = sphere.GetPosition();
+	glm::vec3 boxCenter = box.GetPosition();
+	glm::vec3 halfExtents = box.GetSize();
+	glm::vec3 closest = glm::clamp(center, boxCenter - halfExtents, boxCenter + halfExtents);
+	glm::vec3 offset = center - closest;
+	float distance = glm::length(offset);
+	if (distance > 1e-6f)
+	{
+		normal = offset / distance;
+		penetration = sphere.GetRadius() - distance;
+		return;
+	}
+	// center inside the box, push out through the nearest face
+	glm::vec3 local = center - boxCenter;
+	glm::vec3 faceDistance = halfExtents - glm::abs(local);
+	int axis = 0;
+	if (faceDistance.y < faceDistance[axis]) axis = 1;
+	if (faceDistance.z < faceDistance[axis]) axis = 2;
+	normal = glm::vec3(0.0f);
+	normal[axis] = local[axis] < 0.0f ? -1.0f : 1.0f;
+	penetration = sphere.GetRadius() + faceDistance[axis];
+}
+
+bool ContactSolver::BuildManifold(const Contact& contact, ContactManifold& manifold)
+{
+	manifold.objA = contact.objA;
+	manifold.objB = contact.objB;
+	switch (contact.type)
+	{
+	case ContactType::SphereSphere:
+	{
+		Sphere* sphereA = static_cast<Sphere*>(contact.objA);
+		Sphere* sphereB = static_cast<Sphere*>(contact.objB);
+		manifold.normal = contact.distance > 1e-6f ? contact.normal : glm::vec3(0.0f, 1.0f, 0.0f);
+		manifold.penetration = sphereA->GetRadius() + sphereB->GetRadius() - contact.distance;
+		break;
+	}
+	case ContactType::SpherePlane:
+	case ContactType::BoxPlane:
+	case ContactType::SphereHeightfield:
+	case ContactType::BoxHeightfield:
+		// the surface normal points at the body, the solver wants it from the body to the surface
+		manifold.normal = -contact.normal;
+		manifold.penetration = -contact.distance;
+		break;
+	case ContactType::BoxSphere:
+		BoxSphereNormal(*static_cast<Box*>(contact.objA), *static_cast<Sphere*>(contact.objB), manifold.normal, manifold.penetration);
+		break;
+	case ContactType::BoxBox:
+		BoxBoxNormal(*static_cast<Box*>(contact.objA), *static_cast<Box*>(contact.objB), manifold.normal, manifold.penetration);
+		break;
+	default:
+		return false;
+	}
+	manifold.restitution = 0.5f * (Elasticity(contact.objA) + Elasticity(contact.objB));
+
+	// the cache key does not depend on the order the narrowphase saw the pair in
+	if (manifold.objB < manifold.objA)
+	{
+		std::swap(manifold.objA, manifold.objB);
+		manifold.normal = -manifold.normal;
+	}
+	return true;
+}
+
+int ContactSolver::BodySlot(PhysicsObject* object, RigidBodyWorld& world)
+{
+	// slot 0 stands for every immovable body and the world
+	RigidBody* body = object != nullptr ? object->Rigidbody() : nullptr;
+	if (body == nullptr || body->getWorld() != &world || body->isStatic())
+	{
+		return 0;
+	}
+	int index = body->getIndex();
+	if (m_slotOfWorldIndex[index] >= 0)
+	{
+		return m_slotOfWorldIndex[index];
+	}
+
+	// kinematic and sleeping bodies push but are not pushed
+	float mass = world.GetMass(index);
+	bool movable = !body->isKinematic() && !body->isSleeping() && mass > 0.0f;
+	int slot = (int)m_velocities.size();
+	m_slotOfWorldIndex[index] = slot;
+	m_worldIndices.push_back(index);
+	m_velocities.push_back(world.GetVelocity(index));
+	m_startVelocities.push_back(m_velocities.back());
+	m_inverseMasses.push_back(movable ? 1.0f / mass : 0.0f);
+	return slot;
+}
+
+void ContactSolver::Clear()
+{
+	m_manifolds.clear();
+	m_joints.clear();
+	m_colorStart.clear();
+	m_cache.clear();
+	m_nextCache.clear();
+	m_warmStarted = 0;
+}
+
+void ContactSolver::RemoveObject(PhysicsObject* object)
+{
+	// the manifolds and joint rows are rebuilt every step, only the cache outlives it; the order is kept
+	m_cache.erase(std::remove_if(m_cache.begin(), m_cache.end(), [object](const CachedImpulse& entry)
+		{
+			return entry.objA == object || entry.objB == object;
+		}), m_cache.end());
+}
+
+void ContactSolver::GetCache(std::vector<CachedContact>& contacts) const
+{
+	contacts.clear();
+	for (const CachedImpulse& entry : m_cache)
+	{
+		contacts.push_back({ entry.objA, entry.objB, entry.normal, entry.normalImpulse, entry.tangentImpulse });
+	}
+}
+
+void ContactSolver::SetCache(const std::vector<CachedContact>& contacts)
+{
+	m_cache.clear();
+	for (const CachedContact& contact : contacts)
+	{
+		m_cache.push_back({ contact.objA, contact.objB, contact.normal, contact.normalImpulse, contact.tangentImpulse });
+	}
+	SortCache();
+}
+
+const ContactSolver::CachedImpulse* ContactSolver::FindCached(PhysicsObject* objA, PhysicsObject* objB) const
+{
+	auto entry = std::lower_bound(m_cache.begin(), m_cache.end(), objA, [objB](const CachedImpulse& cached, PhysicsObject* key)
+		{
+			return PairLess(cached, key, objB);
+		});
+	if (entry == m_cache.end() || entry->objA != objA || entry->objB != objB)
+	{
+		return nullptr;
+	}
+	return &*entry;
+}
+
+void ContactSolver::SortCache()
+{
+	std::sort(m_cache.begin(), m_cache.end(), [](const CachedImpulse& a, const CachedImpulse& b)
+		{
+			return PairLess(a, b.objA, b.objB);
+		});
+}
+
+void ContactSolver::Color()
+{
+	int numberOfConstraints = (int)(m_manifolds.size() + m_joints.size());
+	m_constraintColors.resize(numberOfConstraints);
+	m_bodyColors.assign(m_velocities.size(), 0);
+	int counts[MaxColors + 1] = {};
+
+	// the first color neither movable body is in yet, immovable bodies do not count
+	for (int constraint = 0; constraint < numberOfConstraints; constraint++)
+	{
+		int bodyA, bodyB;
+		if (constraint < (int)m_manifolds.size())
+		{
+			bodyA = m_manifolds[constraint].bodyA;
+			bodyB = m_manifolds[constraint].bodyB;
+		}
+		else
+		{
+			bodyA = m_joints[constraint - m_manifolds.size()].bodyA;
+			bodyB = m_joints[constraint - m_manifolds.size()].bodyB;
+		}
+		bool movableA = m_inverseMasses[bodyA] > 0.0f;
+		bool movableB = m_inverseMasses[bodyB] > 0.0f;
+		uint64_t used = (movableA ? m_bodyColors[bodyA] : 0) | (movableB ? m_bodyColors[bodyB] : 0);
+		int color = 0;
+		while (color < MaxColors && (used & (1ull << color)) != 0)
+		{
+			color++;
+		}
+		if (color < MaxColors)
+		{
+			if (movableA) m_bodyColors[bodyA] |= 1ull << color;
+			if (movableB) m_bodyColors[bodyB] |= 1ull << color;
+		}
+		m_constraintColors[constraint] = color;
+		counts[color]++;
+	}
+
+	// drop the colors nobody took, then bucket the constraints keeping their order
+	int remap[MaxColors + 1];
+	int numberOfColors = 0;
+	for (int color = 0; color <= MaxColors; color++)
+	{
+		remap[color] = counts[color] > 0 ? numberOfColors++ : -1;
+	}
+	m_overflowColor = remap[MaxColors];
+	m_colorStart.assign(numberOfColors + 1, 0);
+	for (int constraint = 0; constraint < numberOfConstraints; constraint++)
+	{
+		m_constraintColors[constraint] = remap[m_constraintColors[constraint]];
+		m_colorStart[m_constraintColors[constraint] + 1]++;
+	}
+	for (int color = 0; color < numberOfColors; color++)
+	{
+		m_colorStart[color + 1] += m_colorStart[color];
+	}
+	m_colorConstraints.resize(numberOfConstraints);
+	m_colorCursor.assign(m_colorStart.begin(), m_colorStart.end() - 1);
+	for (int constraint = 0; constraint < numberOfConstraints; constraint++)
+	{
+		m_colorConstraints[m_colorCursor[m_constraintColors[constraint]]++] = constraint;
+	}
+}
+
+void ContactSolver::SolveManifold(ContactManifold& manifold, float friction)
+{
+	const glm::vec3& velocityA = m_velocities[manifold.bodyA];
+	const glm::vec3& velocityB = m_velocities[manifold.bodyB];
+
+	// friction first, bounded by the normal impulse of the last iteration
+	float maxFriction = friction * manifold.normalImpulse;
+	glm::vec3 relativeVelocity = velocityB - velocityA;
+	float tangentVelocity1 = glm::dot(relativeVelocity, manifold.tangent1);
+	float tangentVelocity2 = glm::dot(relativeVelocity, manifold.tangent2);
+	float accumulated1 = glm::dot(manifold.tangentImpulse, manifold.tangent1);
+	float accumulated2 = glm::dot(manifold.tangentImpulse, manifold.tangent2);
+	float new1 = glm::clamp(accumulated1 - manifold.normalMass * tangentVelocity1, -maxFriction, maxFriction);
+	float new2 = glm::clamp(accumulated2 - manifold.normalMass * tangentVelocity2, -maxFriction, maxFriction);
+	glm::vec3 frictionImpulse = manifold.tangent1 * (new1 - accumulated1) + manifold.tangent2 * (new2 - accumulated2);
+	manifold.tangentImpulse = manifold.tangent1 * new1 + manifold.tangent2 * new2;
+	ApplyImpulse(manifold.bodyA, -frictionImpulse);
+	ApplyImpulse(manifold.bodyB, frictionImpulse);
+
+	// normal, the accumulated impulse only pushes
+	float normalVelocity = glm::dot(velocityB - velocityA, manifold.normal);
+	float newImpulse = std::max(manifold.normalImpulse + manifold.normalMass * (manifold.bias - normalVelocity), 0.0f);
+	glm::vec3 normalImpulse = manifold.normal * (newImpulse - manifold.normalImpulse);
+	manifold.normalImpulse = newImpulse;
+	ApplyImpulse(manifold.bodyA, -normalImpulse);
+	ApplyImpulse(manifold.bodyB, normalImpulse);
+}
+
+void ContactSolver::SolveJoint(JointConstraint& constraint)
+{
+	// equality rows, the impulse pulls as well as pushes
+	for (int row = 0; row < constraint.numberOfRows; row++)
+	{
+		float velocity = glm::dot(m_velocities[constraint.bodyB] - m_velocities[constraint.bodyA], constraint.direction[row]);
+		float impulse = constraint.mass * (constraint.bias[row] - velocity);
+		constraint.impulse[row] += impulse;
+		ApplyImpulse(constraint.bodyA, -constraint.direction[row] * impulse);
+		ApplyImpulse(constraint.bodyB, constraint.direction[row] * impulse);
+	}
+}
+
+void ContactSolver::SolveRange(int begin, int end, float friction)
+{
+	int numberOfManifolds = (int)m_manifolds.size();
+	for (int slot = begin; slot < end; slot++)
+	{
+		int constraint = m_colorConstraints[slot];
+		if (constraint < numberOfManifolds)
+		{
+			SolveManifold(m_manifolds[constraint], friction);
+		}
+		else
+		{
+			SolveJoint(m_joints[constraint - numberOfManifolds]);
+		}
+	}
+}
+
+void ContactSolver::Solve(const std::vector<Contact>& contacts, const std::vector<Joint*>& joints, RigidBodyWorld& world, float timeStep, const ContactSolverSettings& settings)
+{
+	m_manifolds.clear();
+	m_joints.clear();
+	m_colorStart.clear();
+	m_warmStarted = 0;
+	m_velocities.assign(1, glm::vec3(0.0f));
+	m_startVelocities.assign(1, glm::vec3(0.0f));
+	m_inverseMasses.assign(1, 0.0f);
+	m_worldIndices.assign(1, -1);
+	m_slotOfWorldIndex.assign(world.numberOfBodies(), -1);
+	if (timeStep <= 0.0f)
+	{
+		m_cache.clear();
+		return;
+	}
+	float inverseTimeStep = 1.0f / timeStep;
+
+	// manifolds, warm started from the impulses the same pair ended the last step with
+	m_nextCache.clear();
+	for (const Contact& contact : contacts)
+	{
+		ContactManifold manifold;
+		if (!BuildManifold(contact, manifold))
+		{
+			continue;
+		}
+		manifold.bodyA = BodySlot(manifold.objA, world);
+		manifold.bodyB = BodySlot(manifold.objB, world);
+		float inverseMass = m_inverseMasses[manifold.bodyA] + m_inverseMasses[manifold.bodyB];
+		if (inverseMass <= 0.0f)
+		{
+			continue;
+		}
+		manifold.normalMass = 1.0f / inverseMass;
+
+		if (settings.warmStarting)
+		{
+			const CachedImpulse* cached = FindCached(manifold.objA, manifold.objB);
+			// a pair that turned around is a new contact
+			if (cached != nullptr && glm::dot(cached->normal, manifold.normal) > 0.95f)
+			{
+				manifold.normalImpulse = cached->normalImpulse;
+				manifold.tangentImpulse = cached->tangentImpulse;
+				m_warmStarted++;
+			}
+		}
+
+		// tangent basis of the friction
+		glm::vec3 n = manifold.normal;
+		glm::vec3 axis = std::abs(n.x) < 0.57f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		manifold.tangent1 = glm::normalize(glm::cross(n, axis));
+		manifold.tangent2 = glm::cross(n, manifold.tangent1);
+		// the friction impulse kept from the last step, projected on the new basis
+		manifold.tangentImpulse = manifold.tangent1 * glm::dot(manifold.tangentImpulse, manifold.tangent1) +
+								  manifold.tangent2 * glm::dot(manifold.tangentImpulse, manifold.tangent2);
+
+		// push out of the penetration over a few steps, bounce off fast impacts
+		glm::vec3 relativeVelocity = m_velocities[manifold.bodyB] - m_velocities[manifold.bodyA];
+		float normalVelocity = glm::dot(relativeVelocity, n);
+		manifold.bias = settings.baumgarte * inverseTimeStep * std::max(manifold.penetration - settings.penetrationSlop, 0.0f);
+		if (normalVelocity < -settings.restitutionThreshold)
+		{
+			manifold.bias = std::max(manifold.bias, -manifold.restitution * normalVelocity);
+		}
+		m_manifolds.push_back(manifold);
+	}
+
+	// joints, the rows are rebuilt at the new positions and keep the impulses of the last step
+	for (Joint* joint : joints)
+	{
+		JointConstraint constraint;
+		constraint.joint = joint;
+		constraint.bodyA = BodySlot(joint->getObjectA(), world);
+		constraint.bodyB = BodySlot(joint->getObjectB(), world);
+		float inverseMass = m_inverseMasses[constraint.bodyA] + m_inverseMasses[constraint.bodyB];
+		if (inverseMass <= 0.0f)
+		{
+			continue;
+		}
+		constraint.mass = 1.0f / inverseMass;
+
+		JointRow rows[Joint::MaxRows];
+		constraint.numberOfRows = joint->BuildRows(rows);
+		for (int row = 0; row < constraint.numberOfRows; row++)
+		{
+			constraint.direction[row] = rows[row].direction;
+			constraint.bias[row] = -settings.baumgarte * inverseTimeStep * rows[row].error;
+			constraint.impulse[row] = settings.warmStarting ? joint->m_impulses[row] : 0.0f;
+		}
+		m_joints.push_back(constraint);
+	}
+
+	Color();
+
+	// warm start
+	for (const ContactManifold& manifold : m_manifolds)
+	{
+		glm::vec3 impulse = manifold.normal * manifold.normalImpulse + manifold.tangentImpulse;
+		ApplyImpulse(manifold.bodyA, -impulse);
+		ApplyImpulse(manifold.bodyB, impulse);
+	}
+	for (const JointConstraint& constraint : m_joints)
+	{
+		for (int row = 0; row < constraint.numberOfRows; row++)
+		{
+			ApplyImpulse(constraint.bodyA, -constraint.direction[row] * constraint.impulse[row]);
+			ApplyImpulse(constraint.bodyB, constraint.direction[row] * constraint.impulse[row]);
+		}
+	}
+
+	// velocity iterations, each constraint sees the impulses of the colors before it
+	JobSystem& jobSystem = JobSystem::getInstance();
+	int colors = numberOfColors();
+	for (int iteration = 0; iteration < settings.velocityIterations; iteration++)
+	{
+		for (int color = 0; color < colors; color++)
+		{
+			int begin = m_colorStart[color];
+			int count = m_colorStart[color + 1] - begin;
+			// the overflow color can move a body twice, it always runs here
+			if (count < settings.parallelBatch || color == m_overflowColor || jobSystem.numberOfThreads() == 1)
+			{
+				SolveRange(begin, begin + count, settings.friction);
+				continue;
+			}
+			jobSystem.ParallelFor(count, std::max(settings.parallelBatch / 2, 1), [this, begin, &settings](int rangeBegin, int rangeEnd, int)
+				{
+					SolveRange(begin + rangeBegin, begin + rangeEnd, settings.friction);
+				});
+		}
+	}
+
+	// the body world integrated positions before the contacts were known,
+	// the velocity change is added to this step's move as if it happened first
+	for (int slot = 1; slot < (int)m_velocities.size(); slot++)
+	{
+		if (m_inverseMasses[slot] <= 0.0f)
+		{
+			continue;
+		}
+		int index = m_worldIndices[slot];
+		world.SetVelocity(index, m_velocities[slot]);
+		world.SetPosition(index, world.GetPosition(index) + (m_velocities[slot] - m_startVelocities[slot]) * timeStep);
+	}
+
+	for (const ContactManifold& manifold : m_manifolds)
+	{
+		m_nextCache.push_back({ manifold.objA, manifold.objB, manifold.normal, manifold.normalImpulse, manifold.tangentImpulse });
+	}
+	std::swap(m_cache, m_nextCache);
+	SortCache();
+	for (const JointConstraint& constraint : m_joints)
+	{
+		for (int row = 0; row < constraint.numberOfRows; row++)
+		{
+			constraint.joint->m_impulses[row] = constraint.impulse[row];
+		}
+	}
+}
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+#include "Contact.h"
+#include "Joint.h"
+
+namespace ntn
+{
+	class PhysicsObject;
+	class RigidBodyWorld;
+
+	struct ContactSolverSettings
+	{
+		int velocityIterations = 8;
+		bool warmStarting = true;
+		float friction = 0.5f;
+		float baumgarte = 0.2f;				// fraction of the penetration pushed out per step
+		float penetrationSlop = 0.01f;		// penetration left alone so resting contacts persist
+		float restitutionThreshold = 1.0f;	// slower impacts do not bounce
+		int parallelBatch = 64;				// colors with fewer constraints are solved on the calling thread
+	};
+
+	// Contact between a body pair, kept across steps while the pair touches.
+	// The shapes collide as axis aligned boxes and spheres, so one point per pair carries the whole response
+	// and only linear velocities are solved.
+	struct ContactManifold
+	{
+		PhysicsObject* objA = nullptr;
+		PhysicsObject* objB = nullptr;
+		glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f);	// from A towards B
+		float penetration = 0.0f;
+		float restitution = 0.0f;
+
+		// accumulated impulses, warm started from the last step
+		float normalImpulse = 0.0f;
+		glm::vec3 tangentImpulse = glm::vec3(0.0f);	// friction, kept as a vector so it survives a new tangent basis
+
+		// solver data, rebuilt every step
+		int bodyA = -1;
+		int bodyB = -1;
+		glm::vec3 tangent1 = glm::vec3(0.0f);
+		glm::vec3 tangent2 = glm::vec3(0.0f);
+		float normalMass = 0.0f;
+		float bias = 0.0f;
+	};
+
+	// Rows of a joint in solver form, rebuilt every step. The impulses live in the joint between steps.
+	struct JointConstraint
+	{
+		Joint* joint = nullptr;
+		int numberOfRows = 0;
+		glm::vec3 direction[Joint::MaxRows];
+		float bias[Joint::MaxRows];
+		float impulse[Joint::MaxRows];
+
+		int bodyA = -1;
+		int bodyB = -1;
+		float mass = 0.0f;
+	};
+
+	// Sequential impulse solver: the contacts of a step become manifolds, manifolds of pairs that touched
+	// the step before start from the impulses they ended with, then the velocity constraints of the
+	// manifolds and joints are iterated Gauss-Seidel style. Positions are corrected through the velocities (Baumgarte).
+	// The constraints are colored so that no two of a color move the same body, the constraints of a color
+	// are solved in parallel on the job system and the colors one after the other. The result does not
+	// depend on the number of threads.
+	class ContactSolver
+	{
+	public:
+		void Solve(const std::vector<Contact>& contacts, const std::vector<Joint*>& joints, RigidBodyWorld& world, float timeStep, const ContactSolverSettings& settings);
+		// forget the cached manifolds, objects may have been deleted
+		void Clear();
+		// forget the cached pairs of one object, the others keep warm starting
+		void RemoveObject(PhysicsObject* object);
+
+		int numberOfManifolds() const { return (int)m_manifolds.size(); }
+		int numberOfWarmStarted() const { return m_warmStarted; }
+		int numberOfJoints() const { return (int)m_joints.size(); }
+		int numberOfColors() const { return m_colorStart.empty() ? 0 : (int)m_colorStart.size() - 1; }
+
+		// impulses the pairs of the last step ended with, for snapshots
+		struct CachedContact
+		{
+			PhysicsObject* objA;
+			PhysicsObject* objB;
+			glm::vec3 normal;
+			float normalImpulse;
+			glm::vec3 tangentImpulse;
+		};
+		void GetCache(std::vector<CachedContact>& contacts) const;
+		void SetCache(const std::vector<CachedContact>& contacts);
+
+	private:
+		// accumulated impulses of last step, by body pair
+		struct CachedImpulse
+		{
+			PhysicsObject* objA;
+			PhysicsObject* objB;
+			glm::vec3 normal;
+			float normalImpulse;
+			glm::vec3 tangentImpulse;
+		};
+		static bool PairLess(const CachedImpulse& entry, PhysicsObject* objA, PhysicsObject* objB)
+		{
+			uintptr_t a = (uintptr_t)entry.objA, b = (uintptr_t)objA;
+			return a != b ? a < b : (uintptr_t)entry.objB < (uintptr_t)objB;
+		}
+		const CachedImpulse* FindCached(PhysicsObject* objA, PhysicsObject* objB) const;
+		// order m_cache by pair for FindCached
+		void SortCache();
+
+		// normal and depth of the contact in solver form, false for pairs without a response
+		bool BuildManifold(const Contact& contact, ContactManifold& manifold);
+		int BodySlot(PhysicsObject* object, RigidBodyWorld& world);
+		// greedy coloring of the constraints by the movable bodies they share
+		void Color();
+		void SolveRange(int begin, int end, float friction);
+		void SolveManifold(ContactManifold& manifold, float friction);
+		void SolveJoint(JointConstraint& constraint);
+		void ApplyImpulse(int slot, const glm::vec3& impulse)
+		{
+			// immovable slots are shared by every color, they are only read
+			if (m_inverseMasses[slot] > 0.0f)
+			{
+				m_velocities[slot] += impulse * m_inverseMasses[slot];
+			}
+		}
+
+		std::vector<ContactManifold> m_manifolds;
+		// sorted by pair and refilled every step, both keep their storage from step to step
+		std::vector<CachedImpulse> m_cache;
+		std::vector<CachedImpulse> m_nextCache;
+		int m_warmStarted = 0;
+		std::vector<JointConstraint> m_joints;
+
+		// constraint i is manifold i below m_manifolds.size(), joint i - m_manifolds.size() above,
+		// the constraints of color c are m_colorConstraints[m_colorStart[c], m_colorStart[c + 1])
+		std::vector<int> m_colorStart;
+		std::vector<int> m_colorCursor;
+		std::vector<int> m_colorConstraints;
+		std::vector<int> m_constraintColors;
+		std::vector<uint64_t> m_bodyColors;	// per body slot, colors already moving the body
+		int m_overflowColor = -1;			// constraints that found no free color, -1 when there are none
+
+		// velocities of the bodies in the manifolds, gathered once and scattered back after the iterations
+		std::vector<glm::vec3> m_velocities;
+		std::vector<glm::vec3> m_startVelocities;
+		std::vector<float> m_inverseMasses;
+		std::vector<int> m_worldIndices;
+		std::vector<int> m_slotOfWorldIndex;
+	};
+}
@@ -0,0 +1,118 @@
+#include "ContinuousCollision.h"
+#include "PhysicsObject.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Box.h"
+#include "Heightfield.h"
+
+#include <cmath>
+
+namespace ntn
+{
+
+// entry of the segment start + motion * t, t in [0, 1], into the box, false when it starts inside
+static bool SegmentEntersBox(const glm::vec3& start, const glm::vec3& motion, const AABB& box, float& toi)
+{
+	float entry;
+	if (!box.RayIntersect(start, 1.0f / motion, 1.0f, entry) || entry <= 0.0f)
+	{
+		return false;
+	}
+	toi = entry;
+	return true;
+}
+
+// first time the signed distance to the plane through the origin drops to the shape radius,
+// the plane kernels treat both sides as solid so the side the shape starts on is kept
+static bool SweepPlane(const glm::vec3& start, const glm::vec3& motion, float radius, const glm::vec3& normal, float& toi)
+{
+	float startDistance = glm::dot(start, normal);
+	float endDistance = glm::dot(start + motion, normal);
+	if (startDistance < 0.0f)
+	{
+		startDistance = -startDistance;
+		endDistance = -endDistance;
+	}
+	if (startDistance <= radius || endDistance >= radius)
+	{
+		return false;
+	}
+	toi = (startDistance - radius) / (startDistance - endDistance);
+	return true;
+}
+
+bool ContinuousCollision::SweepSphere(const glm::vec3& start, const glm::vec3& motion, float radius, PhysicsObject* obstacle, float& toi)
+{
+	switch (obstacle->getShapeID())
+	{
+	case SPHERE:
+	{
+		// segment against the obstacle grown by the radius
+		Sphere* sphere = static_cast<Sphere*>(obstacle);
+		glm::vec3 toStart = start - sphere->GetPosition();
+		float totalRadius = sphere->GetRadius() + radius;
+		float a = glm::dot(motion, motion);
+		float b = glm::dot(toStart, motion);
+		float c = glm::dot(toStart, toStart) - totalRadius * totalRadius;
+		if (c <= 0.0f || b >= 0.0f || a <= 0.0f)
+		{
+			return false;
+		}
+		float discriminant = b * b - a * c;
+		if (discriminant < 0.0f)
+		{
+			return false;
+		}
+		float t = (-b - std::sqrt(discriminant)) / a;
+		if (t > 1.0f)
+		{
+			return false;
+		}
+		toi = t;
+		return true;
+	}
+	case BOX:
+	{
+		// the grown box has square corners, the hit can come a little early there
+		Box* box = static_cast<Box*>(obstacle);
+		return SegmentEntersBox(start, motion, AABB::FromCenterExtents(box->GetPosition(), box->GetSize() + radius), toi);
+	}
+	case PLANE:
+		return SweepPlane(start, motion, radius, static_cast<Plane*>(obstacle)->getNormal(), toi);
+	case HEIGHTFIELD:
+		return static_cast<Heightfield*>(obstacle)->SweepBox(start, motion, glm::vec3(radius), toi);
+	default:
+		return false;
+	}
+}
+
+bool ContinuousCollision::SweepBox(const glm::vec3& start, const glm::vec3& motion, const glm::vec3& halfExtents, PhysicsObject* obstacle, float& toi)
+{
+	switch (obstacle->getShapeID())
+	{
+	case SPHERE:
+	{
+		Sphere* sphere = static_cast<Sphere*>(obstacle);
+		return SegmentEntersBox(start, motion, AABB::FromCenterExtents(sphere->GetPosition(), halfExtents + sphere->GetRadius()), toi);
+	}
+	case BOX:
+	{
+		// boxes stay axis aligned, the grown box is exact
+		Box* box = static_cast<Box*>(obstacle);
+		return SegmentEntersBox(start, motion, AABB::FromCenterExtents(box->GetPosition(), box->GetSize() + halfExtents), toi);
+	}
+	case PLANE:
+	{
+		// projection interval radius of the box onto the plane normal
+		glm::vec3 normal = static_cast<Plane*>(obstacle)->getNormal();
+		float radius = glm::dot(halfExtents, glm::abs(normal));
+		return SweepPlane(start, motion, radius, normal, toi);
+	}
+	case HEIGHTFIELD:
+		return static_cast<Heightfield*>(obstacle)->SweepBox(start, motion, halfExtents, toi);
+	default:
+		return false;
+	}
+}
+
+}
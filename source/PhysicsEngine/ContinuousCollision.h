@@ -0,0 +1,18 @@
+#pragma once
+#include "glm/glm.hpp"
+
+namespace ntn
+{
+	class PhysicsObject;
+
+	// Time of impact of a shape swept along its motion of one step, against an obstacle held at its current position.
+	// Spheres and boxes are exact ray casts against the obstacle grown by the moving shape,
+	// heightfields use conservative advancement. toi is the fraction of the motion in [0, 1].
+	// Shapes that already overlap at the start are left to the discrete narrowphase.
+	class ContinuousCollision
+	{
+	public:
+		static bool SweepSphere(const glm::vec3& start, const glm::vec3& motion, float radius, PhysicsObject* obstacle, float& toi);
+		static bool SweepBox(const glm::vec3& start, const glm::vec3& motion, const glm::vec3& halfExtents, PhysicsObject* obstacle, float& toi);
+	};
+}
@@ -0,0 +1,590 @@
+#include "DynamicAABBTree.h"
+#include "PhysicsObject.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+
+namespace ntn
+{
+
+DynamicAABBTree::DynamicAABBTree(float margin, float displacementMultiplier)
+	: m_margin(margin), m_displacementMultiplier(displacementMultiplier)
+{
+}
+
+// sleeping bodies do not move until something wakes them, like static ones they never collide with each other
+static bool IsStaticBody(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && (object->Rigidbody()->isStatic() || object->Rigidbody()->isSleeping());
+}
+
+static bool IsSleepingBody(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && object->Rigidbody()->isSleeping();
+}
+
+/*********************************************************************************************************
+* Node pool
+**********************************************************************************************************/
+int DynamicAABBTree::AllocateNode()
+{
+	if (m_freeList == NULL_NODE)
+	{
+		m_nodes.emplace_back();
+		m_partners.emplace_back();
+		int nodeId = (int)m_nodes.size() - 1;
+		m_nodes[nodeId].height = 0;
+		return nodeId;
+	}
+
+	int nodeId = m_freeList;
+	m_freeList = m_nodes[nodeId].parent;
+	m_nodes[nodeId] = Node();
+	m_nodes[nodeId].height = 0;
+	return nodeId;
+}
+
+void DynamicAABBTree::FreeNode(int nodeId)
+{
+	m_nodes[nodeId] = Node();
+	m_nodes[nodeId].parent = m_freeList;
+	m_partners[nodeId].clear();
+	m_freeList = nodeId;
+}
+
+AABB DynamicAABBTree::FattenBounds(const AABB& bounds, const glm::vec3& displacement) const
+{
+	AABB fat(bounds.min - glm::vec3(m_margin), bounds.max + glm::vec3(m_margin));
+	// stretch the box along the motion so fast bodies are not reinserted every step
+	glm::vec3 predicted = displacement * m_displacementMultiplier;
+	fat.min += glm::min(predicted, glm::vec3(0.0f));
+	fat.max += glm::max(predicted, glm::vec3(0.0f));
+	return fat;
+}
+
+/*********************************************************************************************************
+* Proxies
+**********************************************************************************************************/
+void DynamicAABBTree::Insert(PhysicsObject* object)
+{
+	int leaf = AllocateNode();
+	Node& node = m_nodes[leaf];
+	node.object = object;
+	node.bounds = object->GetWorldBounds();
+	node.fatBounds = FattenBounds(node.bounds, glm::vec3(0.0f));
+	node.isStatic = IsStaticBody(object);
+	object->SetProxyId(leaf);
+
+	InsertLeaf(leaf);
+	m_movedLeaves.push_back(leaf);
+	m_proxyCount++;
+}
+
+void DynamicAABBTree::Remove(PhysicsObject* object)
+{
+	int leaf = object->GetProxyId();
+	if (leaf < 0 || leaf >= (int)m_nodes.size() || m_nodes[leaf].object != object)
+	{
+		return;
+	}
+
+	RemovePairs(leaf);
+	m_movedLeaves.erase(std::remove(m_movedLeaves.begin(), m_movedLeaves.end(), leaf), m_movedLeaves.end());
+
+	RemoveLeaf(leaf);
+	FreeNode(leaf);
+	m_proxyCount--;
+	object->SetProxyId(-1);
+}
+
+void DynamicAABBTree::Clear()
+{
+	for (Node& node : m_nodes)
+	{
+		if (node.height == 0 && node.object != nullptr)
+		{
+			node.object->SetProxyId(-1);
+		}
+	}
+	m_nodes.clear();
+	m_partners.clear();
+	m_movedLeaves.clear();
+	m_pairs.clear();
+	m_pairIds.clear();
+	m_root = NULL_NODE;
+	m_freeList = NULL_NODE;
+	m_proxyCount = 0;
+}
+
+void DynamicAABBTree::Update(float timeStep)
+{
+	// nodes allocated while reinserting are internal nodes, they are skipped
+	for (int leaf = 0; leaf < (int)m_nodes.size(); leaf++)
+	{
+		if (m_nodes[leaf].height != 0 || m_nodes[leaf].object == nullptr)
+		{
+			continue;
+		}
+
+		PhysicsObject* object = m_nodes[leaf].object;
+		// asleep since the last update: nothing moved and its pairs are settled
+		if (m_nodes[leaf].isStatic && IsSleepingBody(object))
+		{
+			continue;
+		}
+		AABB bounds = object->GetWorldBounds();
+		bool isStatic = IsStaticBody(object);
+		m_nodes[leaf].bounds = bounds;
+
+		if (m_nodes[leaf].fatBounds.Contains(bounds) && m_nodes[leaf].isStatic == isStatic)
+		{
+			continue;
+		}
+
+		// left its fat box: reinsert it with a box fitted to its current motion
+		RemoveLeaf(leaf);
+		m_nodes[leaf].fatBounds = FattenBounds(bounds, object->GetVelocity() * timeStep);
+		m_nodes[leaf].isStatic = isStatic;
+		InsertLeaf(leaf);
+		m_movedLeaves.push_back(leaf);
+	}
+}
+
+/*********************************************************************************************************
+* Pairs
+**********************************************************************************************************/
+void DynamicAABBTree::AddPair(int leafA, int leafB)
+{
+	std::vector<int>& partnersA = m_partners[leafA];
+	if (std::find(partnersA.begin(), partnersA.end(), leafB) != partnersA.end())
+	{
+		return;
+	}
+	partnersA.push_back(leafB);
+	m_partners[leafB].push_back(leafA);
+}
+
+void DynamicAABBTree::RemovePairs(int leaf)
+{
+	for (int partner : m_partners[leaf])
+	{
+		std::vector<int>& partnersB = m_partners[partner];
+		partnersB.erase(std::remove(partnersB.begin(), partnersB.end(), leaf), partnersB.end());
+	}
+	m_partners[leaf].clear();
+}
+
+const std::vector<BroadphasePair>& DynamicAABBTree::ComputePairs()
+{
+	// only leaves that got reinserted can start or stop overlapping other fat boxes
+	for (int leaf : m_movedLeaves)
+	{
+		RemovePairs(leaf);
+	}
+
+	for (int leaf : m_movedLeaves)
+	{
+		const AABB fatBounds = m_nodes[leaf].fatBounds;
+		bool isStatic = m_nodes[leaf].isStatic;
+
+		m_stack.clear();
+		if (m_root != NULL_NODE)
+		{
+			m_stack.push_back(m_root);
+		}
+		while (!m_stack.empty())
+		{
+			int nodeId = m_stack.back();
+			m_stack.pop_back();
+
+			const Node& node = m_nodes[nodeId];
+			if (!node.fatBounds.Overlaps(fatBounds))
+			{
+				continue;
+			}
+			if (node.IsLeaf())
+			{
+				// static bodies never collide with each other
+				if (nodeId != leaf && !(isStatic && node.isStatic) && PhysicsObject::CanCollide(m_nodes[leaf].object, node.object))
+				{
+					AddPair(leaf, nodeId);
+				}
+			}
+			else
+			{
+				m_stack.push_back(node.child1);
+				m_stack.push_back(node.child2);
+			}
+		}
+	}
+	m_movedLeaves.clear();
+
+	// persistent pairs overlap on their fat boxes, report the ones touching for real
+	m_pairIds.clear();
+	for (int leaf = 0; leaf < (int)m_nodes.size(); leaf++)
+	{
+		for (int partner : m_partners[leaf])
+		{
+			if (leaf < partner && m_nodes[leaf].bounds.Overlaps(m_nodes[partner].bounds))
+			{
+				m_pairIds.emplace_back(leaf, partner);
+			}
+		}
+	}
+	std::sort(m_pairIds.begin(), m_pairIds.end());
+
+	m_pairs.clear();
+	m_pairs.reserve(m_pairIds.size());
+	for (const auto& pairId : m_pairIds)
+	{
+		m_pairs.push_back({ m_nodes[pairId.first].object, m_nodes[pairId.second].object });
+	}
+	return m_pairs;
+}
+
+/*********************************************************************************************************
+* Queries
+**********************************************************************************************************/
+void DynamicAABBTree::QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results)
+{
+	m_stack.clear();
+	if (m_root != NULL_NODE)
+	{
+		m_stack.push_back(m_root);
+	}
+	while (!m_stack.empty())
+	{
+		int nodeId = m_stack.back();
+		m_stack.pop_back();
+
+		const Node& node = m_nodes[nodeId];
+		if (!node.fatBounds.Overlaps(bounds))
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			if (node.bounds.Overlaps(bounds))
+			{
+				results.push_back(node.object);
+			}
+		}
+		else
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+}
+
+bool DynamicAABBTree::GetBounds(const PhysicsObject* object, AABB& bounds) const
+{
+	int leaf = object->GetProxyId();
+	if (leaf < 0 || leaf >= (int)m_nodes.size() || m_nodes[leaf].object != object)
+	{
+		return false;
+	}
+	bounds = m_nodes[leaf].bounds;
+	return true;
+}
+
+void DynamicAABBTree::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback)
+{
+	glm::vec3 invDirection = 1.0f / direction;
+
+	m_stack.clear();
+	if (m_root != NULL_NODE)
+	{
+		m_stack.push_back(m_root);
+	}
+	while (!m_stack.empty())
+	{
+		int nodeId = m_stack.back();
+		m_stack.pop_back();
+
+		const Node& node = m_nodes[nodeId];
+		float distance;
+		if (!node.fatBounds.RayIntersect(origin, invDirection, maxDistance, distance))
+		{
+			continue;
+		}
+		if (node.IsLeaf())
+		{
+			float value = callback(node.object, origin, direction, maxDistance);
+			if (value == 0.0f)
+			{
+				return;
+			}
+			// clip the ray, farther subtrees get culled by the slab test
+			maxDistance = std::min(maxDistance, value);
+		}
+		else
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+}
+
+/*********************************************************************************************************
+* Tree maintenance
+**********************************************************************************************************/
+void DynamicAABBTree::InsertLeaf(int leaf)
+{
+	if (m_root == NULL_NODE)
+	{
+		m_root = leaf;
+		m_nodes[m_root].parent = NULL_NODE;
+		return;
+	}
+
+	// find the best sibling, cost is the area added to the tree
+	AABB leafBounds = m_nodes[leaf].fatBounds;
+	int index = m_root;
+	while (!m_nodes[index].IsLeaf())
+	{
+		int child1 = m_nodes[index].child1;
+		int child2 = m_nodes[index].child2;
+
+		float area = m_nodes[index].fatBounds.HalfSurfaceArea();
+		float combinedArea = AABB::Union(m_nodes[index].fatBounds, leafBounds).HalfSurfaceArea();
+
+		// cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+		// minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		auto descendCost = [&](int child)
+		{
+			AABB combined = AABB::Union(leafBounds, m_nodes[child].fatBounds);
+			if (m_nodes[child].IsLeaf())
+			{
+				return combined.HalfSurfaceArea() + inheritanceCost;
+			}
+			return combined.HalfSurfaceArea() - m_nodes[child].fatBounds.HalfSurfaceArea() + inheritanceCost;
+		};
+		float cost1 = descendCost(child1);
+		float cost2 = descendCost(child2);
+
+		if (cost < cost1 && cost < cost2)
+		{
+			break;
+		}
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	int sibling = index;
+	int oldParent = m_nodes[sibling].parent;
+	int newParent = AllocateNode();
+	m_nodes[newParent].parent = oldParent;
+	m_nodes[newParent].fatBounds = AABB::Union(leafBounds, m_nodes[sibling].fatBounds);
+	m_nodes[newParent].height = m_nodes[sibling].height + 1;
+	m_nodes[newParent].child1 = sibling;
+	m_nodes[newParent].child2 = leaf;
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	if (oldParent != NULL_NODE)
+	{
+		if (m_nodes[oldParent].child1 == sibling)
+		{
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	// walk back up the tree fixing heights and boxes
+	index = m_nodes[leaf].parent;
+	while (index != NULL_NODE)
+	{
+		index = Balance(index);
+
+		int child1 = m_nodes[index].child1;
+		int child2 = m_nodes[index].child2;
+		m_nodes[index].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+		m_nodes[index].fatBounds = AABB::Union(m_nodes[child1].fatBounds, m_nodes[child2].fatBounds);
+
+		index = m_nodes[index].parent;
+	}
+}
+
+void DynamicAABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == m_root)
+	{
+		m_root = NULL_NODE;
+		return;
+	}
+
+	int parent = m_nodes[leaf].parent;
+	int grandParent = m_nodes[parent].parent;
+	int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	if (grandParent != NULL_NODE)
+	{
+		// destroy parent and connect sibling to grandParent
+		if (m_nodes[grandParent].child1 == parent)
+		{
+			m_nodes[grandParent].child1 = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].child2 = sibling;
+		}
+		m_nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		int index = grandParent;
+		while (index != NULL_NODE)
+		{
+			index = Balance(index);
+
+			int child1 = m_nodes[index].child1;
+			int child2 = m_nodes[index].child2;
+			m_nodes[index].fatBounds = AABB::Union(m_nodes[child1].fatBounds, m_nodes[child2].fatBounds);
+			m_nodes[index].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
+
+			index = m_nodes[index].parent;
+		}
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = NULL_NODE;
+		FreeNode(parent);
+	}
+	m_nodes[leaf].parent = NULL_NODE;
+}
+
+// rotate the subtree at iA if it is imbalanced, returns the new subtree root
+int DynamicAABBTree::Balance(int iA)
+{
+	Node& A = m_nodes[iA];
+	if (A.IsLeaf() || A.height < 2)
+	{
+		return iA;
+	}
+
+	int iB = A.child1;
+	int iC = A.child2;
+	Node& B = m_nodes[iB];
+	Node& C = m_nodes[iC];
+
+	int balance = C.height - B.height;
+
+	// rotate C up
+	if (balance > 1)
+	{
+		int iF = C.child1;
+		int iG = C.child2;
+		Node& F = m_nodes[iF];
+		Node& G = m_nodes[iG];
+
+		// swap A and C
+		C.child1 = iA;
+		C.parent = A.parent;
+		A.parent = iC;
+
+		// A's old parent should point to C
+		if (C.parent != NULL_NODE)
+		{
+			if (m_nodes[C.parent].child1 == iA)
+			{
+				m_nodes[C.parent].child1 = iC;
+			}
+			else
+			{
+				m_nodes[C.parent].child2 = iC;
+			}
+		}
+		else
+		{
+			m_root = iC;
+		}
+
+		if (F.height > G.height)
+		{
+			C.child2 = iF;
+			A.child2 = iG;
+			G.parent = iA;
+			A.fatBounds = AABB::Union(B.fatBounds, G.fatBounds);
+			C.fatBounds = AABB::Union(A.fatBounds, F.fatBounds);
+			A.height = 1 + std::max(B.height, G.height);
+			C.height = 1 + std::max(A.height, F.height);
+		}
+		else
+		{
+			C.child2 = iG;
+			A.child2 = iF;
+			F.parent = iA;
+			A.fatBounds = AABB::Union(B.fatBounds, F.fatBounds);
+			C.fatBounds = AABB::Union(A.fatBounds, G.fatBounds);
+			A.height = 1 + std::max(B.height, F.height);
+			C.height = 1 + std::max(A.height, G.height);
+		}
+		return iC;
+	}
+
+	// rotate B up
+	if (balance < -1)
+	{
+		int iD = B.child1;
+		int iE = B.child2;
+		Node& D = m_nodes[iD];
+		Node& E = m_nodes[iE];
+
+		// swap A and B
+		B.child1 = iA;
+		B.parent = A.parent;
+		A.parent = iB;
+
+		// A's old parent should point to B
+		if (B.parent != NULL_NODE)
+		{
+			if (m_nodes[B.parent].child1 == iA)
+			{
+				m_nodes[B.parent].child1 = iB;
+			}
+			else
+			{
+				m_nodes[B.parent].child2 = iB;
+			}
+		}
+		else
+		{
+			m_root = iB;
+		}
+
+		if (D.height > E.height)
+		{
+			B.child2 = iD;
+			A.child1 = iE;
+			E.parent = iA;
+			A.fatBounds = AABB::Union(C.fatBounds, E.fatBounds);
+			B.fatBounds = AABB::Union(A.fatBounds, D.fatBounds);
+			A.height = 1 + std::max(C.height, E.height);
+			B.height = 1 + std::max(A.height, D.height);
+		}
+		else
+		{
+			B.child2 = iE;
+			A.child1 = iD;
+			D.parent = iA;
+			A.fatBounds = AABB::Union(C.fatBounds, D.fatBounds);
+			B.fatBounds = AABB::Union(A.fatBounds, E.fatBounds);
+			A.height = 1 + std::max(C.height, D.height);
+			B.height = 1 + std::max(A.height, E.height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+}
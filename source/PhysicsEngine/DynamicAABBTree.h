@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+
+#include "Broadphase.h"
+
+namespace ntn
+{
+	// Dynamic bounding volume tree.
+	// Leaves store a fattened box around each body: a body only gets reinserted once it
+	// leaves its fat box, so slow bodies cost a containment test per step. Fast bodies get
+	// a fat box stretched along their velocity. The tree is kept balanced with rotations.
+	// Overlapping leaves are kept as persistent pairs, only moved leaves are queried again.
+	class DynamicAABBTree : public Broadphase
+	{
+	public:
+		DynamicAABBTree(float margin = 0.1f, float displacementMultiplier = 2.0f);
+
+		void Insert(PhysicsObject* object) override;
+		void Remove(PhysicsObject* object) override;
+		void Clear() override;
+
+		void Update(float timeStep) override;
+		const std::vector<BroadphasePair>& ComputePairs() override;
+
+		void QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results) override;
+		bool GetBounds(const PhysicsObject* object, AABB& bounds) const override;
+		void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback) override;
+
+		int numberOfProxies() const override { return m_proxyCount; }
+		std::unique_ptr<Broadphase> Clone() const override { return std::make_unique<DynamicAABBTree>(*this); }
+		int GetHeight() const { return m_root < 0 ? 0 : m_nodes[m_root].height; }
+
+	private:
+		static const int NULL_NODE = -1;
+
+		struct Node
+		{
+			AABB fatBounds;
+			AABB bounds;		// tight bounds, leaves only
+			PhysicsObject* object = nullptr;
+			int parent = NULL_NODE;	// next free node when the node is in the free list
+			int child1 = NULL_NODE;
+			int child2 = NULL_NODE;
+			int height = -1;	// leaf = 0, free node = -1
+			bool isStatic = false;
+
+			bool IsLeaf() const { return child1 == NULL_NODE; }
+		};
+
+		int AllocateNode();
+		void FreeNode(int nodeId);
+
+		void InsertLeaf(int leaf);
+		void RemoveLeaf(int leaf);
+		int Balance(int nodeId);
+
+		AABB FattenBounds(const AABB& bounds, const glm::vec3& displacement) const;
+
+		void AddPair(int leafA, int leafB);
+		void RemovePairs(int leaf);
+
+		std::vector<Node> m_nodes;
+		int m_root = NULL_NODE;
+		int m_freeList = NULL_NODE;
+		int m_proxyCount = 0;
+
+		float m_margin;
+		float m_displacementMultiplier;
+
+		// per leaf list of overlapping leaves
+		std::vector<std::vector<int>> m_partners;
+		std::vector<int> m_movedLeaves;
+		std::vector<int> m_stack;
+
+		std::vector<BroadphasePair> m_pairs;
+		std::vector<std::pair<int, int>> m_pairIds;
+	};
+}
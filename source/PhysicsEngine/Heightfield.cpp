@@ -0,0 +1,534 @@
+#include "Heightfield.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ntn
+{
+
+// closest point of the triangle abc to p, see Real-Time Collision Detection 5.1.5
+static glm::vec3 ClosestPointOnTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	glm::vec3 ab = b - a;
+	glm::vec3 ac = c - a;
+	glm::vec3 ap = p - a;
+	float d1 = glm::dot(ab, ap);
+	float d2 = glm::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+	glm::vec3 bp = p - b;
+	float d3 = glm::dot(ab, bp);
+	float d4 = glm::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return a + ab * (d1 / (d1 - d3));
+
+	glm::vec3 cp = p - c;
+	float d5 = glm::dot(ab, cp);
+	float d6 = glm::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/*********************************************************************************************************
+* HeightfieldBatch
+**********************************************************************************************************/
+void HeightfieldBatch::Clear()
+{
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxZ.clear();
+	hits.clear();
+}
+
+void HeightfieldBatch::Add(const AABB& bounds)
+{
+	minX.push_back(bounds.min.x);
+	minY.push_back(bounds.min.y);
+	minZ.push_back(bounds.min.z);
+	maxX.push_back(bounds.max.x);
+	maxZ.push_back(bounds.max.z);
+}
+
+/*********************************************************************************************************
+* Heightfield
+**********************************************************************************************************/
+Heightfield::Heightfield(glm::vec3 scale) : PhysicsObject(HEIGHTFIELD), m_scale(scale)
+{
+	// heightfields never move, the static body only carries the position
+	m_rigidbody = new RigidBody(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
+	m_rigidbody->setStatic(true);
+}
+
+Heightfield::~Heightfield()
+{
+}
+
+void Heightfield::UpdatePhysics(glm::vec3, float)
+{
+}
+
+void Heightfield::SetHeights(std::vector<float> heights, unsigned int width, unsigned int depth, glm::vec2 origin)
+{
+	m_heightMap = std::move(heights);
+	m_width = width;
+	m_depth = depth;
+	m_origin = origin;
+	UpdateHeightRange();
+}
+
+void Heightfield::UpdateHeightRange()
+{
+	m_minHeight = 0.0f;
+	m_maxHeight = 0.0f;
+	m_maxStepX = 0.0f;
+	m_maxStepZ = 0.0f;
+	if (!HasGrid())
+	{
+		return;
+	}
+
+	auto range = std::minmax_element(m_heightMap.begin(), m_heightMap.begin() + (size_t)m_width * m_depth);
+	m_minHeight = *range.first;
+	m_maxHeight = *range.second;
+	for (unsigned int z = 0; z < m_depth; z++)
+	{
+		for (unsigned int x = 0; x < m_width; x++)
+		{
+			if (x + 1 < m_width)
+			{
+				m_maxStepX = std::max(m_maxStepX, std::abs(Sample(x + 1, z) - Sample(x, z)));
+			}
+			if (z + 1 < m_depth)
+			{
+				m_maxStepZ = std::max(m_maxStepZ, std::abs(Sample(x, z + 1) - Sample(x, z)));
+			}
+		}
+	}
+}
+
+glm::vec3 Heightfield::SamplePoint(int x, int z) const
+{
+	return GetPosition() + m_scale * glm::vec3(m_origin.x + x, Sample(x, z), m_origin.y + z);
+}
+
+void Heightfield::SampleCell(float u, float v, float& height, float& slopeU, float& slopeV) const
+{
+	int cellX = std::min((int)u, (int)m_width - 2);
+	int cellZ = std::min((int)v, (int)m_depth - 2);
+	float fu = u - cellX;
+	float fv = v - cellZ;
+
+	float h00 = Sample(cellX, cellZ);
+	float h10 = Sample(cellX + 1, cellZ);
+	float h01 = Sample(cellX, cellZ + 1);
+	float h11 = Sample(cellX + 1, cellZ + 1);
+	if (fv > fu)
+	{
+		// (x, z), (x, z + 1), (x + 1, z + 1)
+		slopeU = h11 - h01;
+		slopeV = h01 - h00;
+	}
+	else
+	{
+		// (x, z), (x + 1, z + 1), (x + 1, z)
+		slopeU = h10 - h00;
+		slopeV = h11 - h10;
+	}
+	height = h00 + slopeU * fu + slopeV * fv;
+}
+
+bool Heightfield::SampleSurface(float x, float z, float& height, glm::vec3& normal) const
+{
+	if (!HasGrid())
+	{
+		return false;
+	}
+	glm::vec3 position = GetPosition();
+	float u = (x - position.x) / m_scale.x - m_origin.x;
+	float v = (z - position.z) / m_scale.z - m_origin.y;
+	if (u < 0.0f || v < 0.0f || u > m_width - 1 || v > m_depth - 1)
+	{
+		return false;
+	}
+
+	float localHeight, slopeU, slopeV;
+	SampleCell(u, v, localHeight, slopeU, slopeV);
+	height = position.y + localHeight * m_scale.y;
+	normal = glm::normalize(glm::vec3(-slopeU * m_scale.y / m_scale.x, 1.0f, -slopeV * m_scale.y / m_scale.z));
+	return true;
+}
+
+bool Heightfield::CellRange(const AABB& bounds, int& minCellX, int& minCellZ, int& maxCellX, int& maxCellZ) const
+{
+	if (!HasGrid())
+	{
+		return false;
+	}
+	glm::vec3 position = GetPosition();
+	if (bounds.min.y > position.y + m_maxHeight * m_scale.y)
+	{
+		return false;
+	}
+	float u0 = (bounds.min.x - position.x) / m_scale.x - m_origin.x;
+	float u1 = (bounds.max.x - position.x) / m_scale.x - m_origin.x;
+	float v0 = (bounds.min.z - position.z) / m_scale.z - m_origin.y;
+	float v1 = (bounds.max.z - position.z) / m_scale.z - m_origin.y;
+	if (u1 < 0.0f || v1 < 0.0f || u0 > m_width - 1 || v0 > m_depth - 1)
+	{
+		return false;
+	}
+	minCellX = std::max(0, (int)std::floor(u0));
+	minCellZ = std::max(0, (int)std::floor(v0));
+	maxCellX = std::min((int)m_width - 2, (int)std::floor(u1));
+	maxCellZ = std::min((int)m_depth - 2, (int)std::floor(v1));
+	return true;
+}
+
+bool Heightfield::SphereContact(const glm::vec3& center, float radius, glm::vec3& normal, float& distance) const
+{
+	int minCellX, minCellZ, maxCellX, maxCellZ;
+	if (!CellRange(AABB::FromCenterExtents(center, glm::vec3(radius)), minCellX, minCellZ, maxCellX, maxCellZ))
+	{
+		return false;
+	}
+
+	// center below the surface, the closest triangle could push it further down
+	float surfaceHeight = 0.0f;
+	glm::vec3 surfaceNormal(0.0f, 1.0f, 0.0f);
+	if (SampleSurface(center.x, center.z, surfaceHeight, surfaceNormal) && center.y < surfaceHeight)
+	{
+		normal = surfaceNormal;
+		distance = (center.y - surfaceHeight) * surfaceNormal.y - radius;
+		return true;
+	}
+
+	// closest point on the triangles of the cells under the sphere
+	float closestDistance2 = radius * radius;
+	glm::vec3 closestPoint = center;
+	bool hit = false;
+	for (int z = minCellZ; z <= maxCellZ; z++)
+	{
+		for (int x = minCellX; x <= maxCellX; x++)
+		{
+			glm::vec3 a = SamplePoint(x, z);
+			glm::vec3 b = SamplePoint(x, z + 1);
+			glm::vec3 c = SamplePoint(x + 1, z + 1);
+			glm::vec3 d = SamplePoint(x + 1, z);
+			glm::vec3 points[2] = { ClosestPointOnTriangle(center, a, b, c), ClosestPointOnTriangle(center, a, c, d) };
+			for (const glm::vec3& point : points)
+			{
+				glm::vec3 offset = center - point;
+				float distance2 = glm::dot(offset, offset);
+				if (distance2 < closestDistance2)
+				{
+					closestDistance2 = distance2;
+					closestPoint = point;
+					hit = true;
+				}
+			}
+		}
+	}
+	if (!hit)
+	{
+		return false;
+	}
+
+	float closestDistance = std::sqrt(closestDistance2);
+	normal = closestDistance > 1e-6f ? (center - closestPoint) / closestDistance : surfaceNormal;
+	distance = closestDistance - radius;
+	return true;
+}
+
+bool Heightfield::HighestPoint(const AABB& bounds, float& height, glm::vec3& normal) const
+{
+	int minCellX, minCellZ, maxCellX, maxCellZ;
+	if (!CellRange(bounds, minCellX, minCellZ, maxCellX, maxCellZ))
+	{
+		return false;
+	}
+
+	// the surface is planar per triangle, so its highest point over the footprint is a vertex of the footprint
+	// cut by the cells: a sample inside it, a corner, or where an edge crosses a grid line or a cell diagonal
+	glm::vec3 position = GetPosition();
+	float u0 = std::max(0.0f, (bounds.min.x - position.x) / m_scale.x - m_origin.x);
+	float u1 = std::min((float)(m_width - 1), (bounds.max.x - position.x) / m_scale.x - m_origin.x);
+	float v0 = std::max(0.0f, (bounds.min.z - position.z) / m_scale.z - m_origin.y);
+	float v1 = std::min((float)(m_depth - 1), (bounds.max.z - position.z) / m_scale.z - m_origin.y);
+	bool found = false;
+	auto testPoint = [&](float u, float v)
+	{
+		float localHeight, slopeU, slopeV;
+		SampleCell(std::clamp(u, u0, u1), std::clamp(v, v0, v1), localHeight, slopeU, slopeV);
+		float sampleHeight = position.y + localHeight * m_scale.y;
+		if (!found || sampleHeight > height)
+		{
+			height = sampleHeight;
+			normal = glm::normalize(glm::vec3(-slopeU * m_scale.y / m_scale.x, 1.0f, -slopeV * m_scale.y / m_scale.z));
+			found = true;
+		}
+	};
+
+	for (float z = std::ceil(v0); z <= v1; z++)
+	{
+		for (float x = std::ceil(u0); x <= u1; x++)
+		{
+			testPoint(x, z);
+		}
+	}
+	// the diagonals run from (x, z) to (x + 1, z + 1), u - v is a whole number on them
+	for (float v : { v0, v1 })
+	{
+		for (float x = std::ceil(u0); x <= u1; x++)
+		{
+			testPoint(x, v);
+		}
+		for (float offset = std::ceil(u0 - v); offset <= u1 - v; offset++)
+		{
+			testPoint(v + offset, v);
+		}
+	}
+	for (float u : { u0, u1 })
+	{
+		for (float z = std::ceil(v0); z <= v1; z++)
+		{
+			testPoint(u, z);
+		}
+		for (float offset = std::ceil(u - v1); offset <= u - v0; offset++)
+		{
+			testPoint(u, u - offset);
+		}
+	}
+	testPoint(u0, v0);
+	testPoint(u1, v0);
+	testPoint(u0, v1);
+	testPoint(u1, v1);
+	return found;
+}
+
+bool Heightfield::BoxContact(const glm::vec3& center, const glm::vec3& halfExtents, glm::vec3& normal, float& distance) const
+{
+	AABB bounds = AABB::FromCenterExtents(center, halfExtents);
+	float height;
+	if (!HighestPoint(bounds, height, normal) || height <= bounds.min.y)
+	{
+		return false;
+	}
+	distance = -(height - bounds.min.y) * normal.y;
+	return true;
+}
+
+bool Heightfield::SweepBox(const glm::vec3& start, const glm::vec3& motion, const glm::vec3& halfExtents, float& toi) const
+{
+	if (!HasGrid())
+	{
+		return false;
+	}
+	// how fast the surface under the footprint can rise while the box slides over it
+	float riseX = m_maxStepX * m_scale.y / m_scale.x;
+	float riseZ = m_maxStepZ * m_scale.y / m_scale.z;
+	float closingSpeed = -motion.y + std::abs(motion.x) * riseX + std::abs(motion.z) * riseZ;
+	if (closingSpeed <= 0.0f)
+	{
+		return false;
+	}
+
+	// nothing is hit before the box enters the bounds of the samples
+	AABB gridBounds = GridBounds();
+	AABB grown(gridBounds.min - halfExtents, gridBounds.max + halfExtents);
+	float t;
+	if (!grown.RayIntersect(start, 1.0f / motion, 1.0f, t))
+	{
+		return false;
+	}
+
+	// every step moves the box by less than the gap that is left, it cannot pass through the surface
+	const float tolerance = 0.01f * halfExtents.y;
+	for (int i = 0; i < 32 && t <= 1.0f; i++)
+	{
+		AABB bounds = AABB::FromCenterExtents(start + motion * t, halfExtents);
+		float height;
+		glm::vec3 normal;
+		float gap;
+		if (HighestPoint(bounds, height, normal))
+		{
+			gap = bounds.min.y - height;
+		}
+		else if (bounds.min.y > gridBounds.max.y)
+		{
+			gap = bounds.min.y - gridBounds.max.y;
+		}
+		else
+		{
+			// left the grid sideways
+			return false;
+		}
+		if (gap <= tolerance)
+		{
+			// touching at the start is the discrete narrowphase's job
+			if (t <= 0.0f)
+			{
+				return false;
+			}
+			toi = t;
+			return true;
+		}
+		t += gap / closingSpeed;
+	}
+	return false;
+}
+
+void Heightfield::CullBatch(HeightfieldBatch& batch) const
+{
+	int count = batch.size();
+	batch.hits.assign(count, 0);
+	if (!HasGrid())
+	{
+		return;
+	}
+
+	// everything in grid units so the loop body is plain arithmetic on the batch arrays
+	glm::vec3 position = GetPosition();
+	const float invScaleX = 1.0f / m_scale.x;
+	const float invScaleY = 1.0f / m_scale.y;
+	const float invScaleZ = 1.0f / m_scale.z;
+	const float offsetU = -position.x * invScaleX - m_origin.x;
+	const float offsetV = -position.z * invScaleZ - m_origin.y;
+	const float maxU = (float)(m_width - 1);
+	const float maxV = (float)(m_depth - 1);
+	const int width = (int)m_width;
+	const int lastCellX = (int)m_width - 2;
+	const int lastCellZ = (int)m_depth - 2;
+	const float maxStepX = m_maxStepX;
+	const float maxStepZ = m_maxStepZ;
+	const float* heights = m_heightMap.data();
+	const float* minX = batch.minX.data();
+	const float* minY = batch.minY.data();
+	const float* minZ = batch.minZ.data();
+	const float* maxX = batch.maxX.data();
+	const float* maxZ = batch.maxZ.data();
+	uint8_t* hits = batch.hits.data();
+
+	for (int i = 0; i < count; i++)
+	{
+		float u0 = minX[i] * invScaleX + offsetU;
+		float u1 = maxX[i] * invScaleX + offsetU;
+		float v0 = minZ[i] * invScaleZ + offsetV;
+		float v1 = maxZ[i] * invScaleZ + offsetV;
+		float bottom = (minY[i] - position.y) * invScaleY;
+
+		// height under the center of the footprint, clamped onto the grid
+		float u = std::min(std::max(0.5f * (u0 + u1), 0.0f), maxU);
+		float v = std::min(std::max(0.5f * (v0 + v1), 0.0f), maxV);
+		int cellX = std::min((int)u, lastCellX);
+		int cellZ = std::min((int)v, lastCellZ);
+		float fu = u - cellX;
+		float fv = v - cellZ;
+		int sample = cellZ * width + cellX;
+		float h00 = heights[sample];
+		float h10 = heights[sample + 1];
+		float h01 = heights[sample + width];
+		float h11 = heights[sample + width + 1];
+		// same triangles as SampleCell, selects instead of branches
+		bool upper = fv > fu;
+		float slopeU = upper ? h11 - h01 : h10 - h00;
+		float slopeV = upper ? h01 - h00 : h11 - h10;
+		float height = h00 + slopeU * fu + slopeV * fv;
+
+		// the surface cannot climb faster than the steepest steps of the grid
+		float reachU = std::max(u - u0, u1 - u);
+		float reachV = std::max(v - v0, v1 - v);
+		float highest = height + maxStepX * reachU + maxStepZ * reachV;
+
+		bool overlaps = u1 >= 0.0f && v1 >= 0.0f && u0 <= maxU && v0 <= maxV;
+		hits[i] = (overlaps && bottom <= highest) ? 1 : 0;
+	}
+}
+
+AABB Heightfield::GetWorldBounds()
+{
+	if (!HasGrid())
+	{
+		glm::vec3 position = GetPosition();
+		return AABB(position, position);
+	}
+	return GridBounds();
+}
+
+AABB Heightfield::GridBounds() const
+{
+	glm::vec3 position = GetPosition();
+	glm::vec3 corner0 = position + m_scale * glm::vec3(m_origin.x, m_minHeight, m_origin.y);
+	glm::vec3 corner1 = position + m_scale * glm::vec3(m_origin.x + m_width - 1, m_maxHeight, m_origin.y + m_depth - 1);
+	return AABB(glm::min(corner0, corner1), glm::max(corner0, corner1));
+}
+
+bool Heightfield::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance)
+{
+	AABB bounds = GetWorldBounds();
+	glm::vec3 invDirection = 1.0f / direction;
+	float enter;
+	if (!HasGrid() || !bounds.RayIntersect(origin, invDirection, maxDistance, enter))
+	{
+		return false;
+	}
+	glm::vec3 t0 = (bounds.min - origin) * invDirection;
+	glm::vec3 t1 = (bounds.max - origin) * invDirection;
+	glm::vec3 tFar = glm::max(t0, t1);
+	float exit = std::min(std::min(std::min(tFar.x, tFar.y), tFar.z), maxDistance);
+
+	// height of the ray above the surface, positive outside the grid
+	auto gap = [&](float t)
+	{
+		glm::vec3 point = origin + direction * t;
+		float height;
+		glm::vec3 normal;
+		return SampleSurface(point.x, point.z, height, normal) ? point.y - height : 1.0f;
+	};
+
+	// march at half a cell, then bisect the step that crossed the surface
+	float step = 0.5f * std::min(m_scale.x, m_scale.z);
+	float previous = enter;
+	if (gap(previous) <= 0.0f)
+	{
+		distance = previous;
+		return true;
+	}
+	for (float t = enter + step; previous < exit; t += step)
+	{
+		float current = std::min(t, exit);
+		if (gap(current) <= 0.0f)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				float middle = 0.5f * (previous + current);
+				if (gap(middle) <= 0.0f)
+				{
+					current = middle;
+				}
+				else
+				{
+					previous = middle;
+				}
+			}
+			distance = current;
+			return true;
+		}
+		previous = current;
+	}
+	return false;
+}
+
+}
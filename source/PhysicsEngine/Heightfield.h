@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "PhysicsObject.h"
+
+namespace ntn
+{
+
+// world bounds of many bodies tested against one heightfield, one array per coordinate
+struct HeightfieldBatch
+{
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxZ;
+	std::vector<uint8_t> hits;	// filled by Heightfield::CullBatch
+
+	void Clear();
+	void Add(const AABB& bounds);
+	int size() const { return (int)minX.size(); }
+};
+
+// Static grid of height samples the bodies collide with, no triangle mesh is built.
+// Sample (x, z) sits at position + scale * (origin.x + x, height, origin.y + z), the samples are stored row by row (z major).
+// Each cell is split along its (x, z) - (x + 1, z + 1) diagonal, the same triangles the terrain mesh draws.
+class Heightfield : public PhysicsObject
+{
+public:
+	Heightfield(glm::vec3 scale = glm::vec3(1.0f));
+	virtual ~Heightfield();
+
+	virtual void UpdatePhysics(glm::vec3 gravity, float timeStep);
+
+	void SetHeights(std::vector<float> heights, unsigned int width, unsigned int depth, glm::vec2 origin);
+
+	inline void SetScale(const glm::vec3& newScale) { m_scale = newScale; }
+	inline glm::vec3 GetScale() const { return m_scale; }
+
+	inline unsigned int getWidth() const { return m_width; }
+	inline unsigned int getDepth() const { return m_depth; }
+	float getElasticity() { return m_elasticity; }
+	void setElasticity(float a_elasticity) { m_elasticity = a_elasticity; }
+
+	// world height and normal of the surface, false outside the grid
+	bool SampleSurface(float x, float z, float& height, glm::vec3& normal) const;
+
+	// deepest point of the shape under the surface, distance is negative along the normal
+	bool SphereContact(const glm::vec3& center, float radius, glm::vec3& normal, float& distance) const;
+	bool BoxContact(const glm::vec3& center, const glm::vec3& halfExtents, glm::vec3& normal, float& distance) const;
+	// conservative advancement of a box along motion, toi is the fraction of the motion where it reaches the surface
+	bool SweepBox(const glm::vec3& start, const glm::vec3& motion, const glm::vec3& halfExtents, float& toi) const;
+
+	// conservative test of a whole batch, a body without hit is above every sample under its bounds
+	void CullBatch(HeightfieldBatch& batch) const;
+
+	AABB GetWorldBounds() override;
+	bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) override;
+
+protected:
+	// height range and steepest steps, call after m_heightMap changed
+	void UpdateHeightRange();
+
+	// cells under the world bounds, false when they miss the grid
+	bool CellRange(const AABB& bounds, int& minCellX, int& minCellZ, int& maxCellX, int& maxCellZ) const;
+	// local height and slopes of the triangle under (u, v), in cell units
+	void SampleCell(float u, float v, float& height, float& slopeU, float& slopeV) const;
+	glm::vec3 SamplePoint(int x, int z) const;
+	// world bounds of the samples, only meaningful with a grid
+	AABB GridBounds() const;
+	// highest surface point under the footprint of the bounds
+	bool HighestPoint(const AABB& bounds, float& height, glm::vec3& normal) const;
+
+	// fewer than 2x2 samples or a short m_heightMap collide with nothing
+	bool HasGrid() const { return m_width >= 2 && m_depth >= 2 && m_heightMap.size() >= (size_t)m_width * m_depth; }
+	float Sample(int x, int z) const { return m_heightMap[z * m_width + x]; }
+
+	glm::vec3 m_scale = glm::vec3(1.0f);
+	glm::vec2 m_origin = glm::vec2(0.0f);
+
+	unsigned int m_width = 0; //x-axis
+	unsigned int m_depth = 0; //z-axis
+	std::vector<float> m_heightMap;
+
+	float m_minHeight = 0.0f;
+	float m_maxHeight = 0.0f;
+	// largest height difference between neighbouring samples, bounds the surface around a point
+	float m_maxStepX = 0.0f;
+	float m_maxStepZ = 0.0f;
+	float m_elasticity = 0.7f;
+};
+
+}
@@ -0,0 +1,81 @@
+#include "IslandGraph.h"
+
+#include <algorithm>
+
+namespace ntn
+{
+
+void IslandGraph::Reset(int numberOfBodies)
+{
+	m_parent.resize(numberOfBodies);
+	m_size.assign(numberOfBodies, 1);
+	for (int i = 0; i < numberOfBodies; i++)
+	{
+		m_parent[i] = i;
+	}
+	m_islandStart.assign(1, 0);
+	m_islandBodies.clear();
+}
+
+int IslandGraph::Find(int body)
+{
+	// path halving keeps the trees flat
+	while (m_parent[body] != body)
+	{
+		m_parent[body] = m_parent[m_parent[body]];
+		body = m_parent[body];
+	}
+	return body;
+}
+
+void IslandGraph::Link(int bodyA, int bodyB)
+{
+	int rootA = Find(bodyA);
+	int rootB = Find(bodyB);
+	if (rootA == rootB)
+	{
+		return;
+	}
+	// smaller tree below the bigger one
+	if (m_size[rootA] < m_size[rootB])
+	{
+		std::swap(rootA, rootB);
+	}
+	m_parent[rootB] = rootA;
+	m_size[rootA] += m_size[rootB];
+}
+
+void IslandGraph::Build()
+{
+	int numberOfBodies = (int)m_parent.size();
+
+	// one island per root, numbered in body order so the result is stable
+	m_islandOf.assign(numberOfBodies, -1);
+	m_islandStart.assign(1, 0);
+	for (int body = 0; body < numberOfBodies; body++)
+	{
+		int root = Find(body);
+		if (m_islandOf[root] < 0)
+		{
+			m_islandOf[root] = (int)m_islandStart.size() - 1;
+			m_islandStart.push_back(0);
+		}
+	}
+
+	// counting sort of the bodies by island
+	for (int body = 0; body < numberOfBodies; body++)
+	{
+		m_islandStart[m_islandOf[Find(body)] + 1]++;
+	}
+	for (int island = 1; island < (int)m_islandStart.size(); island++)
+	{
+		m_islandStart[island] += m_islandStart[island - 1];
+	}
+	m_cursor.assign(m_islandStart.begin(), m_islandStart.end() - 1);
+	m_islandBodies.resize(numberOfBodies);
+	for (int body = 0; body < numberOfBodies; body++)
+	{
+		m_islandBodies[m_cursor[m_islandOf[Find(body)]]++] = body;
+	}
+}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+
+namespace ntn
+{
+	// Bodies linked by contacts, grouped with a union find.
+	// Rebuilt every step over the awake bodies of the RigidBodyWorld, static bodies are never linked
+	// so a floor does not merge everything lying on it into one island.
+	class IslandGraph
+	{
+	public:
+		void Reset(int numberOfBodies);
+		void Link(int bodyA, int bodyB);
+		// group the bodies by island, call once every link is in
+		void Build();
+
+		int numberOfIslands() const { return (int)m_islandStart.size() - 1; }
+		// bodies of an island are m_islandBodies[begin, end)
+		int IslandBegin(int island) const { return m_islandStart[island]; }
+		int IslandEnd(int island) const { return m_islandStart[island + 1]; }
+		int IslandBody(int slot) const { return m_islandBodies[slot]; }
+
+	private:
+		int Find(int body);
+
+		std::vector<int> m_parent;
+		std::vector<int> m_size;
+		std::vector<int> m_islandOf;
+		std::vector<int> m_islandStart;
+		std::vector<int> m_islandBodies;
+		std::vector<int> m_cursor;
+	};
+}
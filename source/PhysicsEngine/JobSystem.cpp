@@ -0,0 +1,132 @@
+#include "JobSystem.h"
+#include "AllocationCounter.h"
+
+#include <algorithm>
+
+namespace ntn
+{
+
+static thread_local bool t_insideJob = false;
+static thread_local int t_threadIndex = 0;
+
+JobSystem& JobSystem::getInstance()
+{
+	static JobSystem instance;
+	return instance;
+}
+
+JobSystem::JobSystem()
+{
+	int hardwareThreads = (int)std::thread::hardware_concurrency();
+	int workerCount = std::max(hardwareThreads - 1, 0);
+	for (int i = 0; i < workerCount; i++)
+	{
+		m_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+	}
+	m_threadCount = workerCount + 1;
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wakeCondition.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::setNumberOfThreads(int count)
+{
+	std::lock_guard<std::mutex> dispatchLock(m_dispatchMutex);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_threadCount = std::clamp(count, 1, maxThreads());
+}
+
+void JobSystem::ParallelFor(int count, int grainSize, const RangeJob& job)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	grainSize = std::max(grainSize, 1);
+
+	// not worth waking the workers
+	if (t_insideJob || m_threadCount == 1 || count <= grainSize)
+	{
+		job(0, count, t_threadIndex);
+		return;
+	}
+
+	std::lock_guard<std::mutex> dispatchLock(m_dispatchMutex);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = &job;
+		m_count = count;
+		m_grainSize = grainSize;
+		m_nextRange = 0;
+		m_pendingWorkers = m_threadCount - 1;
+		m_generation++;
+	}
+	m_wakeCondition.notify_all();
+
+	t_insideJob = true;
+	RunRanges(0);
+	t_insideJob = false;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this] { return m_pendingWorkers == 0; });
+	m_job = nullptr;
+}
+
+void JobSystem::RunRanges(int threadIndex)
+{
+	// ranges are grabbed on demand so uneven ranges balance out
+	for (;;)
+	{
+		int begin = m_nextRange.fetch_add(m_grainSize);
+		if (begin >= m_count)
+		{
+			break;
+		}
+		(*m_job)(begin, std::min(begin + m_grainSize, m_count), threadIndex);
+	}
+}
+
+void JobSystem::WorkerLoop(int threadIndex)
+{
+	t_insideJob = true;
+	t_threadIndex = threadIndex;
+	// workers only run jobs, what they allocate shows in the profile of the step that dispatched them
+	AllocationCounter::CountThisThread(true);
+	uint64_t seenGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wakeCondition.wait(lock, [&] { return m_quit || m_generation != seenGeneration; });
+			if (m_quit)
+			{
+				return;
+			}
+			seenGeneration = m_generation;
+			// threads above the active count sit this one out
+			if (threadIndex >= m_threadCount)
+			{
+				continue;
+			}
+		}
+
+		RunRanges(threadIndex);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_pendingWorkers == 0)
+		{
+			m_doneCondition.notify_one();
+		}
+	}
+}
+}
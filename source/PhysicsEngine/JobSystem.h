@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <cstdint>
+
+namespace ntn
+{
+	// called with a [begin, end) range and the index of the thread running it (0 = calling thread)
+	typedef std::function<void(int begin, int end, int threadIndex)> RangeJob;
+
+	// Small pool of worker threads for data parallel loops.
+	// The calling thread takes part in the work, so one thread means everything runs inline.
+	class JobSystem
+	{
+	public:
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		static JobSystem& getInstance();
+
+		// split [0, count) in ranges of grainSize and block until every range is done,
+		// nested calls from inside a job run inline
+		void ParallelFor(int count, int grainSize, const RangeJob& job);
+
+		// threads taking part in ParallelFor, per thread buffers must be sized with this
+		int numberOfThreads() const { return m_threadCount; }
+		int maxThreads() const { return (int)m_workers.size() + 1; }
+		void setNumberOfThreads(int count);
+
+	private:
+		JobSystem();
+		~JobSystem();
+
+		void WorkerLoop(int threadIndex);
+		void RunRanges(int threadIndex);
+
+		std::vector<std::thread> m_workers;
+		int m_threadCount = 1;
+
+		std::mutex m_dispatchMutex;	// one ParallelFor at a time
+		std::mutex m_mutex;
+		std::condition_variable m_wakeCondition;
+		std::condition_variable m_doneCondition;
+
+		const RangeJob* m_job = nullptr;
+		int m_count = 0;
+		int m_grainSize = 1;
+		std::atomic<int> m_nextRange{ 0 };
+		int m_pendingWorkers = 0;
+		uint64_t m_generation = 0;
+		bool m_quit = false;
+	};
+}
@@ -0,0 +1,72 @@
+#include "Joint.h"
+
+#include <cmath>
+
+namespace ntn
+{
+
+static glm::vec3 CenterOf(PhysicsObject* object)
+{
+	return object != nullptr ? object->GetPosition() : glm::vec3(0.0f);
+}
+
+Joint::Joint(JointType type, PhysicsObject* objA, PhysicsObject* objB, glm::vec3 pivot, glm::vec3 axis)
+{
+	m_shapeID = JOINT;
+	m_type = type;
+	m_objA = objA;
+	m_objB = objB;
+	// a rod hangs from the center of A
+	m_localPivot = type == JointType::Distance ? glm::vec3(0.0f) : pivot - CenterOf(objA);
+	float axisLength = glm::length(axis);
+	m_axis = axisLength > 1e-6f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+	glm::vec3 offset = CenterOf(objB) - getPivot();
+	if (type == JointType::Hinge)
+	{
+		m_axialOffset = glm::dot(offset, m_axis);
+		offset -= m_axis * m_axialOffset;
+	}
+	m_length = glm::length(offset);
+}
+
+Joint::~Joint()
+{
+}
+
+void Joint::UpdatePhysics(glm::vec3, float)
+{
+}
+
+bool Joint::RayCast(const glm::vec3&, const glm::vec3&, float, float&)
+{
+	return false;
+}
+
+glm::vec3 Joint::getPivot() const
+{
+	return CenterOf(m_objA) + m_localPivot;
+}
+
+int Joint::BuildRows(JointRow* rows) const
+{
+	glm::vec3 offset = CenterOf(m_objB) - getPivot();
+	int row = 0;
+	if (m_type == JointType::Hinge)
+	{
+		// B stays in the plane through the pivot across the axis
+		float axial = glm::dot(offset, m_axis);
+		rows[row].direction = m_axis;
+		rows[row].error = axial - m_axialOffset;
+		row++;
+		offset -= m_axis * axial;
+	}
+
+	// and at its distance from the pivot
+	float distance = glm::length(offset);
+	rows[row].direction = distance > 1e-6f ? offset / distance : glm::vec3(0.0f, 1.0f, 0.0f);
+	rows[row].error = distance - m_length;
+	return row + 1;
+}
+
+}
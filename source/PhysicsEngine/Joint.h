@@ -0,0 +1,67 @@
+#pragma once
+
+#include "PhysicsObject.h"
+#include "ObjectPool.h"
+
+namespace ntn
+{
+
+enum class JointType
+{
+	Distance = 0,	// rod between the two body centers
+	BallSocket = 1,	// B swings on a sphere around a pivot carried by A
+	Hinge = 2		// B swings on a circle around the axis through the pivot
+};
+
+// one velocity constraint of a joint, the velocity of B relative to A along direction is driven to remove error
+struct JointRow
+{
+	glm::vec3 direction = glm::vec3(0.0f, 1.0f, 0.0f);
+	float error = 0.0f;
+};
+
+// Constraint between two rigid bodies, solved together with the contacts by the ContactSolver.
+// The bodies do not rotate, so a joint holds where the center of B sits relative to A: the pivot keeps
+// its offset from A and the rest lengths come from the positions at creation.
+// Without objA the pivot is fixed in the world. Remove the joints of a body before the body.
+class Joint : public PhysicsObject
+{
+public:
+	static const int MaxRows = 2;
+
+	// pivot is only used by the ball socket and the hinge, axis only by the hinge
+	Joint(JointType type, PhysicsObject* objA, PhysicsObject* objB, glm::vec3 pivot = glm::vec3(0.0f), glm::vec3 axis = glm::vec3(0.0f, 0.0f, 1.0f));
+	virtual ~Joint();
+
+	// joints are allocated from ObjectPool<Joint>
+	static void* operator new(size_t size) { return ObjectPool<Joint>::Allocate(size); }
+	static void operator delete(void* pointer, size_t size) { ObjectPool<Joint>::Free(pointer, size); }
+
+	virtual void UpdatePhysics(glm::vec3 gravity, float timeStep);
+	bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance) override;
+
+	JointType getType() const { return m_type; }
+	PhysicsObject* getObjectA() const { return m_objA; }
+	PhysicsObject* getObjectB() const { return m_objB; }
+	glm::vec3 getPivot() const;
+	float getLength() const { return m_length; }
+	void setLength(float length) { m_length = length; }
+
+	int numberOfRows() const { return m_type == JointType::Hinge ? 2 : 1; }
+	// rows at the current positions, returns numberOfRows()
+	int BuildRows(JointRow* rows) const;
+
+	// accumulated impulses of the rows, warm started from the last step
+	float m_impulses[MaxRows] = { 0.0f, 0.0f };
+
+protected:
+	JointType m_type = JointType::Distance;
+	PhysicsObject* m_objA = nullptr;
+	PhysicsObject* m_objB = nullptr;
+	glm::vec3 m_localPivot = glm::vec3(0.0f);	// from the center of A, world space without A
+	glm::vec3 m_axis = glm::vec3(0.0f, 0.0f, 1.0f);
+	float m_length = 0.0f;		// from the pivot to B, in the plane of the axis for the hinge
+	float m_axialOffset = 0.0f;	// hinge only, height of B along the axis
+};
+
+}
@@ -0,0 +1,720 @@
+#include "Narrowphase.h"
+#include "PhysicsObject.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "Box.h"
+#include "Heightfield.h"
+#include "Simd.h"
+
+#include <array>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+namespace ntn
+{
+
+typedef bool(*PairFn)(PhysicsObject*, PhysicsObject*, Contact&);
+typedef void(*BatchFn)(const BroadphasePair*, const int*, int, std::vector<Contact>&);
+typedef void(*OverlapFn)(PairBatch&);
+
+/*********************************************************************************************************
+* Shape classes
+**********************************************************************************************************/
+template<int Shape> struct ShapeClass;
+template<> struct ShapeClass<PLANE> { typedef Plane Type; };
+template<> struct ShapeClass<SPHERE> { typedef Sphere Type; };
+template<> struct ShapeClass<BOX> { typedef Box Type; };
+template<> struct ShapeClass<HEIGHTFIELD> { typedef Heightfield Type; };
+
+/*********************************************************************************************************
+* Pair kernels
+**********************************************************************************************************/
+// pairs without their own kernel run the one with the shapes swapped
+template<class ShapeA, class ShapeB>
+struct PairKernel
+{
+	static bool Detect(ShapeA& shapeA, ShapeB& shapeB, Contact& contact)
+	{
+		return PairKernel<ShapeB, ShapeA>::Detect(shapeB, shapeA, contact);
+	}
+};
+
+template<>
+struct PairKernel<Plane, Plane>
+{
+	static bool Detect(Plane&, Plane&, Contact&)
+	{
+		// check plane for collision
+		// if the normals are pointing in the same direction
+		//	- just check distance between and distance fom origin
+		// if the normal are at an angle
+		//	- could do some fancy trig or aabb stuff
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Sphere, Sphere>
+{
+	static bool Detect(Sphere& sphereA, Sphere& sphereB, Contact& contact)
+	{
+		return Detect(sphereA, sphereB, sphereA.GetPosition(), glm::vec3(sphereA.GetRadius()), sphereB.GetPosition(), glm::vec3(sphereB.GetRadius()), contact);
+	}
+
+	// with the positions and sizes already at hand, as a PairBatch packs them
+	static bool Detect(Sphere& sphereA, Sphere& sphereB, const glm::vec3& positionA, const glm::vec3& sizeA, const glm::vec3& positionB, const glm::vec3& sizeB, Contact& contact)
+	{
+		// check sphere for collision
+		float distance = glm::distance(positionA, positionB);
+		float totalRadius = sizeA.x + sizeB.x;
+		// compare distance between centers to combined radius
+		if (distance < totalRadius) {
+			contact.objA = &sphereA;
+			contact.objB = &sphereB;
+			contact.type = ContactType::SphereSphere;
+			// get the normal of the gap between objects
+			contact.normal = glm::normalize(positionB - positionA);
+			contact.distance = distance;
+			return true;
+		}
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Sphere, Plane>
+{
+	static bool Detect(Sphere& sphere, Plane& plane, Contact& contact)
+	{
+		glm::vec3 planeNorm = plane.getNormal();
+		// magnitude of sphere vector, plane normal
+		float mag = (dot(sphere.GetPosition(), planeNorm));
+
+		// if planeNorm is below 0 magnitude will be negative
+		if (mag < 0)
+		{
+			planeNorm *= -1;
+			mag *= -1;
+		}
+
+		float collision = mag - sphere.GetRadius();
+		// collision check
+		if (collision < 0.0f) {
+			contact.objA = &sphere;
+			contact.objB = &plane;
+			contact.type = ContactType::SpherePlane;
+			contact.normal = planeNorm;
+			contact.distance = collision;
+			return true;
+		}
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Box, Sphere>
+{
+	static bool Detect(Box& box, Sphere& sphere, Contact& contact)
+	{
+		return Detect(box, sphere, box.GetPosition(), box.GetSize(), sphere.GetPosition(), glm::vec3(sphere.GetRadius()), contact);
+	}
+
+	static bool Detect(Box& box, Sphere& sphere, const glm::vec3& boxPosition, const glm::vec3& boxSize, const glm::vec3& spherePosition, const glm::vec3& sphereSize, Contact& contact)
+	{
+		// collision check, distance between the center point and the AABB
+		if (Box::distPointToBox(boxPosition, boxSize, spherePosition) <= sphereSize.x)
+		{
+			glm::vec3 centerDist = spherePosition - boxPosition;
+			glm::vec3 boxesMaxSize = glm::vec3(boxSize + sphereSize.x);
+			contact.objA = &box;
+			contact.objB = &sphere;
+			contact.type = ContactType::BoxSphere;
+			contact.normal = glm::normalize(centerDist);
+			contact.overlap = abs(centerDist - boxesMaxSize);
+			return true;
+		}
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Box, Plane>
+{
+	static bool Detect(Box& box, Plane& plane, Contact& contact)
+	{
+		glm::vec3 planeNormal = plane.getNormal();
+		glm::vec3 center = box.GetPosition();
+		glm::vec3 extents(box.GetSize());
+		// magnitude of box center and plane vectors
+		float mag = dot(planeNormal, center);
+		// projection interval radius of box onto the plane
+		float radius = extents.x * std::abs(planeNormal.x) + extents.y * std::abs(planeNormal.y) + extents.z * std::abs(planeNormal.z);
+
+		// if planeNorm is below 0 magnitude will be negative
+		if (mag < 0)
+		{
+			planeNormal *= -1;
+			mag *= -1;
+		}
+
+		float collision = mag - radius;
+
+		// collision check
+		if (collision <= 0.0f)
+		{
+			contact.objA = &box;
+			contact.objB = &plane;
+			contact.type = ContactType::BoxPlane;
+			contact.normal = planeNormal;
+			contact.distance = collision;
+			return true;
+		}
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Box, Box>
+{
+	static bool Detect(Box& boxA, Box& boxB, Contact& contact)
+	{
+		return Detect(boxA, boxB, boxA.GetPosition(), boxA.GetSize(), boxB.GetPosition(), boxB.GetSize(), contact);
+	}
+
+	static bool Detect(Box& boxA, Box& boxB, const glm::vec3& positionA, const glm::vec3& sizeA, const glm::vec3& positionB, const glm::vec3& sizeB, Contact& contact)
+	{
+		glm::vec3 centerDist = positionB - positionA;
+		glm::vec3 boxesMaxSize = glm::vec3(sizeA + sizeB);
+		// collision check, overlap on every axis
+		if (std::abs(centerDist.x) > boxesMaxSize.x || std::abs(centerDist.y) > boxesMaxSize.y || std::abs(centerDist.z) > boxesMaxSize.z)
+		{
+			return false;
+		}
+		contact.objA = &boxA;
+		contact.objB = &boxB;
+		contact.type = ContactType::BoxBox;
+		contact.normal = glm::normalize(centerDist);
+		contact.overlap = abs(centerDist - boxesMaxSize);
+		return true;
+	}
+};
+
+// static shapes never collide with each other
+template<>
+struct PairKernel<Plane, Heightfield>
+{
+	static bool Detect(Plane&, Heightfield&, Contact&)
+	{
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Heightfield, Heightfield>
+{
+	static bool Detect(Heightfield&, Heightfield&, Contact&)
+	{
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Sphere, Heightfield>
+{
+	static bool Detect(Sphere& sphere, Heightfield& heightfield, Contact& contact)
+	{
+		glm::vec3 normal;
+		float distance;
+		if (heightfield.SphereContact(sphere.GetPosition(), sphere.GetRadius(), normal, distance))
+		{
+			contact.objA = &sphere;
+			contact.objB = &heightfield;
+			contact.type = ContactType::SphereHeightfield;
+			contact.normal = normal;
+			contact.distance = distance;
+			return true;
+		}
+		return false;
+	}
+};
+
+template<>
+struct PairKernel<Box, Heightfield>
+{
+	static bool Detect(Box& box, Heightfield& heightfield, Contact& contact)
+	{
+		glm::vec3 normal;
+		float distance;
+		if (heightfield.BoxContact(box.GetPosition(), glm::vec3(box.GetSize()), normal, distance))
+		{
+			contact.objA = &box;
+			contact.objB = &heightfield;
+			contact.type = ContactType::BoxHeightfield;
+			contact.normal = normal;
+			contact.distance = distance;
+			return true;
+		}
+		return false;
+	}
+};
+
+/*********************************************************************************************************
+* Dispatch tables
+**********************************************************************************************************/
+// the shape IDs were checked when the pair type was computed, the casts cannot fail
+template<int ShapeA, int ShapeB>
+static bool DetectPair(PhysicsObject* objA, PhysicsObject* objB, Contact& contact)
+{
+	typedef typename ShapeClass<ShapeA>::Type TypeA;
+	typedef typename ShapeClass<ShapeB>::Type TypeB;
+	return PairKernel<TypeA, TypeB>::Detect(*static_cast<TypeA*>(objA), *static_cast<TypeB*>(objB), contact);
+}
+
+// one kernel for the whole batch, the compiler sees a single concrete pair of shapes
+template<int ShapeA, int ShapeB>
+static void DetectPairs(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	for (int i = 0; i < count; i++)
+	{
+		Contact contact;
+		if (DetectPair<ShapeA, ShapeB>(pairs[i].objA, pairs[i].objB, contact))
+		{
+			contact.order = orders[i];
+			contacts.push_back(contact);
+		}
+	}
+}
+
+// bodies against a heightfield: one culling pass over the bounds of the whole run,
+// only the bodies that can reach the surface sample the cells under them
+template<int Shape>
+static void DetectHeightfieldPairs(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	thread_local HeightfieldBatch batch;
+	int begin = 0;
+	while (begin < count)
+	{
+		// runs of pairs against the same heightfield
+		Heightfield* heightfield = static_cast<Heightfield*>(pairs[begin].objB);
+		int end = begin + 1;
+		while (end < count && pairs[end].objB == heightfield)
+		{
+			end++;
+		}
+
+		batch.Clear();
+		for (int i = begin; i < end; i++)
+		{
+			batch.Add(pairs[i].objA->GetWorldBounds());
+		}
+		heightfield->CullBatch(batch);
+
+		for (int i = begin; i < end; i++)
+		{
+			Contact contact;
+			if (batch.hits[i - begin] && DetectPair<Shape, HEIGHTFIELD>(pairs[i].objA, pairs[i].objB, contact))
+			{
+				contact.order = orders[i];
+				contacts.push_back(contact);
+			}
+		}
+		begin = end;
+	}
+}
+
+template<>
+void DetectPairs<SPHERE, HEIGHTFIELD>(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	DetectHeightfieldPairs<SPHERE>(pairs, orders, count, contacts);
+}
+
+template<>
+void DetectPairs<BOX, HEIGHTFIELD>(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	DetectHeightfieldPairs<BOX>(pairs, orders, count, contacts);
+}
+
+// sphere and box pairs: the overlap kernel flags the hits over the packed batch,
+// most candidates in dense scenes are misses and never reach the branchy pair kernel
+
+// a sphere only packs its radius, the kernels never read its y and z sizes
+template<int Shape>
+static void PackA(PairBatch& batch, int i, PhysicsObject* object);
+template<int Shape>
+static void PackB(PairBatch& batch, int i, PhysicsObject* object);
+
+template<>
+void PackA<SPHERE>(PairBatch& batch, int i, PhysicsObject* object)
+{
+	batch.SetA(i, object->GetPosition(), static_cast<Sphere*>(object)->GetRadius());
+}
+
+template<>
+void PackA<BOX>(PairBatch& batch, int i, PhysicsObject* object)
+{
+	batch.SetA(i, object->GetPosition(), static_cast<Box*>(object)->GetSize());
+}
+
+template<>
+void PackB<SPHERE>(PairBatch& batch, int i, PhysicsObject* object)
+{
+	batch.SetB(i, object->GetPosition(), static_cast<Sphere*>(object)->GetRadius());
+}
+
+template<>
+void PackB<BOX>(PairBatch& batch, int i, PhysicsObject* object)
+{
+	batch.SetB(i, object->GetPosition(), static_cast<Box*>(object)->GetSize());
+}
+
+template<int ShapeA, int ShapeB>
+static void PackPair(PairBatch& batch, int i, PhysicsObject* objA, PhysicsObject* objB)
+{
+	PackA<ShapeA>(batch, i, objA);
+	PackB<ShapeB>(batch, i, objB);
+}
+
+// the box sphere kernel takes the box first
+template<>
+void PackPair<SPHERE, BOX>(PairBatch& batch, int i, PhysicsObject* objA, PhysicsObject* objB)
+{
+	PackPair<BOX, SPHERE>(batch, i, objB, objA);
+}
+
+// the pair kernel on the values the batch packed, no second trip through the objects
+template<int ShapeA, int ShapeB>
+static bool DetectPacked(PhysicsObject* objA, PhysicsObject* objB, const PairBatch& batch, int i, Contact& contact)
+{
+	typedef typename ShapeClass<ShapeA>::Type TypeA;
+	typedef typename ShapeClass<ShapeB>::Type TypeB;
+	return PairKernel<TypeA, TypeB>::Detect(*static_cast<TypeA*>(objA), *static_cast<TypeB*>(objB),
+		batch.PositionA(i), batch.SizeA(i), batch.PositionB(i), batch.SizeB(i), contact);
+}
+
+template<>
+bool DetectPacked<SPHERE, BOX>(PhysicsObject* objA, PhysicsObject* objB, const PairBatch& batch, int i, Contact& contact)
+{
+	return DetectPacked<BOX, SPHERE>(objB, objA, batch, i, contact);
+}
+
+template<int ShapeA, int ShapeB>
+static void DetectOverlappingPairs(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts, OverlapFn overlap)
+{
+	// looked up once, not at every pair
+	thread_local PairBatch threadBatch;
+	PairBatch& batch = threadBatch;
+	batch.Resize(count);
+	for (int i = 0; i < count; i++)
+	{
+		PackPair<ShapeA, ShapeB>(batch, i, pairs[i].objA, pairs[i].objB);
+	}
+	overlap(batch);
+
+	int words = (count + 31) / 32;
+	for (int word = 0; word < words; word++)
+	{
+		uint32_t bits = batch.hitMask[word];
+		for (int i = word * 32; bits != 0; i++, bits >>= 1)
+		{
+			Contact contact;
+			if ((bits & 1) != 0 && DetectPacked<ShapeA, ShapeB>(pairs[i].objA, pairs[i].objB, batch, i, contact))
+			{
+				contact.order = orders[i];
+				contacts.push_back(contact);
+			}
+		}
+	}
+}
+
+template<>
+void DetectPairs<SPHERE, SPHERE>(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	DetectOverlappingPairs<SPHERE, SPHERE>(pairs, orders, count, contacts, &Narrowphase::OverlapSpheres);
+}
+
+template<>
+void DetectPairs<BOX, SPHERE>(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	DetectOverlappingPairs<BOX, SPHERE>(pairs, orders, count, contacts, &Narrowphase::OverlapBoxSpheres);
+}
+
+template<>
+void DetectPairs<SPHERE, BOX>(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	DetectOverlappingPairs<SPHERE, BOX>(pairs, orders, count, contacts, &Narrowphase::OverlapBoxSpheres);
+}
+
+template<>
+void DetectPairs<BOX, BOX>(const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	DetectOverlappingPairs<BOX, BOX>(pairs, orders, count, contacts, &Narrowphase::OverlapBoxes);
+}
+
+template<int... PairTypes>
+static constexpr std::array<PairFn, sizeof...(PairTypes)> MakePairTable(std::integer_sequence<int, PairTypes...>)
+{
+	return { { &DetectPair<PairTypes / SHAPE_COUNT, PairTypes % SHAPE_COUNT>... } };
+}
+
+template<int... PairTypes>
+static constexpr std::array<BatchFn, sizeof...(PairTypes)> MakeBatchTable(std::integer_sequence<int, PairTypes...>)
+{
+	return { { &DetectPairs<PairTypes / SHAPE_COUNT, PairTypes % SHAPE_COUNT>... } };
+}
+
+static constexpr auto s_pairTable = MakePairTable(std::make_integer_sequence<int, SHAPE_COUNT * SHAPE_COUNT>());
+static constexpr auto s_batchTable = MakeBatchTable(std::make_integer_sequence<int, SHAPE_COUNT * SHAPE_COUNT>());
+
+/*********************************************************************************************************
+* Narrowphase
+**********************************************************************************************************/
+int Narrowphase::PairType(PhysicsObject* objA, PhysicsObject* objB)
+{
+	int shapeIdA = objA->getShapeID();
+	int shapeIdB = objB->getShapeID();
+	// skip checking collisions for joints
+	if (shapeIdA < 0 || shapeIdB < 0)
+	{
+		return -1;
+	}
+	return shapeIdA * SHAPE_COUNT + shapeIdB;
+}
+
+int Narrowphase::numberOfPairTypes()
+{
+	return SHAPE_COUNT * SHAPE_COUNT;
+}
+
+bool Narrowphase::Detect(PhysicsObject* objA, PhysicsObject* objB, Contact& contact)
+{
+	int pairType = PairType(objA, objB);
+	if (pairType < 0)
+	{
+		return false;
+	}
+	return s_pairTable[pairType](objA, objB, contact);
+}
+
+void Narrowphase::DetectBatch(int pairType, const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts)
+{
+	if (pairType < 0)
+	{
+		return;
+	}
+	s_batchTable[pairType](pairs, orders, count, contacts);
+}
+
+/*********************************************************************************************************
+* Overlap kernels
+**********************************************************************************************************/
+void PairBatch::Resize(int count)
+{
+	positionAX.resize(count);
+	positionAY.resize(count);
+	positionAZ.resize(count);
+	sizeAX.resize(count);
+	sizeAY.resize(count);
+	sizeAZ.resize(count);
+	positionBX.resize(count);
+	positionBY.resize(count);
+	positionBZ.resize(count);
+	sizeBX.resize(count);
+	sizeBY.resize(count);
+	sizeBZ.resize(count);
+}
+
+// the squared tests round differently from the pair kernels, that take a square root:
+// the radius is widened a little so a resting contact right at the boundary is never dropped,
+// the pair kernel makes the exact call on the hits
+static const float HitMargin = 1.0001f;
+
+// the wide loops step by 8 then 4, so the lanes of one step never straddle two mask words
+static inline void SetHits(uint32_t* hitMask, int i, int lanes)
+{
+	hitMask[i >> 5] |= (uint32_t)lanes << (i & 31);
+}
+
+void Narrowphase::OverlapSpheres(PairBatch& batch)
+{
+	int count = batch.size();
+	batch.hitMask.assign((count + 31) / 32, 0);
+	const float* ax = batch.positionAX.data();
+	const float* ay = batch.positionAY.data();
+	const float* az = batch.positionAZ.data();
+	const float* ar = batch.sizeAX.data();
+	const float* bx = batch.positionBX.data();
+	const float* by = batch.positionBY.data();
+	const float* bz = batch.positionBZ.data();
+	const float* br = batch.sizeBX.data();
+	uint32_t* hitMask = batch.hitMask.data();
+
+	// distance < radiusA + radiusB, compared squared
+	int i = 0;
+#if defined(PHYSICS_SIMD_AVX)
+	const __m256 margin = _mm256_set1_ps(HitMargin);
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(bx + i), _mm256_loadu_ps(ax + i));
+		__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(by + i), _mm256_loadu_ps(ay + i));
+		__m256 dz = _mm256_sub_ps(_mm256_loadu_ps(bz + i), _mm256_loadu_ps(az + i));
+		__m256 radius = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(ar + i), _mm256_loadu_ps(br + i)), margin);
+		__m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		__m256 hit = _mm256_cmp_ps(distanceSq, _mm256_mul_ps(radius, radius), _CMP_LT_OQ);
+		SetHits(hitMask, i, _mm256_movemask_ps(hit));
+	}
+#endif
+#if defined(PHYSICS_SIMD_SSE)
+	const __m128 margin = _mm_set1_ps(HitMargin);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(bx + i), _mm_loadu_ps(ax + i));
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(by + i), _mm_loadu_ps(ay + i));
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(bz + i), _mm_loadu_ps(az + i));
+		__m128 radius = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(ar + i), _mm_loadu_ps(br + i)), margin);
+		__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 hit = _mm_cmplt_ps(distanceSq, _mm_mul_ps(radius, radius));
+		SetHits(hitMask, i, _mm_movemask_ps(hit));
+	}
+#endif
+	// remaining pairs
+	for (; i < count; i++)
+	{
+		float dx = bx[i] - ax[i];
+		float dy = by[i] - ay[i];
+		float dz = bz[i] - az[i];
+		float radius = (ar[i] + br[i]) * HitMargin;
+		SetHits(hitMask, i, dx * dx + dy * dy + dz * dz < radius * radius ? 1 : 0);
+	}
+}
+
+void Narrowphase::OverlapBoxSpheres(PairBatch& batch)
+{
+	int count = batch.size();
+	batch.hitMask.assign((count + 31) / 32, 0);
+	const float* ax = batch.positionAX.data();
+	const float* ay = batch.positionAY.data();
+	const float* az = batch.positionAZ.data();
+	const float* ex = batch.sizeAX.data();
+	const float* ey = batch.sizeAY.data();
+	const float* ez = batch.sizeAZ.data();
+	const float* bx = batch.positionBX.data();
+	const float* by = batch.positionBY.data();
+	const float* bz = batch.positionBZ.data();
+	const float* br = batch.sizeBX.data();
+	uint32_t* hitMask = batch.hitMask.data();
+
+	// squared distance from the sphere center to the box <= radius squared,
+	// on each axis the center is max(|d| - extent, 0) outside the box
+	int i = 0;
+#if defined(PHYSICS_SIMD_AVX)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 margin = _mm256_set1_ps(HitMargin);
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 dx = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(bx + i), _mm256_loadu_ps(ax + i)));
+			__m256 dy = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(by + i), _mm256_loadu_ps(ay + i)));
+			__m256 dz = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(bz + i), _mm256_loadu_ps(az + i)));
+			__m256 ox = _mm256_max_ps(_mm256_sub_ps(dx, _mm256_loadu_ps(ex + i)), zero);
+			__m256 oy = _mm256_max_ps(_mm256_sub_ps(dy, _mm256_loadu_ps(ey + i)), zero);
+			__m256 oz = _mm256_max_ps(_mm256_sub_ps(dz, _mm256_loadu_ps(ez + i)), zero);
+			__m256 radius = _mm256_mul_ps(_mm256_loadu_ps(br + i), margin);
+			__m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz));
+			__m256 hit = _mm256_cmp_ps(distanceSq, _mm256_mul_ps(radius, radius), _CMP_LE_OQ);
+			SetHits(hitMask, i, _mm256_movemask_ps(hit));
+		}
+	}
+#endif
+#if defined(PHYSICS_SIMD_SSE)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 margin = _mm_set1_ps(HitMargin);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 dx = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(bx + i), _mm_loadu_ps(ax + i)));
+			__m128 dy = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(by + i), _mm_loadu_ps(ay + i)));
+			__m128 dz = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(bz + i), _mm_loadu_ps(az + i)));
+			__m128 ox = _mm_max_ps(_mm_sub_ps(dx, _mm_loadu_ps(ex + i)), zero);
+			__m128 oy = _mm_max_ps(_mm_sub_ps(dy, _mm_loadu_ps(ey + i)), zero);
+			__m128 oz = _mm_max_ps(_mm_sub_ps(dz, _mm_loadu_ps(ez + i)), zero);
+			__m128 radius = _mm_mul_ps(_mm_loadu_ps(br + i), margin);
+			__m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+			__m128 hit = _mm_cmple_ps(distanceSq, _mm_mul_ps(radius, radius));
+			SetHits(hitMask, i, _mm_movemask_ps(hit));
+		}
+	}
+#endif
+	// remaining pairs
+	for (; i < count; i++)
+	{
+		float ox = std::max(std::abs(bx[i] - ax[i]) - ex[i], 0.0f);
+		float oy = std::max(std::abs(by[i] - ay[i]) - ey[i], 0.0f);
+		float oz = std::max(std::abs(bz[i] - az[i]) - ez[i], 0.0f);
+		float radius = br[i] * HitMargin;
+		SetHits(hitMask, i, ox * ox + oy * oy + oz * oz <= radius * radius ? 1 : 0);
+	}
+}
+
+void Narrowphase::OverlapBoxes(PairBatch& batch)
+{
+	int count = batch.size();
+	batch.hitMask.assign((count + 31) / 32, 0);
+	const float* ax = batch.positionAX.data();
+	const float* ay = batch.positionAY.data();
+	const float* az = batch.positionAZ.data();
+	const float* aex = batch.sizeAX.data();
+	const float* aey = batch.sizeAY.data();
+	const float* aez = batch.sizeAZ.data();
+	const float* bx = batch.positionBX.data();
+	const float* by = batch.positionBY.data();
+	const float* bz = batch.positionBZ.data();
+	const float* bex = batch.sizeBX.data();
+	const float* bey = batch.sizeBY.data();
+	const float* bez = batch.sizeBZ.data();
+	uint32_t* hitMask = batch.hitMask.data();
+
+	// |d| <= extentA + extentB on every axis
+	int i = 0;
+#if defined(PHYSICS_SIMD_AVX)
+	{
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 dx = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(bx + i), _mm256_loadu_ps(ax + i)));
+			__m256 dy = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(by + i), _mm256_loadu_ps(ay + i)));
+			__m256 dz = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(bz + i), _mm256_loadu_ps(az + i)));
+			__m256 hitX = _mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(aex + i), _mm256_loadu_ps(bex + i)), _CMP_LE_OQ);
+			__m256 hitY = _mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(aey + i), _mm256_loadu_ps(bey + i)), _CMP_LE_OQ);
+			__m256 hitZ = _mm256_cmp_ps(dz, _mm256_add_ps(_mm256_loadu_ps(aez + i), _mm256_loadu_ps(bez + i)), _CMP_LE_OQ);
+			SetHits(hitMask, i, _mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(hitX, hitY), hitZ)));
+		}
+	}
+#endif
+#if defined(PHYSICS_SIMD_SSE)
+	{
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 dx = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(bx + i), _mm_loadu_ps(ax + i)));
+			__m128 dy = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(by + i), _mm_loadu_ps(ay + i)));
+			__m128 dz = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(bz + i), _mm_loadu_ps(az + i)));
+			__m128 hitX = _mm_cmple_ps(dx, _mm_add_ps(_mm_loadu_ps(aex + i), _mm_loadu_ps(bex + i)));
+			__m128 hitY = _mm_cmple_ps(dy, _mm_add_ps(_mm_loadu_ps(aey + i), _mm_loadu_ps(bey + i)));
+			__m128 hitZ = _mm_cmple_ps(dz, _mm_add_ps(_mm_loadu_ps(aez + i), _mm_loadu_ps(bez + i)));
+			SetHits(hitMask, i, _mm_movemask_ps(_mm_and_ps(_mm_and_ps(hitX, hitY), hitZ)));
+		}
+	}
+#endif
+	// remaining pairs
+	for (; i < count; i++)
+	{
+		bool hit = std::abs(bx[i] - ax[i]) <= aex[i] + bex[i] &&
+			std::abs(by[i] - ay[i]) <= aey[i] + bey[i] &&
+			std::abs(bz[i] - az[i]) <= aez[i] + bez[i];
+		SetHits(hitMask, i, hit ? 1 : 0);
+	}
+}
+}
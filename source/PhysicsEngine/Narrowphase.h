@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+#include "Broadphase.h"
+#include "Contact.h"
+
+namespace ntn
+{
+	class PhysicsObject;
+
+	// Centers and sizes of a run of pairs packed one array per component, for the overlap kernels.
+	// The size of a box is its half extents, a sphere only fills the x size with its radius.
+	struct PairBatch
+	{
+		std::vector<float> positionAX, positionAY, positionAZ, sizeAX, sizeAY, sizeAZ;
+		std::vector<float> positionBX, positionBY, positionBZ, sizeBX, sizeBY, sizeBZ;
+		std::vector<uint32_t> hitMask;	// bit i of word i / 32 is set when pair i overlaps
+
+		// room for count pairs, then set each of them
+		void Resize(int count);
+		void SetA(int i, const glm::vec3& position, const glm::vec3& size)
+		{
+			positionAX[i] = position.x;
+			positionAY[i] = position.y;
+			positionAZ[i] = position.z;
+			sizeAX[i] = size.x;
+			sizeAY[i] = size.y;
+			sizeAZ[i] = size.z;
+		}
+		void SetA(int i, const glm::vec3& position, float radius)
+		{
+			positionAX[i] = position.x;
+			positionAY[i] = position.y;
+			positionAZ[i] = position.z;
+			sizeAX[i] = radius;
+		}
+		void SetB(int i, const glm::vec3& position, const glm::vec3& size)
+		{
+			positionBX[i] = position.x;
+			positionBY[i] = position.y;
+			positionBZ[i] = position.z;
+			sizeBX[i] = size.x;
+			sizeBY[i] = size.y;
+			sizeBZ[i] = size.z;
+		}
+		void SetB(int i, const glm::vec3& position, float radius)
+		{
+			positionBX[i] = position.x;
+			positionBY[i] = position.y;
+			positionBZ[i] = position.z;
+			sizeBX[i] = radius;
+		}
+
+		int size() const { return (int)positionAX.size(); }
+		bool isHit(int i) const { return (hitMask[i >> 5] & (1u << (i & 31))) != 0; }
+
+		glm::vec3 PositionA(int i) const { return glm::vec3(positionAX[i], positionAY[i], positionAZ[i]); }
+		glm::vec3 SizeA(int i) const { return glm::vec3(sizeAX[i], sizeAY[i], sizeAZ[i]); }
+		glm::vec3 PositionB(int i) const { return glm::vec3(positionBX[i], positionBY[i], positionBZ[i]); }
+		glm::vec3 SizeB(int i) const { return glm::vec3(sizeBX[i], sizeBY[i], sizeBZ[i]); }
+	};
+
+	// Collision detection keyed on PhysicsObject::m_shapeID.
+	// Every (shapeA, shapeB) combination has a kernel templated on the concrete shape classes,
+	// the tables below are generated at compile time so a lookup is one index, no RTTI.
+	class Narrowphase
+	{
+	public:
+		// shapeA * SHAPE_COUNT + shapeB, -1 when one of the objects is a joint
+		static int PairType(PhysicsObject* objA, PhysicsObject* objB);
+		static int numberOfPairTypes();
+
+		// single pair, fills the contact on a hit
+		static bool Detect(PhysicsObject* objA, PhysicsObject* objB, Contact& contact);
+		// pairs that all have the given type, contact i carries orders[i]
+		static void DetectBatch(int pairType, const BroadphasePair* pairs, const int* orders, int count, std::vector<Contact>& contacts);
+
+		// overlap tests over a whole batch, 4 or 8 pairs at a time, they only fill batch.hitMask.
+		// They may flag a pair the pair kernel rejects by a rounding error, never the other way,
+		// the flagged pairs go through the pair kernel to build their contact.
+		static void OverlapSpheres(PairBatch& batch);
+		// A is the box: Box::distPointToBox(B) <= radius of B
+		static void OverlapBoxSpheres(PairBatch& batch);
+		// Box::checkCollision
+		static void OverlapBoxes(PairBatch& batch);
+	};
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <typeinfo>
+#include <cstddef>
+#include <cstdint>
+
+namespace ntn
+{
+	// Reference to a pooled object that notices when the object is gone.
+	// The generation of a slot changes every time its object is destroyed, an old handle then resolves to nullptr.
+	struct PoolHandle
+	{
+		uint32_t index = 0;
+		uint32_t generation = 0;	// 0 is never live
+
+		bool isValid() const { return generation != 0; }
+		bool operator==(const PoolHandle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const PoolHandle& other) const { return !(*this == other); }
+	};
+
+	// Storage for every object of type T, in blocks of BlockSize slots that never move.
+	// A class routes its operator new and delete here so `new T` and `delete t` keep working:
+	// allocation pops the free list, the last freed slot is the next one reused, so spawning and
+	// despawning costs the same at any count and live objects stay packed in a few blocks.
+	// Objects of a derived class are larger than a slot and go to the global heap.
+	// New and delete may run on any thread, Get and HandleOf must not race with them.
+	template<typename T>
+	class ObjectPool
+	{
+	public:
+		static const uint32_t BlockSize = 256;
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		static ObjectPool& getInstance()
+		{
+			// never destroyed, objects deleted by other statics at exit still find their pool
+			static ObjectPool* instance = new ObjectPool();
+			return *instance;
+		}
+
+		// raw storage for one T, called by T::operator new
+		static void* Allocate(size_t size)
+		{
+			if (size != sizeof(T))
+			{
+				return ::operator new(size);
+			}
+			return getInstance().AllocateSlot();
+		}
+		// called by T::operator delete with the size of the object that was destroyed
+		static void Free(void* pointer, size_t size)
+		{
+			if (pointer == nullptr)
+			{
+				return;
+			}
+			if (size != sizeof(T))
+			{
+				::operator delete(pointer);
+				return;
+			}
+			getInstance().FreeSlot(pointer);
+		}
+
+		// live object of the handle, nullptr once it was deleted
+		T* Get(PoolHandle handle) const
+		{
+			if (!handle.isValid() || handle.index >= m_capacity)
+			{
+				return nullptr;
+			}
+			const Slot& slot = SlotAt(handle.index);
+			return slot.generation == handle.generation && slot.live ? reinterpret_cast<T*>(const_cast<unsigned char*>(slot.storage)) : nullptr;
+		}
+		// handle of an object created with new, invalid for derived objects that went to the heap
+		PoolHandle HandleOf(const T* object) const
+		{
+			// only exact T objects reach the pool, see Allocate
+			if (object == nullptr || typeid(*object) != typeid(T))
+			{
+				return PoolHandle();
+			}
+			const Slot* slot = reinterpret_cast<const Slot*>(object);
+			if (slot->index >= m_capacity || &SlotAt(slot->index) != slot)
+			{
+				return PoolHandle();
+			}
+			return { slot->index, slot->generation };
+		}
+
+		uint32_t numberOfLive() const { return m_live; }
+		uint32_t capacity() const { return m_capacity; }
+
+	private:
+		struct Slot
+		{
+			alignas(T) unsigned char storage[sizeof(T)];
+			uint32_t index;
+			uint32_t generation;
+			uint32_t nextFree;
+			bool live;
+		};
+		static const uint32_t NoSlot = 0xFFFFFFFFu;
+
+		ObjectPool() = default;
+		~ObjectPool() = default;
+
+		Slot& SlotAt(uint32_t index) { return m_blocks[index / BlockSize][index % BlockSize]; }
+		const Slot& SlotAt(uint32_t index) const { return m_blocks[index / BlockSize][index % BlockSize]; }
+
+		void* AllocateSlot()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_freeList == NoSlot)
+			{
+				// a new block, its slots go on the free list in order
+				m_blocks.emplace_back(new Slot[BlockSize]);
+				for (uint32_t i = BlockSize; i-- > 0;)
+				{
+					Slot& slot = m_blocks.back()[i];
+					slot.index = m_capacity + i;
+					slot.generation = 1;
+					slot.live = false;
+					slot.nextFree = m_freeList;
+					m_freeList = slot.index;
+				}
+				m_capacity += BlockSize;
+			}
+			Slot& slot = SlotAt(m_freeList);
+			m_freeList = slot.nextFree;
+			slot.live = true;
+			m_live++;
+			return slot.storage;
+		}
+
+		void FreeSlot(void* pointer)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Slot* slot = reinterpret_cast<Slot*>(pointer);
+			slot->live = false;
+			// old handles stop resolving, 0 is skipped so it stays invalid
+			slot->generation = slot->generation + 1 != 0 ? slot->generation + 1 : 1;
+			slot->nextFree = m_freeList;
+			m_freeList = slot->index;
+			m_live--;
+		}
+
+		std::vector<std::unique_ptr<Slot[]>> m_blocks;
+		uint32_t m_capacity = 0;
+		uint32_t m_live = 0;
+		uint32_t m_freeList = NoSlot;
+		std::mutex m_mutex;
+	};
+}
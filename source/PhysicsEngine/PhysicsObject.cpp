@@ -9,6 +9,8 @@ void PhysicsObject::Copy(const PhysicsObject& other)
 	// Copy member variables
 	m_shapeID = other.m_shapeID;
 	m_2D = other.m_2D;
+	m_collisionLayer = other.m_collisionLayer;
+	m_collisionMask = other.m_collisionMask;
 
 	// Copy RigidBody if it exists
 	if (other.m_rigidbody != nullptr) {
@@ -18,36 +20,11 @@ void PhysicsObject::Copy(const PhysicsObject& other)
 		m_rigidbody = nullptr;
 	}
 }
-glm::vec3 PhysicsObject::GetPosition()
-{
-	return m_rigidbody != nullptr ? m_rigidbody->m_data.position : glm::vec3(0.0f);
-}
-glm::vec3 PhysicsObject::GetStartPosition()
-{
-	return m_rigidbody != nullptr ? m_rigidbody->m_data.startPosition : glm::vec3(0.0f);
-}
-glm::vec3 PhysicsObject::GetVelocity()
-{
-	return m_rigidbody != nullptr ? m_rigidbody->m_data.velocity : glm::vec3(0.0f);
-}
-glm::vec3 PhysicsObject::GetStartVelocity()
-{
-	return m_rigidbody != nullptr ? m_rigidbody->m_data.startVelocity : glm::vec3(0.0f);
-}
-glm::vec3 PhysicsObject::GetRotation()
-{
-	return m_rigidbody != nullptr ? m_rigidbody->m_data.rotation : glm::vec3(0.0f);
-}
-float PhysicsObject::GetMass()
-{
-	return m_rigidbody != nullptr ? m_rigidbody->m_data.mass : 0.0f;
-}
-
 void PhysicsObject::SetPosition(glm::vec3 position)
 {
 	if (m_rigidbody != nullptr) 
 	{
-		m_rigidbody->m_data.position = position;
+		m_rigidbody->setPosition(position);
 	}
 }
 
@@ -55,7 +32,7 @@ void PhysicsObject::SetVelocity(glm::vec3 velocity)
 {
 	if (m_rigidbody != nullptr) 
 	{
-		m_rigidbody->m_data.velocity = velocity;
+		m_rigidbody->setVelocity(velocity);
 	}
 }
 void PhysicsObject::SetRotation(glm::vec3 rotation)
@@ -69,7 +46,7 @@ void PhysicsObject::SetMass(float mass)
 {
 	if (m_rigidbody != nullptr)
 	{
-		m_rigidbody->m_data.mass = mass;
+		m_rigidbody->setMass(mass);
 	}
 }
 
@@ -84,14 +61,14 @@ void PhysicsObject::SetCurrentPosAsOriginalPos()
 {
 	if (m_rigidbody != nullptr)
 	{
-		m_rigidbody->m_data.startPosition = m_rigidbody->m_data.position;
+		m_rigidbody->m_data.startPosition = m_rigidbody->getPosition();
 	}
 }
 void PhysicsObject::ResetPosition()
 {
 	if (m_rigidbody != nullptr) 
 	{
-		m_rigidbody->m_data.position = m_rigidbody->m_data.startPosition;
+		m_rigidbody->setPosition(m_rigidbody->m_data.startPosition);
 	}
 }
 
@@ -99,7 +76,17 @@ void PhysicsObject::ResetVelocity()
 {
 	if (m_rigidbody != nullptr) 
 	{
-		m_rigidbody->m_data.velocity = m_rigidbody->m_data.startVelocity;
+		m_rigidbody->setVelocity(m_rigidbody->m_data.startVelocity);
 	}
 }
+
+AABB PhysicsObject::GetWorldBounds()
+{
+	glm::vec3 position = GetPosition();
+	return AABB(position, position);
+}
+bool PhysicsObject::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance)
+{
+	return GetWorldBounds().RayIntersect(origin, 1.0f / direction, maxDistance, distance);
+}
 }
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstdint>
 #include "glm/glm.hpp"
+#include "AABB.h"
+#include "RigidBody.h"
 
 namespace ntn
 {
@@ -9,11 +12,10 @@ namespace ntn
 		PLANE = 0,
 		SPHERE = 1,
 		BOX = 2,
-		SHAPE_COUNT = 3
+		HEIGHTFIELD = 3,
+		SHAPE_COUNT = 4
 	};
 
-	class RigidBody;
-
 	class PhysicsObject
 	{
 	protected:
@@ -32,18 +34,19 @@ namespace ntn
 
 		int getShapeID() { return m_shapeID; }
 
-		virtual glm::vec3 GetPosition();
-		virtual glm::vec3 GetStartPosition();
-		virtual glm::vec3 GetVelocity();
-		virtual glm::vec3 GetStartVelocity();
-		virtual glm::vec3 GetRotation();
-		virtual float GetMass();
-
+		// the object is a handle on its rigid body, state reads go straight to the body world
+		glm::vec3 GetPosition() const { return m_rigidbody != nullptr ? m_rigidbody->getPosition() : glm::vec3(0.0f); }
+		glm::vec3 GetInterpolatedPosition(float alpha) const { return m_rigidbody != nullptr ? m_rigidbody->getInterpolatedPosition(alpha) : glm::vec3(0.0f); }
+		glm::vec3 GetStartPosition() const { return m_rigidbody != nullptr ? m_rigidbody->m_data.startPosition : glm::vec3(0.0f); }
+		glm::vec3 GetVelocity() const { return m_rigidbody != nullptr ? m_rigidbody->getVelocity() : glm::vec3(0.0f); }
+		glm::vec3 GetStartVelocity() const { return m_rigidbody != nullptr ? m_rigidbody->m_data.startVelocity : glm::vec3(0.0f); }
+		glm::vec3 GetRotation() const { return m_rigidbody != nullptr ? m_rigidbody->m_data.rotation : glm::vec3(0.0f); }
+		float GetMass() const { return m_rigidbody != nullptr ? m_rigidbody->getMass() : 0.0f; }
 
-		virtual void SetPosition(glm::vec3 position);
-		virtual void SetVelocity(glm::vec3 velocity);
-		virtual void SetRotation(glm::vec3 rotation);
-		virtual void SetMass(float mass);
+		void SetPosition(glm::vec3 position);
+		void SetVelocity(glm::vec3 velocity);
+		void SetRotation(glm::vec3 rotation);
+		void SetMass(float mass);
 
 		void SetOriginalPosition(glm::vec3 position);
 		void SetCurrentPosAsOriginalPos();
@@ -54,9 +57,30 @@ namespace ntn
 		virtual void ResetPosition();
 		virtual void ResetVelocity();
 
+		// world space bounds used by the broadphase
+		virtual AABB GetWorldBounds();
+		// distance along a normalized ray to the shape surface
+		virtual bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float& distance);
+
+		int GetProxyId() const { return m_proxyId; }
+		void SetProxyId(int proxyId) { m_proxyId = proxyId; }
+
+		// collision filtering, set before the object is added to a scene: the broadphase drops the pairs it filters out
+		uint32_t GetCollisionLayer() const { return m_collisionLayer; }
+		uint32_t GetCollisionMask() const { return m_collisionMask; }
+		void SetCollisionFilter(uint32_t layer, uint32_t mask) { m_collisionLayer = layer; m_collisionMask = mask; }
+		// each layer has to be in the mask of the other object
+		static bool CanCollide(const PhysicsObject* objA, const PhysicsObject* objB)
+		{
+			return (objA->m_collisionLayer & objB->m_collisionMask) != 0 && (objB->m_collisionLayer & objA->m_collisionMask) != 0;
+		}
+
 	protected:
 		ShapeType m_shapeID = ShapeType::BOX;
 		RigidBody* m_rigidbody = nullptr;
 		bool m_2D = false;
+		int m_proxyId = -1;
+		uint32_t m_collisionLayer = 1;
+		uint32_t m_collisionMask = 0xFFFFFFFF;
 	};
 }
@@ -0,0 +1,80 @@
+#include "PhysicsProfiler.h"
+
+#include <algorithm>
+
+namespace ntn
+{
+
+PhysicsProfiler::PhysicsProfiler() : m_history(HistorySize)
+{
+}
+
+void PhysicsProfiler::Record(const PhysicsProfileSample& sample)
+{
+	m_history[m_next] = sample;
+	m_next = (m_next + 1) % HistorySize;
+	m_count = std::min(m_count + 1, (int)HistorySize);
+	if (m_csv.is_open())
+	{
+		WriteCsvRow(sample);
+	}
+}
+
+const PhysicsProfileSample& PhysicsProfiler::getSample(int index) const
+{
+	return m_history[(m_next - m_count + index + HistorySize) % HistorySize];
+}
+
+float PhysicsProfiler::Average(float (*value)(const PhysicsProfileSample& sample)) const
+{
+	if (m_count == 0)
+	{
+		return 0.0f;
+	}
+	float sum = 0.0f;
+	for (int index = 0; index < m_count; index++)
+	{
+		sum += value(getSample(index));
+	}
+	return sum / (float)m_count;
+}
+
+/*********************************************************************************************************
+* CSV streaming
+**********************************************************************************************************/
+bool PhysicsProfiler::StartCsv(const std::string& path)
+{
+	StopCsv();
+	m_csv.open(path, std::ios::trunc);
+	if (!m_csv)
+	{
+		m_csv.close();
+		return false;
+	}
+	m_csv << "update,steps,total_ms,integrate_ms,broadphase_ms,continuous_ms,narrowphase_ms,solver_ms,islands_ms,"
+		"bodies,sleeping_bodies,islands,candidate_pairs,tested_pairs,contacts,manifolds,joints,allocations,allocated_bytes\n";
+	return true;
+}
+
+void PhysicsProfiler::StopCsv()
+{
+	if (m_csv.is_open())
+	{
+		m_csv.close();
+	}
+}
+
+void PhysicsProfiler::WriteCsvRow(const PhysicsProfileSample& sample)
+{
+	const PhysicsTimings& timings = sample.timings;
+	const CollisionStats& stats = sample.stats;
+	m_csv << sample.update << ',' << sample.steps << ','
+		<< timings.total << ',' << timings.integrate << ',' << timings.broadphase << ',' << timings.continuous << ','
+		<< timings.narrowphase << ',' << timings.response << ',' << timings.islands << ','
+		<< sample.bodies << ',' << sample.sleepingBodies << ',' << sample.islands << ','
+		<< stats.candidatePairs << ',' << stats.testedPairs << ',' << stats.contacts << ','
+		<< stats.manifolds << ',' << stats.joints << ','
+		<< sample.allocations << ',' << sample.allocatedBytes << '\n';
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+
+#include "PhysicsScene.h"
+
+namespace ntn
+{
+	// Keeps the last few hundred PhysicsProfileSample for plotting and streams every one of them to a CSV file
+	// while asked to, one row per Update.
+	class PhysicsProfiler
+	{
+	public:
+		static const int HistorySize = 240;
+
+		PhysicsProfiler();
+
+		void Record(const PhysicsProfileSample& sample);
+
+		// oldest first
+		int numberOfSamples() const { return m_count; }
+		const PhysicsProfileSample& getSample(int index) const;
+		const PhysicsProfileSample& getLast() const { return getSample(m_count - 1); }
+		// mean of one value over the history, for the labels of the plots
+		float Average(float (*value)(const PhysicsProfileSample& sample)) const;
+
+		// false when the file can not be created, the header goes in first
+		bool StartCsv(const std::string& path);
+		void StopCsv();
+		bool isStreaming() const { return m_csv.is_open(); }
+
+	private:
+		void WriteCsvRow(const PhysicsProfileSample& sample);
+
+		std::vector<PhysicsProfileSample> m_history;
+		int m_next = 0;
+		int m_count = 0;
+		std::ofstream m_csv;
+	};
+}
@@ -4,29 +4,72 @@
 #include "Sphere.h"
 #include "Plane.h"
 #include "Box.h"
+#include "Heightfield.h"
+#include "Joint.h"
+#include "DynamicAABBTree.h"
+#include "SweepAndPrune.h"
+#include "SpatialHashGrid.h"
+#include "JobSystem.h"
+#include "Narrowphase.h"
+#include "ContinuousCollision.h"
+#include "AllocationCounter.h"
 
 #include <string>
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 #include <math.h>
-#include <glm\gtx\range.hpp>
-#include <glm\gtc\type_ptr.hpp> // used for gl::vec to [] in gui functions
+#include <chrono>
+#include <unordered_map>
 
 namespace ntn
 {
 
-typedef bool(*fn)(PhysicsObject*, PhysicsObject*);
+typedef std::chrono::high_resolution_clock Clock;
 
-static fn collisionFuncs[] = 
+// milliseconds since start, start moves to now so phases can be timed back to back
+static float LapMilliseconds(Clock::time_point& start)
 {
-	PhysicsScene::planeToPlane, PhysicsScene::planeToSphere, PhysicsScene::planeToBox,
-	PhysicsScene::sphereToPlane, PhysicsScene::sphereToSphere, PhysicsScene::sphereToBox,
-	PhysicsScene::boxToPlane, PhysicsScene::boxToSphere, PhysicsScene::boxToBox
-};
+	Clock::time_point now = Clock::now();
+	float milliseconds = std::chrono::duration<float, std::milli>(now - start).count();
+	start = now;
+	return milliseconds;
+}
+
+// planes and heightfields are static and unbounded or large, they stay out of the broadphase
+static bool InBroadphase(PhysicsObject* object)
+{
+	int shapeID = object->getShapeID();
+	return shapeID >= 0 && shapeID != PLANE && shapeID != HEIGHTFIELD;
+}
+
+// bounded bodies static when added, they live in the static tree
+static bool IsStaticBody(PhysicsObject* object)
+{
+	return InBroadphase(object) && object->Rigidbody() != nullptr && object->Rigidbody()->isStatic();
+}
+
+static bool IsSleeping(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && object->Rigidbody()->isSleeping();
+}
+
+// elasticity of the static surface of a plane or heightfield contact
+static float SurfaceElasticity(PhysicsObject* surface)
+{
+	if (surface->getShapeID() == HEIGHTFIELD)
+	{
+		return static_cast<Heightfield*>(surface)->getElasticity();
+	}
+	return static_cast<Plane*>(surface)->getElasticity();
+}
 
 PhysicsScene::PhysicsScene()
 {
 	m_applyForce = false;
+	m_broadphase = std::make_unique<DynamicAABBTree>();
+	m_broadphaseType = BroadphaseType::DynamicTree;
+	m_staticBroadphase = std::make_unique<DynamicAABBTree>();
 }
 
 PhysicsScene::~PhysicsScene()
@@ -40,6 +83,35 @@ PhysicsScene::~PhysicsScene()
 void PhysicsScene::addObject(PhysicsObject* object)
 {
 	m_allObjects.push_back(object);
+	m_layoutVersion++;
+	if (object->Rigidbody() != nullptr)
+	{
+		m_bodyWorld.Add(object->Rigidbody());
+	}
+
+	if (object->getShapeID() == PLANE)
+	{
+		m_planes.push_back(object);
+	}
+	else if (object->getShapeID() == HEIGHTFIELD)
+	{
+		m_heightfields.push_back(object);
+	}
+	else if (object->getShapeID() == JOINT)
+	{
+		m_joints.push_back(static_cast<Joint*>(object));
+	}
+	else if (IsStaticBody(object))
+	{
+		m_staticBroadphase->Insert(object);
+		// nothing to integrate, it stays asleep as nothing wakes a static body
+		m_bodyWorld.Sleep(object->Rigidbody());
+	}
+	else if (InBroadphase(object))
+	{
+		m_broadphase->Insert(object);
+		m_dynamicObjects.push_back(object);
+	}
 }
 
 void PhysicsScene::removeObject(PhysicsObject* object)
@@ -49,6 +121,37 @@ void PhysicsScene::removeObject(PhysicsObject* object)
 	if (objItr != m_allObjects.end())
 	{
 		m_allObjects.erase(objItr);
+		m_layoutVersion++;
+	}
+
+	auto planeItr = std::find(m_planes.begin(), m_planes.end(), object);
+	if (planeItr != m_planes.end())
+	{
+		m_planes.erase(planeItr);
+	}
+	auto heightfieldItr = std::find(m_heightfields.begin(), m_heightfields.end(), object);
+	if (heightfieldItr != m_heightfields.end())
+	{
+		m_heightfields.erase(heightfieldItr);
+	}
+	auto jointItr = std::find(m_joints.begin(), m_joints.end(), object);
+	if (jointItr != m_joints.end())
+	{
+		m_joints.erase(jointItr);
+	}
+	auto dynamicItr = std::find(m_dynamicObjects.begin(), m_dynamicObjects.end(), object);
+	if (dynamicItr != m_dynamicObjects.end())
+	{
+		m_dynamicObjects.erase(dynamicItr);
+	}
+	// both check the proxy belongs to them
+	m_broadphase->Remove(object);
+	m_staticBroadphase->Remove(object);
+	// the cached manifolds may point at the object
+	m_solver.RemoveObject(object);
+	if (object->Rigidbody() != nullptr)
+	{
+		m_bodyWorld.Remove(object->Rigidbody());
 	}
 }
 
@@ -70,458 +173,1383 @@ void PhysicsScene::clearScene()
 	m_properties.gravity = false;
 	m_properties.collisions = false;
 	m_allObjects.clear();
+	m_layoutVersion++;
+	m_planes.clear();
+	m_heightfields.clear();
+	m_joints.clear();
+	m_dynamicObjects.clear();
+	m_solver.Clear();
+	m_broadphase->Clear();
+	m_staticBroadphase->Clear();
+	m_bodyWorld.Clear();
+}
+
+void PhysicsScene::updateStaticObject(PhysicsObject* object)
+{
+	if (std::find(m_allObjects.begin(), m_allObjects.end(), object) == m_allObjects.end() ||
+		std::find(m_dynamicObjects.begin(), m_dynamicObjects.end(), object) != m_dynamicObjects.end())
+	{
+		return;
+	}
+	// the bodies resting on it where it was and where it is now would not notice the move on their own
+	AABB oldBounds;
+	if (m_staticBroadphase->GetBounds(object, oldBounds))
+	{
+		wakeBodiesIn(oldBounds);
+	}
+	m_staticBroadphase->Remove(object);
+	if (IsStaticBody(object))
+	{
+		m_staticBroadphase->Insert(object);
+		wakeBodiesIn(object->GetWorldBounds());
+	}
+	else if (InBroadphase(object))
+	{
+		syncBroadphase();
+		m_broadphase->Insert(object);
+		m_dynamicObjects.push_back(object);
+		object->Rigidbody()->wake();
+	}
+}
+
+void PhysicsScene::wakeBodiesIn(const AABB& bounds)
+{
+	// a little larger, resting contacts may keep a small gap
+	const glm::vec3 margin(0.05f);
+	syncBroadphase();
+	m_sweepCandidates.clear();
+	m_broadphase->QueryAABB(AABB(bounds.min - margin, bounds.max + margin), m_sweepCandidates);
+	for (PhysicsObject* object : m_sweepCandidates)
+	{
+		if (object->Rigidbody() != nullptr)
+		{
+			object->Rigidbody()->wake();
+		}
+	}
+}
+
+void PhysicsScene::syncBroadphase()
+{
+	if (m_properties.broadphase != m_broadphaseType)
+	{
+		rebuildBroadphase(m_properties.broadphase);
+	}
+}
+
+void PhysicsScene::rebuildBroadphase(BroadphaseType type)
+{
+	m_broadphase->Clear();
+	switch (type)
+	{
+	case BroadphaseType::SweepAndPrune:
+		m_broadphase = std::make_unique<SweepAndPrune>();
+		break;
+	case BroadphaseType::SpatialHash:
+		m_broadphase = std::make_unique<SpatialHashGrid>();
+		break;
+	default:
+		m_broadphase = std::make_unique<DynamicAABBTree>();
+		break;
+	}
+	m_broadphaseType = type;
+
+	for (PhysicsObject* object : m_dynamicObjects)
+	{
+		m_broadphase->Insert(object);
+	}
 }
 
 void PhysicsScene::Update(float deltaTime)
 {
-	// update physics at fixed time step
-	static float timer = 0;
-	timer += deltaTime;
-	if (timer >= m_timeStep) 
+	Clock::time_point start = Clock::now();
+	m_timings = PhysicsTimings();
+	// allocations of this update, the workers of the job system are always counted
+	bool counting = AllocationCounter::isCountingThisThread();
+	AllocationCounter::CountThisThread(true);
+	uint64_t allocations = AllocationCounter::numberOfAllocations();
+	uint64_t allocatedBytes = AllocationCounter::allocatedBytes();
+	syncBroadphase();
+
+	if (m_timeStep <= 0.0f)
+	{
+		// no fixed step set, follow the frame time
+		Step(deltaTime);
+		m_stepsLastUpdate = 1;
+		m_interpolationAlpha = 1.0f;
+	}
+	else
+	{
+		// update physics at fixed time step, the frame time is consumed in whole steps
+		m_accumulator += deltaTime;
+		m_stepsLastUpdate = 0;
+		while (m_accumulator >= m_timeStep && m_stepsLastUpdate < m_maxSubSteps)
+		{
+			Step(m_timeStep);
+			m_accumulator -= m_timeStep;
+			m_stepsLastUpdate++;
+		}
+		// after a long frame (breakpoint, loading) the simulation falls behind instead of spiraling
+		if (m_accumulator >= m_timeStep)
+		{
+			m_accumulator = fmodf(m_accumulator, m_timeStep);
+		}
+		m_interpolationAlpha = m_accumulator / m_timeStep;
+	}
+	m_timings.total = LapMilliseconds(start);
+
+	m_profile.update++;
+	m_profile.steps = m_stepsLastUpdate;
+	m_profile.timings = m_timings;
+	m_profile.stats = m_collisionStats;
+	m_profile.bodies = m_bodyWorld.numberOfBodies();
+	m_profile.sleepingBodies = numberOfSleepingBodies();
+	m_profile.islands = m_numberOfIslands;
+	m_profile.allocations = AllocationCounter::numberOfAllocations() - allocations;
+	m_profile.allocatedBytes = AllocationCounter::allocatedBytes() - allocatedBytes;
+	AllocationCounter::CountThisThread(counting);
+}
+
+void PhysicsScene::Step(float timeStep)
+{
+	Clock::time_point start = Clock::now();
+	m_lastStepTime = timeStep;
+	m_bodyWorld.StorePreviousPositions();
+
+	// every rigid body is integrated in one pass over the body world
+	glm::vec3 gravity = m_properties.gravity ? m_gravity : glm::vec3(0.0f);
+	m_bodyWorld.Integrate(gravity, timeStep);
+	for (auto object : m_allObjects)
 	{
-		timer -= m_timeStep;
-		// update all
-		for (auto object : m_allObjects)
+		if (object != nullptr && object->Rigidbody() == nullptr)
 		{
-			if (object != nullptr)
+			object->UpdatePhysics(gravity, timeStep);
+		}
+	}
+	m_timings.integrate += LapMilliseconds(start);
+
+	// refit the broadphase with the new positions
+	m_broadphase->Update(timeStep);
+	m_timings.broadphase += LapMilliseconds(start);
+
+	// fast bodies could have skipped through something, they go back to their first impact
+	m_sweptBodies = 0;
+	m_sweptHits = 0;
+	if (m_properties.collisions && m_properties.continuousCollisions)
+	{
+		if (sweepFastBodies() > 0)
+		{
+			m_broadphase->Update(timeStep);
+		}
+		m_timings.continuous += LapMilliseconds(start);
+	}
+
+	// check for collisions
+	if (m_properties.collisions)
+	{
+		checkCollisions();
+		m_collisionStats.sweptBodies = m_sweptBodies;
+		m_collisionStats.sweptHits = m_sweptHits;
+	}
+	else
+	{
+		m_contacts.clear();
+	}
+
+	// without the contact solver the joints are solved on their own
+	bool jointsSolved = m_properties.collisions && m_properties.collisionResponse && m_properties.response == ContactResponse::SequentialImpulse;
+	if (!jointsSolved && !m_joints.empty())
+	{
+		start = Clock::now();
+		wakeTouchingBodies();
+		m_solver.Solve(std::vector<Contact>(), m_joints, m_bodyWorld, timeStep, m_properties.solver);
+		m_collisionStats.joints = m_solver.numberOfJoints();
+		m_collisionStats.colors = m_solver.numberOfColors();
+		m_timings.response += LapMilliseconds(start);
+	}
+	start = Clock::now();
+	updateSleeping();
+	m_timings.islands += LapMilliseconds(start);
+}
+
+int PhysicsScene::sweepFastBodies()
+{
+	// part of the way into the obstacle the body stops at, so the discrete pass sees the contact
+	const float penetration = 0.05f;
+
+	for (PhysicsObject* object : m_dynamicObjects)
+	{
+		RigidBody* body = object->Rigidbody();
+		if (body == nullptr || body->getWorld() != &m_bodyWorld || body->isStatic() || body->isSleeping())
+		{
+			continue;
+		}
+		bool sphere = object->getShapeID() == SPHERE;
+		glm::vec3 halfExtents = sphere ? glm::vec3(static_cast<Sphere*>(object)->GetRadius()) : static_cast<Box*>(object)->GetSize();
+		float size = std::min(std::min(halfExtents.x, halfExtents.y), halfExtents.z);
+
+		// slow bodies cannot skip through anything in one step, the discrete pass is enough for them
+		glm::vec3 start = m_bodyWorld.GetPreviousPosition(body->getIndex());
+		glm::vec3 end = object->GetPosition();
+		glm::vec3 motion = end - start;
+		float threshold = m_properties.ccdMotionThreshold * size;
+		if (glm::dot(motion, motion) <= threshold * threshold)
+		{
+			continue;
+		}
+		m_sweptBodies++;
+
+		// everything the shape crosses on its way, other bodies are held at their new positions
+		AABB swept = AABB::Union(AABB::FromCenterExtents(start, halfExtents), AABB::FromCenterExtents(end, halfExtents));
+		m_sweepCandidates.clear();
+		m_broadphase->QueryAABB(swept, m_sweepCandidates);
+		m_staticBroadphase->QueryAABB(swept, m_sweepCandidates);
+		m_sweepCandidates.insert(m_sweepCandidates.end(), m_planes.begin(), m_planes.end());
+		for (PhysicsObject* heightfield : m_heightfields)
+		{
+			if (heightfield->GetWorldBounds().Overlaps(swept))
 			{
-				object->UpdatePhysics(m_properties.gravity ? m_gravity : glm::vec3(0.0f), deltaTime);
+				m_sweepCandidates.push_back(heightfield);
 			}
 		}
-		// check for collisions
-		if (m_properties.collisions)
+
+		float firstImpact = 1.0f;
+		bool hit = false;
+		for (PhysicsObject* obstacle : m_sweepCandidates)
 		{
-			checkCollisions();
+			float toi;
+			if (obstacle == object || !PhysicsObject::CanCollide(object, obstacle))
+			{
+				continue;
+			}
+			bool hitObstacle = sphere ? ContinuousCollision::SweepSphere(start, motion, halfExtents.x, obstacle, toi) :
+										ContinuousCollision::SweepBox(start, motion, halfExtents, obstacle, toi);
+			if (hitObstacle && toi < firstImpact)
+			{
+				firstImpact = toi;
+				hit = true;
+			}
+		}
+		if (!hit)
+		{
+			continue;
 		}
+
+		float length = glm::length(motion);
+		float overshoot = std::min(penetration * size, length * (1.0f - firstImpact));
+		object->SetPosition(start + motion * firstImpact + motion * (overshoot / length));
+		m_sweptHits++;
 	}
+	return m_sweptHits;
 }
 
 void PhysicsScene::checkCollisions()
 {
-	int nbrObjects = numberOfObjects();
+	Clock::time_point start = Clock::now();
+	m_collisionStats = CollisionStats();
 
-	// check for collisions with this object
-	for (int outer = 0; outer < nbrObjects - 1; outer++)
+	// broadphase: only boxes overlapping on all axes reach the narrowphase
+	const std::vector<BroadphasePair>& pairs = m_broadphase->ComputePairs();
+	m_timings.broadphase += LapMilliseconds(start);
+
+	// static pairs are never formed, they are not candidates either
+	int nbrBodies = m_broadphase->numberOfProxies();
+	int nbrStatics = (int)(m_planes.size() + m_heightfields.size()) + m_staticBroadphase->numberOfProxies();
+	m_collisionStats.candidatePairs = (int64_t)nbrBodies * (nbrBodies - 1) / 2 + (int64_t)nbrStatics * nbrBodies;
+
+	m_narrowphasePairs.assign(pairs.begin(), pairs.end());
+	// static bodies around each awake body, sleeping bodies already rest on them or away from them
+	if (m_staticBroadphase->numberOfProxies() > 0)
 	{
-		for (int inner = outer +1; inner < nbrObjects; inner++)
+		for (PhysicsObject* object : m_dynamicObjects)
 		{
-			PhysicsObject* objA = m_allObjects[outer];
-			PhysicsObject* objB = m_allObjects[inner];
-			int shapeIdA = objA->getShapeID();
-			int shapeIdB = objB->getShapeID();
-			// skip checking collisions for joints
-			if (shapeIdA < 0 || shapeIdB < 0) 
+			if (IsSleeping(object))
 			{
 				continue;
 			}
-			// function pointers
-			int functionID = (shapeIdA * SHAPE_COUNT) + shapeIdB;
-			fn collisionFuncPtr = collisionFuncs[functionID];
-			if (collisionFuncPtr != nullptr) 
+			m_staticCandidates.clear();
+			m_staticBroadphase->QueryAABB(object->GetWorldBounds(), m_staticCandidates);
+			for (PhysicsObject* other : m_staticCandidates)
+			{
+				if (PhysicsObject::CanCollide(object, other))
+				{
+					m_narrowphasePairs.push_back({ object, other });
+				}
+			}
+		}
+	}
+	// planes against every body
+	for (PhysicsObject* plane : m_planes)
+	{
+		for (PhysicsObject* object : m_dynamicObjects)
+		{
+			if (!IsSleeping(object) && PhysicsObject::CanCollide(object, plane))
+			{
+				m_narrowphasePairs.push_back({ object, plane });
+			}
+		}
+	}
+	// heightfields against the bodies over them, the kernels only sample the cells under each body
+	for (PhysicsObject* heightfield : m_heightfields)
+	{
+		AABB bounds = heightfield->GetWorldBounds();
+		for (PhysicsObject* object : m_dynamicObjects)
+		{
+			if (!IsSleeping(object) && PhysicsObject::CanCollide(object, heightfield) && bounds.Overlaps(object->GetWorldBounds()))
+			{
+				m_narrowphasePairs.push_back({ object, heightfield });
+			}
+		}
+	}
+	m_collisionStats.testedPairs = (int)m_narrowphasePairs.size();
+
+	detectContacts();
+	m_collisionStats.contacts = (int)m_contacts.size();
+	m_timings.narrowphase += LapMilliseconds(start);
+	wakeTouchingBodies();
+	m_timings.islands += LapMilliseconds(start);
+
+	// bodies only change here
+	if (m_properties.collisionResponse)
+	{
+		if (m_properties.response == ContactResponse::SequentialImpulse)
+		{
+			m_solver.Solve(m_contacts, m_joints, m_bodyWorld, m_lastStepTime, m_properties.solver);
+			m_collisionStats.manifolds = m_solver.numberOfManifolds();
+			m_collisionStats.warmStarted = m_solver.numberOfWarmStarted();
+			m_collisionStats.joints = m_solver.numberOfJoints();
+			m_collisionStats.colors = m_solver.numberOfColors();
+		}
+		else
+		{
+			// one contact after the other in pair order
+			for (const Contact& contact : m_contacts)
 			{
-				collisionFuncPtr(objA, objB);
+				resolveContact(contact);
 			}
 		}
 	}
+	m_timings.response += LapMilliseconds(start);
 }
-/*********************************************************************************************************
-* Plane to Object collisions
-**********************************************************************************************************/
-bool PhysicsScene::planeToPlane(PhysicsObject* a_planeA, PhysicsObject* a_planeB)
-{
-	Plane* planeA = dynamic_cast<Plane*>(a_planeA);
-	Plane* planeB = dynamic_cast<Plane*>(a_planeB);
-	// check if objects aren't null before testing
-	if (planeA != nullptr && planeB != nullptr) {
-		// check plane for collision
-		// if the normals are pointing in the same direction
-		//	- just check distance between and distance fom origin
-		// if the normal are at an angle
-		//	- could do some fancy trig or aabb stuff
+
+// an awake body wakes the sleeping body it touches or is jointed to
+static void WakePair(PhysicsObject* objA, PhysicsObject* objB)
+{
+	RigidBody* bodyA = objA != nullptr ? objA->Rigidbody() : nullptr;
+	RigidBody* bodyB = objB != nullptr ? objB->Rigidbody() : nullptr;
+	if (bodyA == nullptr || bodyB == nullptr)
+	{
+		return;
+	}
+	// static bodies neither wake others nor get woken
+	if (bodyA->isSleeping() && !bodyB->isSleeping() && !bodyA->isStatic() && !bodyB->isStatic())
+	{
+		bodyA->wake();
+	}
+	else if (bodyB->isSleeping() && !bodyA->isSleeping() && !bodyA->isStatic() && !bodyB->isStatic())
+	{
+		bodyB->wake();
 	}
-	return false;
 }
 
-bool PhysicsScene::planeToSphere(PhysicsObject* plane, PhysicsObject* sphere)
+void PhysicsScene::wakeTouchingBodies()
 {
-	return sphereToPlane(sphere, plane);
+	for (const Contact& contact : m_contacts)
+	{
+		WakePair(contact.objA, contact.objB);
+	}
+	for (Joint* joint : m_joints)
+	{
+		WakePair(joint->getObjectA(), joint->getObjectB());
+	}
+}
+
+void PhysicsScene::updateSleeping()
+{
+	if (!m_properties.sleeping)
+	{
+		// wake everything once when sleeping gets turned off, static bodies stay asleep
+		for (int index = m_bodyWorld.numberOfAwakeBodies(); index < m_bodyWorld.numberOfBodies(); index++)
+		{
+			m_bodyWorld.GetBody(index)->wake();
+		}
+		m_numberOfIslands = 0;
+		return;
+	}
+
+	m_bodyWorld.UpdateSleepFrames(m_properties.sleepVelocity);
+
+	// awake bodies sit at [0, numberOfAwakeBodies()) of the body world, their index is their node in the graph
+	int numberOfAwake = m_bodyWorld.numberOfAwakeBodies();
+	m_islands.Reset(numberOfAwake);
+	for (const Contact& contact : m_contacts)
+	{
+		linkIsland(contact.objA, contact.objB);
+	}
+	// a chain sleeps as a whole
+	for (Joint* joint : m_joints)
+	{
+		linkIsland(joint->getObjectA(), joint->getObjectB());
+	}
+	m_islands.Build();
+	m_numberOfIslands = m_islands.numberOfIslands();
+
+	// sleeping moves bodies around in the world, collect them first
+	m_bodiesToSleep.clear();
+	for (int island = 0; island < m_numberOfIslands; island++)
+	{
+		bool quiet = true;
+		for (int slot = m_islands.IslandBegin(island); slot < m_islands.IslandEnd(island) && quiet; slot++)
+		{
+			quiet = m_bodyWorld.GetSleepFrames(m_islands.IslandBody(slot)) >= m_properties.sleepFrames;
+		}
+		if (!quiet)
+		{
+			continue;
+		}
+		for (int slot = m_islands.IslandBegin(island); slot < m_islands.IslandEnd(island); slot++)
+		{
+			m_bodiesToSleep.push_back(m_bodyWorld.GetBody(m_islands.IslandBody(slot)));
+		}
+	}
+	for (RigidBody* body : m_bodiesToSleep)
+	{
+		m_bodyWorld.Sleep(body);
+	}
 }
 
-bool PhysicsScene::planeToBox(PhysicsObject* plane, PhysicsObject* box)
+void PhysicsScene::linkIsland(PhysicsObject* objA, PhysicsObject* objB)
 {
-	return boxToPlane(box, plane);
+	RigidBody* bodyA = objA != nullptr ? objA->Rigidbody() : nullptr;
+	RigidBody* bodyB = objB != nullptr ? objB->Rigidbody() : nullptr;
+	if (bodyA == nullptr || bodyB == nullptr || bodyA->getWorld() != &m_bodyWorld || bodyB->getWorld() != &m_bodyWorld)
+	{
+		return;
+	}
+	if (bodyA->isStatic() || bodyB->isStatic() || bodyA->isSleeping() || bodyB->isSleeping())
+	{
+		return;
+	}
+	m_islands.Link(bodyA->getIndex(), bodyB->getIndex());
 }
-/*********************************************************************************************************
-* Sphere to Object collsions
-**********************************************************************************************************/
-bool PhysicsScene::sphereToSphere(PhysicsObject * a_sphereA, PhysicsObject * a_sphereB)
-{
-	Sphere* sphereA = dynamic_cast<Sphere*>(a_sphereA);
-	Sphere* sphereB = dynamic_cast<Sphere*>(a_sphereB);
-
-	if (sphereA != nullptr && sphereB != nullptr) 
-	{
-		// check sphere for collision
-		float distance = glm::distance(sphereA->GetPosition(), sphereB->GetPosition());
-		float totalRadius = sphereA->GetRadius() + sphereB->GetRadius();
-		// compare distance between centers to combined radius
-		if (distance < totalRadius) {
-			// cahce bool values
-			bool kinematicA = sphereA->Rigidbody()->m_data.isKinematic;
-			bool kinematicB = sphereB->Rigidbody()->m_data.isKinematic;
-			bool onGroundA = sphereA->Rigidbody()->m_data.onGround;
-			bool onGroundB = sphereB->Rigidbody()->m_data.onGround;
-			// check either is kinematic
-			if (!kinematicA || !kinematicB) {
-				// get the normal of the gap between objects
-				glm::vec3 collisionNormal = glm::normalize(sphereB->GetPosition() - sphereA->GetPosition());
-				// if both spheres are not on the ground
-				if (!onGroundA && !onGroundB) {
-					// calculate force vector
-					glm::vec3 relativeVelocity = sphereA->GetVelocity() - sphereB->GetVelocity();
-					glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
-					glm::vec3 forceVector =	collisionVector * 1.0f / (1.0f / sphereA->Rigidbody()->m_data.mass + 1.0f / sphereB->Rigidbody()->m_data.mass);
-
-					// combine elasticity
-					float combinedElasticity = (sphereA->Rigidbody()->m_data.elasticity +
-												sphereB->Rigidbody()->m_data.elasticity / 2.0f);
-					// use Newton's third law to apply collision forces to colliding bodies 
-					sphereA->Rigidbody()->applyForceToAnotherBody(sphereB->Rigidbody(), forceVector + (forceVector*combinedElasticity));
-					
-					// apply torque
-					glm::vec3 centerPoint = sphereA->GetPosition() - sphereB->GetPosition();
-					glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
-
-					float torque = glm::dot(torqueLever, relativeVelocity) * 1.0f / (1.0f / sphereA->Rigidbody()->m_data.mass + 1.0f / sphereB->Rigidbody()->m_data.mass);
-					
-					sphereA->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f,-torque));
-					sphereB->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-					// move out spheres out of collision 
-					glm::vec3 separationVector = collisionNormal * distance * 0.5f;
-					sphereA->SetPosition(sphereA->GetPosition() - separationVector);
-					sphereB->SetPosition(sphereB->GetPosition() + separationVector);
-				}
-				// if one sphere is on the ground treat collsion as plane collision
-				if (onGroundA || onGroundB) 
-				{
-					// determine moving sphere
-					Sphere * sphere = (onGroundA ? sphereB : sphereA);
-					Sphere * sphereGround = (onGroundA ? sphereA : sphereB);
-					// calculate force vector
-					glm::vec3 forceVector = -1 * sphere->Rigidbody()->m_data.mass * collisionNormal * (glm::dot(collisionNormal, sphere->GetVelocity()));
-					// apply force
-					sphere->Rigidbody()->applyForce(forceVector * 2.0f);
-					// apply torque
-					glm::vec3 torqueLever = glm::normalize(glm::vec3(collisionNormal.y, -collisionNormal.x, 0.0f));
-
-					float torque =	glm::dot(torqueLever, sphere->GetVelocity()) * -1.0f /(1.0f / sphereA->Rigidbody()->m_data.mass);
-					sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-					// move out of collision
-					glm::vec3 separationVector = collisionNormal * distance * 0.5f;
-					sphere->SetPosition(sphere->GetPosition() - separationVector);
-					// stop other sphere from being on ground
-					sphereGround->Rigidbody()->m_data.onGround = false;
-				}
-			}
-			else 
+
+void PhysicsScene::detectContacts()
+{
+	JobSystem& jobSystem = JobSystem::getInstance();
+	if ((int)m_threadContacts.size() < jobSystem.numberOfThreads())
+	{
+		m_threadContacts.resize(jobSystem.numberOfThreads());
+	}
+	for (auto& threadContacts : m_threadContacts)
+	{
+		threadContacts.clear();
+	}
+
+	// group the pairs by type (counting sort, stable) so every kernel runs over a batch of one shape pair
+	int numberOfPairs = (int)m_narrowphasePairs.size();
+	int numberOfTypes = Narrowphase::numberOfPairTypes();
+	m_batchedTypes.resize(numberOfPairs);
+	m_batchStart.assign(numberOfTypes + 1, 0);
+	for (int i = 0; i < numberOfPairs; i++)
+	{
+		int pairType = Narrowphase::PairType(m_narrowphasePairs[i].objA, m_narrowphasePairs[i].objB);
+		m_batchedTypes[i] = pairType;
+		if (pairType >= 0)
+		{
+			m_batchStart[pairType + 1]++;
+		}
+	}
+	for (int type = 0; type < numberOfTypes; type++)
+	{
+		m_batchStart[type + 1] += m_batchStart[type];
+	}
+	int numberOfBatched = m_batchStart[numberOfTypes];
+	m_batchedPairs.resize(numberOfBatched);
+	m_batchedOrders.resize(numberOfBatched);
+	m_batchCursor.assign(m_batchStart.begin(), m_batchStart.end() - 1);
+	for (int i = 0; i < numberOfPairs; i++)
+	{
+		int pairType = m_batchedTypes[i];
+		if (pairType >= 0)
+		{
+			int slot = m_batchCursor[pairType]++;
+			m_batchedPairs[slot] = m_narrowphasePairs[i];
+			m_batchedOrders[slot] = i;
+		}
+	}
+
+	// detection only reads the bodies, any pair can run on any thread
+	jobSystem.ParallelFor(numberOfBatched, 64, [this, numberOfTypes](int begin, int end, int threadIndex)
+		{
+			std::vector<Contact>& contacts = m_threadContacts[threadIndex];
+			// a range can span a few batches, cut it at the batch ends
+			for (int type = 0; type < numberOfTypes && begin < end; type++)
 			{
-				// object colliding yes, stop objects
-				sphereA->SetVelocity(glm::vec3(0.0f));
-				sphereB->SetVelocity(glm::vec3(0.0f));
-				if (onGroundA || onGroundB) 
+				int batchEnd = std::min(end, m_batchStart[type + 1]);
+				if (begin < batchEnd)
 				{
-					sphereA->Rigidbody()->m_data.onGround = true;
-					sphereB->Rigidbody()->m_data.onGround = true;
+					Narrowphase::DetectBatch(type, &m_batchedPairs[begin], &m_batchedOrders[begin], batchEnd - begin, contacts);
+					begin = batchEnd;
 				}
 			}
-			return true;
-		}
+		});
+
+	// back to pair order, the result does not depend on how the pairs were split
+	m_contacts.clear();
+	for (const auto& threadContacts : m_threadContacts)
+	{
+		m_contacts.insert(m_contacts.end(), threadContacts.begin(), threadContacts.end());
 	}
-	return false;
+	std::sort(m_contacts.begin(), m_contacts.end(), [](const Contact& a, const Contact& b) { return a.order < b.order; });
 }
 
-bool PhysicsScene::sphereToPlane(PhysicsObject * a_sphere, PhysicsObject * a_plane)
+// header of the snapshot bytes
+static const uint32_t SnapshotMagic = 0x4E534850;	// "PHSN"
+static const uint32_t SnapshotVersion = 2;
+
+// cached contact in snapshot form, objects by their index in the scene
+struct SnapshotContact
 {
-	Sphere* sphere = dynamic_cast<Sphere*>(a_sphere);
-	Plane* plane = dynamic_cast<Plane*>(a_plane);
+	int32_t objA;
+	int32_t objB;
+	glm::vec3 normal;
+	float normalImpulse;
+	glm::vec3 tangentImpulse;
+};
 
-	if (sphere != nullptr && plane != nullptr) {
-		bool kinematic = sphere->Rigidbody()->m_data.isKinematic;
-		glm::vec3 planeNorm = plane->getNormal();
-		float planeDO = plane->getDistance();
-		// magnitude of sphere vector, plane normal
-		float mag = (dot(sphere->GetPosition(), planeNorm));
+void PhysicsScene::SaveSnapshot(PhysicsSnapshot& snapshot)
+{
+	snapshot.m_data.clear();
+	SnapshotWriter writer(snapshot.m_data);
+	writer.Write(SnapshotMagic);
+	writer.Write(SnapshotVersion);
+	writer.Write((uint32_t)m_allObjects.size());
+	writer.Write((uint32_t)m_bodyWorld.numberOfBodies());
+	writer.Write((int32_t)m_broadphaseType);
+	writer.Write(m_gravity);
+	writer.Write(m_accumulator);
+	writer.Write(m_interpolationAlpha);
+	writer.Write(m_lastStepTime);
 
-		// if planeNorm is below 0 magnitude will be negative
-		if (mag < 0)
+	// objects in scene order, the fixed size parts first so the bytes line up from one snapshot to the next
+	std::unordered_map<PhysicsObject*, int32_t> indexOf;
+	indexOf.reserve(m_allObjects.size());
+	for (int32_t index = 0; index < (int32_t)m_allObjects.size(); index++)
+	{
+		PhysicsObject* object = m_allObjects[index];
+		indexOf[object] = index;
+		RigidBody* body = object->Rigidbody();
+		bool inWorld = body != nullptr && body->getWorld() == &m_bodyWorld;
+		writer.Write((int32_t)(inWorld ? body->getIndex() : -1));
+		writer.Write((int32_t)object->GetProxyId());
+		if (body != nullptr)
 		{
-			planeNorm *= -1;
-			mag *= -1;
+			writer.Write(body->m_data);
 		}
+		if (object->getShapeID() == JOINT)
+		{
+			writer.Write(static_cast<Joint*>(object)->m_impulses);
+		}
+	}
+	// bodies made static or dynamic by updateStaticObject move between the static tree and the broadphase
+	std::vector<int32_t> dynamicObjects;
+	dynamicObjects.reserve(m_dynamicObjects.size());
+	for (PhysicsObject* object : m_dynamicObjects)
+	{
+		dynamicObjects.push_back(indexOf[object]);
+	}
+	writer.WriteArray(dynamicObjects);
+	m_bodyWorld.WriteState(writer);
 
-		float collision = mag - sphere->GetRadius();
-		// collision check
-		if (collision < 0.0f) {
-			if (!kinematic) {
-				// calculate force vector
-				glm::vec3 forceVector = -1 * sphere->Rigidbody()->m_data.mass * planeNorm * (glm::dot(planeNorm, sphere->GetVelocity()));
-				// combine elasticity
-				float combinedElasticity = (sphere->Rigidbody()->m_data.elasticity +
-											plane->getElasticity() / 2.0f);
-				// only bounce if not resting on the ground
-				if (!sphere->Rigidbody()->m_data.onGround) 
-				{
-					sphere->Rigidbody()->applyForce(forceVector + (forceVector*combinedElasticity));
-					// apply torque
-					glm::vec3 centerPoint = sphere->GetPosition() - planeNorm;
-					glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
+	// sorted so an unchanged cache gives the same bytes
+	m_solver.GetCache(m_cachedContacts);
+	std::vector<SnapshotContact> contacts;
+	contacts.reserve(m_cachedContacts.size());
+	for (const ContactSolver::CachedContact& contact : m_cachedContacts)
+	{
+		auto objA = indexOf.find(contact.objA);
+		auto objB = indexOf.find(contact.objB);
+		if (objA != indexOf.end() && objB != indexOf.end())
+		{
+			contacts.push_back({ objA->second, objB->second, contact.normal, contact.normalImpulse, contact.tangentImpulse });
+		}
+	}
+	std::sort(contacts.begin(), contacts.end(), [](const SnapshotContact& a, const SnapshotContact& b)
+		{
+			return a.objA != b.objA ? a.objA < b.objA : a.objB < b.objB;
+		});
+	writer.WriteArray(contacts);
 
-					float torque = glm::dot(torqueLever, sphere->GetVelocity()) * 1.0f / (1.0f / sphere->Rigidbody()->m_data.mass);
+	snapshot.m_broadphase = m_broadphase->Clone();
+	snapshot.m_staticBroadphase = m_staticBroadphase->Clone();
+}
 
-					sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
+bool PhysicsScene::RestoreSnapshot(const PhysicsSnapshot& snapshot)
+{
+	SnapshotReader reader(snapshot.m_data.data(), snapshot.m_data.size());
+	uint32_t magic = 0, version = 0, numberOfObjects = 0, numberOfBodies = 0;
+	int32_t broadphaseType = 0;
+	reader.Read(magic);
+	reader.Read(version);
+	reader.Read(numberOfObjects);
+	reader.Read(numberOfBodies);
+	reader.Read(broadphaseType);
+	if (reader.failed() || magic != SnapshotMagic || version != SnapshotVersion ||
+		numberOfObjects != m_allObjects.size() || numberOfBodies != (uint32_t)m_bodyWorld.numberOfBodies())
+	{
+		return false;
+	}
 
-					// move out of collision
-					glm::vec3 separationVector = planeNorm * collision * 0.5f;
-					sphere->SetPosition(sphere->GetPosition() - separationVector);
-				}
-			}
-			else 
+	// check the objects match before anything is overwritten
+	SnapshotReader objectReader = reader;
+	glm::vec3 gravity;
+	float steps[3];
+	objectReader.Read(gravity);
+	objectReader.Read(steps);
+	std::vector<RigidBody*> bodies(numberOfBodies, nullptr);
+	for (PhysicsObject* object : m_allObjects)
+	{
+		int32_t slot = -1, proxyId = -1;
+		objectReader.Read(slot);
+		objectReader.Read(proxyId);
+		RigidBody* body = object->Rigidbody();
+		bool inWorld = body != nullptr && body->getWorld() == &m_bodyWorld;
+		if (inWorld != (slot >= 0) || slot >= (int32_t)numberOfBodies || (slot >= 0 && bodies[slot] != nullptr))
+		{
+			return false;
+		}
+		if (slot >= 0)
+		{
+			bodies[slot] = body;
+		}
+		if (body != nullptr)
+		{
+			RigidBodyData data;
+			objectReader.Read(data);
+		}
+		if (object->getShapeID() == JOINT)
+		{
+			float impulses[Joint::MaxRows];
+			objectReader.Read(impulses);
+		}
+	}
+	// the dynamic bodies in broadphase order, each one a bounded body listed once
+	std::vector<int32_t> dynamicObjects;
+	std::vector<bool> isDynamic(numberOfObjects, false);
+	if (!objectReader.ReadArray(dynamicObjects))
+	{
+		return false;
+	}
+	for (int32_t index : dynamicObjects)
+	{
+		if (index < 0 || index >= (int32_t)numberOfObjects || isDynamic[index] || !InBroadphase(m_allObjects[index]))
+		{
+			return false;
+		}
+		isDynamic[index] = true;
+	}
+	// the body arrays and the contacts after them, a bad block must not leave the scene half restored
+	uint32_t numberOfContacts = 0;
+	if (objectReader.failed() || !RigidBodyWorld::CheckState(objectReader, numberOfBodies) ||
+		!objectReader.SkipArray<SnapshotContact>(numberOfContacts))
+	{
+		return false;
+	}
+
+	// then copy everything in
+	reader.Read(m_gravity);
+	reader.Read(m_accumulator);
+	reader.Read(m_interpolationAlpha);
+	reader.Read(m_lastStepTime);
+	for (PhysicsObject* object : m_allObjects)
+	{
+		int32_t slot = -1, proxyId = -1;
+		reader.Read(slot);
+		reader.Read(proxyId);
+		object->SetProxyId(proxyId);
+		if (object->Rigidbody() != nullptr)
+		{
+			reader.Read(object->Rigidbody()->m_data);
+		}
+		if (object->getShapeID() == JOINT)
+		{
+			reader.Read(static_cast<Joint*>(object)->m_impulses);
+		}
+	}
+	uint32_t numberOfDynamic = 0;
+	reader.SkipArray<int32_t>(numberOfDynamic);
+	m_dynamicObjects.clear();
+	for (int32_t index : dynamicObjects)
+	{
+		m_dynamicObjects.push_back(m_allObjects[index]);
+	}
+	if (!m_bodyWorld.ReadState(reader, bodies))
+	{
+		return false;
+	}
+
+	std::vector<SnapshotContact> contacts;
+	reader.ReadArray(contacts);
+	m_cachedContacts.clear();
+	for (const SnapshotContact& contact : contacts)
+	{
+		if (contact.objA >= 0 && contact.objA < (int32_t)numberOfObjects && contact.objB >= 0 && contact.objB < (int32_t)numberOfObjects)
+		{
+			m_cachedContacts.push_back({ m_allObjects[contact.objA], m_allObjects[contact.objB], contact.normal, contact.normalImpulse, contact.tangentImpulse });
+		}
+	}
+	m_solver.SetCache(m_cachedContacts);
+
+	// the copied structures come back as they were, with the proxy ids read above
+	if (snapshot.hasBroadphase())
+	{
+		m_broadphase = snapshot.m_broadphase->Clone();
+		m_staticBroadphase = snapshot.m_staticBroadphase->Clone();
+		m_broadphaseType = (BroadphaseType)broadphaseType;
+	}
+	else
+	{
+		// without them the bodies are inserted again, both are cleared first as either may hold any body
+		m_broadphase->Clear();
+		m_staticBroadphase->Clear();
+		for (uint32_t index = 0; index < numberOfObjects; index++)
+		{
+			if (!isDynamic[index] && InBroadphase(m_allObjects[index]))
 			{
-				// object colliding, stop object
-				sphere->SetVelocity(glm::vec3(0.0f));
-				sphere->Rigidbody()->m_data.onGround = true;
+				m_staticBroadphase->Insert(m_allObjects[index]);
 			}
-			return true;
 		}
+		rebuildBroadphase((BroadphaseType)broadphaseType);
 	}
-	return false;
+	return !reader.failed();
 }
 
-bool PhysicsScene::sphereToBox(PhysicsObject * a_sphere, PhysicsObject * a_box)
+void PhysicsScene::QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results)
 {
-	return boxToSphere(a_box, a_sphere);
+	syncBroadphase();
+	m_broadphase->QueryAABB(bounds, results);
+	m_staticBroadphase->QueryAABB(bounds, results);
 }
-/*********************************************************************************************************
-* Box to Object collsions
-**********************************************************************************************************/
-bool PhysicsScene::boxToSphere(PhysicsObject * a_box, PhysicsObject * a_sphere)
+
+// queries take directions of any length, a zero one casts nothing
+static bool NormalizeRay(const glm::vec3& direction, glm::vec3& rayDirection)
 {
-	Box* box = dynamic_cast<Box*>(a_box);
-	Sphere * sphere = dynamic_cast<Sphere*>(a_sphere);
+	float length = glm::length(direction);
+	if (length <= 0.0f)
+	{
+		return false;
+	}
+	rayDirection = direction / length;
+	return true;
+}
 
-	if (box != nullptr && sphere != nullptr) 
+bool PhysicsScene::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayCastHit& hit)
+{
+	glm::vec3 rayDirection;
+	if (!NormalizeRay(direction, rayDirection))
+	{
+		return false;
+	}
+	syncBroadphase();
+	return closestRayHit(origin, rayDirection, maxDistance, hit);
+}
+
+void PhysicsScene::RayCastBatch(const std::vector<RayQuery>& rays, std::vector<RayCastHit>& hits)
+{
+	syncBroadphase();
+	hits.resize(rays.size());
+	for (size_t index = 0; index < rays.size(); index++)
 	{
-		// collision check
-		if (box->checkCollision(sphere)) 
+		const RayQuery& ray = rays[index];
+		glm::vec3 rayDirection;
+		if (!NormalizeRay(ray.direction, rayDirection) || !closestRayHit(ray.origin, rayDirection, ray.maxDistance, hits[index]))
 		{
-			// cache some bools for later use
-			bool kinematicA = box->Rigidbody()->m_data.isKinematic;
-			bool kinematicB = sphere->Rigidbody()->m_data.isKinematic;
-			bool onGroundA = box->Rigidbody()->m_data.onGround;
-			bool onGroundB = sphere->Rigidbody()->m_data.onGround;
-			// check either is kinematic
-			if (!kinematicA || !kinematicB) 
+			hits[index] = RayCastHit();
+		}
+	}
+}
+
+bool PhysicsScene::closestRayHit(const glm::vec3& origin, const glm::vec3& rayDirection, float maxDistance, RayCastHit& hit)
+{
+	hit = RayCastHit();
+	float closest = maxDistance;
+	// the trees clip the ray to the closest hit so far, farther subtrees are skipped
+	RayCastCallback closestHit = [&](PhysicsObject* object, const glm::vec3& rayOrigin, const glm::vec3& rayDir, float rayMaxDistance)
+		{
+			float distance;
+			if (object->RayCast(rayOrigin, rayDir, rayMaxDistance, distance) && distance < closest)
 			{
-				glm::vec3 centerDist = sphere->GetPosition() - box->GetPosition();
-				glm::vec3 boxesMaxSize = glm::vec3(box->GetSize() + sphere->GetRadius());
-				glm::vec3 collisionNormal = glm::normalize(centerDist);
-				glm::vec3 overlap = abs(centerDist - boxesMaxSize);
-				// if both boxs are not on the ground
-				if (!onGroundA && !onGroundB) {
-					// calculate force vector
-					glm::vec3 relativeVelocity = box->GetVelocity() - sphere->GetVelocity();
-					glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
-					glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / box->Rigidbody()->m_data.mass + 1.0f / sphere->Rigidbody()->m_data.mass);
-					// combine elasticity
-					float combinedElasticity = (box->Rigidbody()->m_data.elasticity +
-												sphere->Rigidbody()->m_data.elasticity / 2.0f);
-					// use Newton's third law to apply collision forces to colliding bodies 
-					box->Rigidbody()->applyForceToAnotherBody(sphere->Rigidbody(), forceVector + (forceVector*combinedElasticity));
-
-					// apply torque
-					float torque = glm::dot(collisionVector, relativeVelocity) * 1.0f / (1.0f / box->Rigidbody()->m_data.mass + 1.0f / sphere->Rigidbody()->m_data.mass);
-
-					box->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-					sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-					// move out boxs out of collision 
-					glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-					box->SetPosition(box->GetPosition() - separationVector);
-					sphere->SetPosition(sphere->GetPosition() + separationVector);
-				}
-				// if one box is on the ground treat collision as plane collision
-				if (onGroundA || onGroundB) 
-				{
-					// determine moving box
-					PhysicsObject* obj = (onGroundA ? dynamic_cast<PhysicsObject*>(sphere) : dynamic_cast<PhysicsObject*>(box));
-					PhysicsObject* objGround = (onGroundA ? dynamic_cast<PhysicsObject*>(box) : dynamic_cast<PhysicsObject*>(sphere));
-					// calculate force vector
-					glm::vec3 forceVector = -1 * obj->Rigidbody()->m_data.mass * collisionNormal * (glm::dot(collisionNormal, obj->GetVelocity()));
-					// apply force
-					obj->Rigidbody()->applyForce(forceVector * 2.0f);
-					// move out of collision
-					glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-					obj->SetPosition(obj->GetPosition() - separationVector);
-					// stop other box from being on ground
-					objGround->Rigidbody()->m_data.onGround = objGround->Rigidbody()->m_data.isStatic ? true : false;
-				}
+				closest = distance;
+				hit.object = object;
+				return distance;
 			}
-			else 
+			return rayMaxDistance;
+		};
+	m_broadphase->RayCast(origin, rayDirection, maxDistance, closestHit);
+	m_staticBroadphase->RayCast(origin, rayDirection, closest, closestHit);
+
+	for (const std::vector<PhysicsObject*>* statics : { &m_planes, &m_heightfields })
+	{
+		for (PhysicsObject* object : *statics)
+		{
+			float distance;
+			if (object->RayCast(origin, rayDirection, closest, distance) && distance < closest)
 			{
-				// object colliding yes, stop objects
-				box->SetVelocity(glm::vec3(0.0f));
-				sphere->SetVelocity(glm::vec3(0.0f));
-				if (onGroundA || onGroundB) {
-					box->Rigidbody()->m_data.onGround = true;
-					sphere->Rigidbody()->m_data.onGround = true;
-				}
+				closest = distance;
+				hit.object = object;
 			}
-			return true;
 		}
 	}
-	return false;
+
+	if (hit.object == nullptr)
+	{
+		return false;
+	}
+	hit.distance = closest;
+	hit.point = origin + rayDirection * closest;
+	return true;
 }
 
-bool PhysicsScene::boxToPlane(PhysicsObject* a_box, PhysicsObject* a_plane)
+bool PhysicsScene::RayCastAny(const glm::vec3& origin, const glm::vec3& direction, float maxDistance)
 {
-	Box* box = dynamic_cast<Box*>(a_box);
-	Plane* plane = dynamic_cast<Plane*>(a_plane);
-
-	if (box != nullptr && plane != nullptr) 
+	glm::vec3 rayDirection;
+	if (!NormalizeRay(direction, rayDirection))
 	{
-		glm::vec3 planeNormal = plane->getNormal();
-		glm::vec3 center = box->GetPosition();
-		glm::vec3 extents(box->GetSize());
-		// magnitude of box center and plane vectors
-		float mag = dot(planeNormal, center);
-		// projection interval radius of box onto the plane
-		float radius = extents.x * abs(planeNormal.x) + extents.y * abs(planeNormal.y) + extents.z * abs(planeNormal.z);
+		return false;
+	}
+	syncBroadphase();
 
-		// if planeNorm is below 0 magnitude will be negative
-		if (mag < 0)
+	for (const std::vector<PhysicsObject*>* statics : { &m_planes, &m_heightfields })
+	{
+		for (PhysicsObject* object : *statics)
 		{
-			planeNormal *= -1;
-			mag *= -1;
+			float distance;
+			if (object->RayCast(origin, rayDirection, maxDistance, distance))
+			{
+				return true;
+			}
 		}
+	}
 
-		float collision = mag - radius;
-
-		// collision check
-		if (collision <= 0.0f) 
+	bool found = false;
+	RayCastCallback anyHit = [&](PhysicsObject* object, const glm::vec3& rayOrigin, const glm::vec3& rayDir, float rayMaxDistance)
 		{
-			// cache some data
-			bool kinematic = box->Rigidbody()->m_data.isKinematic;
-			if (!kinematic) {
-				// calculate force vector
-				glm::vec3 forceVector = -1 * box->Rigidbody()->m_data.mass * planeNormal * (glm::dot(planeNormal, box->GetVelocity()));
-				// combine elasticity
-				float combinedElasticity = (box->Rigidbody()->m_data.elasticity +
-											plane->getElasticity() / 2.0f);
-				// only bounce if not resting on the ground
-				if (!box->Rigidbody()->m_data.onGround) {
-					// apply force
-					box->Rigidbody()->applyForce(forceVector + (forceVector*combinedElasticity));
+			float distance;
+			found = object->RayCast(rayOrigin, rayDir, rayMaxDistance, distance);
+			// 0 ends the query
+			return found ? 0.0f : rayMaxDistance;
+		};
+	m_staticBroadphase->RayCast(origin, rayDirection, maxDistance, anyHit);
+	if (!found)
+	{
+		m_broadphase->RayCast(origin, rayDirection, maxDistance, anyHit);
+	}
+	return found;
+}
 
-					// apply torque
-					glm::vec3 centerPoint = box->GetPosition() - planeNormal;
-					glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
-					float torque = glm::dot(torqueLever, box->GetVelocity()) * 1.0f / (1.0f / box->Rigidbody()->m_data.mass);
-					box->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
+/*********************************************************************************************************
+* Shape queries
+**********************************************************************************************************/
+static bool SphereOverlaps(PhysicsObject* object, const glm::vec3& center, float radius)
+{
+	switch (object->getShapeID())
+	{
+	case SPHERE:
+	{
+		Sphere* sphere = static_cast<Sphere*>(object);
+		float totalRadius = sphere->GetRadius() + radius;
+		glm::vec3 offset = sphere->GetPosition() - center;
+		return glm::dot(offset, offset) <= totalRadius * totalRadius;
+	}
+	case BOX:
+	{
+		Box* box = static_cast<Box*>(object);
+		return Box::distPointToBox(box->GetPosition(), box->GetSize(), center) <= radius;
+	}
+	case PLANE:
+		return std::abs(glm::dot(center, static_cast<Plane*>(object)->getNormal())) <= radius;
+	case HEIGHTFIELD:
+	{
+		glm::vec3 normal;
+		float distance;
+		return static_cast<Heightfield*>(object)->SphereContact(center, radius, normal, distance);
+	}
+	default:
+		return false;
+	}
+}
 
-					// move out of collision
-					glm::vec3 separationVector = planeNormal * collision * 0.5f;
-					box->SetPosition(box->GetPosition() - separationVector);
-				}
-			}
-			else {
-				// object colliding, stop object
-				box->SetVelocity(glm::vec3(0.0f));
-				box->Rigidbody()->m_data.onGround = true;
-			}
+static bool BoxOverlaps(PhysicsObject* object, const glm::vec3& center, const glm::vec3& halfExtents)
+{
+	switch (object->getShapeID())
+	{
+	case SPHERE:
+	{
+		Sphere* sphere = static_cast<Sphere*>(object);
+		return Box::distPointToBox(center, halfExtents, sphere->GetPosition()) <= sphere->GetRadius();
+	}
+	case BOX:
+	{
+		// boxes stay axis aligned
+		Box* box = static_cast<Box*>(object);
+		return AABB::FromCenterExtents(box->GetPosition(), box->GetSize()).Overlaps(AABB::FromCenterExtents(center, halfExtents));
+	}
+	case PLANE:
+	{
+		glm::vec3 normal = static_cast<Plane*>(object)->getNormal();
+		return std::abs(glm::dot(center, normal)) <= glm::dot(halfExtents, glm::abs(normal));
+	}
+	case HEIGHTFIELD:
+	{
+		glm::vec3 normal;
+		float distance;
+		return static_cast<Heightfield*>(object)->BoxContact(center, halfExtents, normal, distance);
+	}
+	default:
+		return false;
+	}
+}
+
+// the continuous sweep grows the box with square corners, walk the sphere on until it touches the rounded one
+static bool RefineBoxSweep(const glm::vec3& origin, const glm::vec3& motion, float radius, Box* box, float& toi)
+{
+	float length = glm::length(motion);
+	for (int i = 0; i < 32; i++)
+	{
+		float gap = Box::distPointToBox(box->GetPosition(), box->GetSize(), origin + motion * toi) - radius;
+		if (gap <= 1e-4f * radius)
+		{
 			return true;
 		}
+		toi += gap / length;
+		if (toi > 1.0f)
+		{
+			return false;
+		}
 	}
+	// still closing in, a grazing pass
 	return false;
 }
 
-bool PhysicsScene::boxToBox(PhysicsObject* a_boxA, PhysicsObject* a_boxB)
+bool PhysicsScene::SphereCast(const glm::vec3& origin, float radius, const glm::vec3& direction, float maxDistance, RayCastHit& hit)
 {
-	Box* boxA = dynamic_cast<Box*>(a_boxA);
-	Box* boxB = dynamic_cast<Box*>(a_boxB);
+	hit = RayCastHit();
+	glm::vec3 rayDirection;
+	if (!NormalizeRay(direction, rayDirection))
+	{
+		return false;
+	}
+	syncBroadphase();
 
-	if (boxA != nullptr && boxB != nullptr) 
+	// everything the sphere can reach on its way, then the exact sweep of each
+	glm::vec3 motion = rayDirection * maxDistance;
+	AABB swept = AABB::Union(AABB::FromCenterExtents(origin, glm::vec3(radius)), AABB::FromCenterExtents(origin + motion, glm::vec3(radius)));
+	m_queryCandidates.clear();
+	m_broadphase->QueryAABB(swept, m_queryCandidates);
+	m_staticBroadphase->QueryAABB(swept, m_queryCandidates);
+	m_queryCandidates.insert(m_queryCandidates.end(), m_planes.begin(), m_planes.end());
+	m_queryCandidates.insert(m_queryCandidates.end(), m_heightfields.begin(), m_heightfields.end());
+
+	float closest = 1.0f;
+	for (PhysicsObject* object : m_queryCandidates)
 	{
-		// collision check
-		if (boxA->checkCollision(boxB)) 
+		// the sweep skips what the sphere starts in
+		float toi;
+		if (SphereOverlaps(object, origin, radius))
 		{
-			// cache some bools for later use
-			bool kinematicA = boxA->Rigidbody()->m_data.isKinematic;
-			bool kinematicB = boxB->Rigidbody()->m_data.isKinematic;
-			bool onGroundA = boxA->Rigidbody()->m_data.onGround;
-			bool onGroundB = boxB->Rigidbody()->m_data.onGround;
-			// check either is kinematic
-			if (!kinematicA || !kinematicB) {
-				glm::vec3 centerDist = boxB->GetPosition() - boxA->GetPosition();
-				glm::vec3 boxesMaxSize = glm::vec3(boxA->GetSize() + boxB->GetSize());
-				glm::vec3 collisionNormal = glm::normalize(centerDist);
-				glm::vec3 overlap = abs(centerDist - boxesMaxSize);
-				// if both boxs are not on the ground
-				if (!onGroundA && !onGroundB) 
-				{
-					// calculate force vector
-					glm::vec3 relativeVelocity = boxA->GetVelocity() - boxB->GetVelocity();
-					glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
-					glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / boxA->Rigidbody()->m_data.mass + 1.0f / boxB->Rigidbody()->m_data.mass);
-					// combine elasticity
-					float combinedElasticity = (boxA->Rigidbody()->m_data.elasticity +
-												boxB->Rigidbody()->m_data.elasticity / 2.0f);
-					// use Newton's third law to apply collision forces to colliding bodies 
-					boxA->Rigidbody()->applyForceToAnotherBody(boxB->Rigidbody(), forceVector + (forceVector*combinedElasticity));
-
-					// apply torque
-					float torque = glm::dot(collisionVector, relativeVelocity) * 1.0f / (1.0f / boxA->Rigidbody()->m_data.mass + 1.0f / boxB->Rigidbody()->m_data.mass);
-
-					boxA->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-					boxB->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-					// move out boxs out of collision 
-					glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-					boxA->SetPosition(boxA->GetPosition() - separationVector);
-					boxB->SetPosition(boxB->GetPosition() + separationVector);
-				}
-				// if one box is on the ground treat collsion as plane collision
-				if (onGroundA || onGroundB) 
-				{
-					// determine moving box
-					Box* box = (onGroundA ? boxB : boxA);
-					Box* boxGround = (onGroundA ? boxA : boxB);
-					// calculate force vector
-					glm::vec3 forceVector = -1 * box->Rigidbody()->m_data.mass * collisionNormal * (glm::dot(collisionNormal, box->GetVelocity()));
-					// apply force
-					box->Rigidbody()->applyForce(forceVector * 2.0f);
-					// move out of collision
-					glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-					box->SetPosition(box->GetPosition() - separationVector);
-					// stop other box from being on ground
-					boxGround->Rigidbody()->m_data.onGround = false;
-				}
-			}
-			else 
+			toi = 0.0f;
+		}
+		else if (!ContinuousCollision::SweepSphere(origin, motion, radius, object, toi) ||
+			(object->getShapeID() == BOX && !RefineBoxSweep(origin, motion, radius, static_cast<Box*>(object), toi)))
+		{
+			continue;
+		}
+		if (hit.object == nullptr || toi < closest)
+		{
+			closest = toi;
+			hit.object = object;
+			if (toi == 0.0f)
 			{
-				// object colliding yes, stop objects
-				boxA->SetVelocity(glm::vec3(0.0f));
-				boxB->SetVelocity(glm::vec3(0.0f));
-				if (onGroundA || onGroundB) {
-					boxA->Rigidbody()->m_data.onGround = true;
-					boxB->Rigidbody()->m_data.onGround = true;
-				}
+				break;
 			}
-			return true;
 		}
 	}
+
+	if (hit.object == nullptr)
+	{
+		return false;
+	}
+	hit.distance = closest * maxDistance;
+	hit.point = origin + motion * closest;
+	return true;
+}
+
+void PhysicsScene::OverlapSphere(const glm::vec3& center, float radius, std::vector<PhysicsObject*>& results)
+{
+	syncBroadphase();
+	m_queryCandidates.clear();
+	m_broadphase->QueryAABB(AABB::FromCenterExtents(center, glm::vec3(radius)), m_queryCandidates);
+	m_staticBroadphase->QueryAABB(AABB::FromCenterExtents(center, glm::vec3(radius)), m_queryCandidates);
+	m_queryCandidates.insert(m_queryCandidates.end(), m_planes.begin(), m_planes.end());
+	m_queryCandidates.insert(m_queryCandidates.end(), m_heightfields.begin(), m_heightfields.end());
+	for (PhysicsObject* object : m_queryCandidates)
+	{
+		if (SphereOverlaps(object, center, radius))
+		{
+			results.push_back(object);
+		}
+	}
+}
+
+void PhysicsScene::OverlapBox(const glm::vec3& center, const glm::vec3& halfExtents, std::vector<PhysicsObject*>& results)
+{
+	syncBroadphase();
+	m_queryCandidates.clear();
+	m_broadphase->QueryAABB(AABB::FromCenterExtents(center, halfExtents), m_queryCandidates);
+	m_staticBroadphase->QueryAABB(AABB::FromCenterExtents(center, halfExtents), m_queryCandidates);
+	m_queryCandidates.insert(m_queryCandidates.end(), m_planes.begin(), m_planes.end());
+	m_queryCandidates.insert(m_queryCandidates.end(), m_heightfields.begin(), m_heightfields.end());
+	for (PhysicsObject* object : m_queryCandidates)
+	{
+		if (BoxOverlaps(object, center, halfExtents))
+		{
+			results.push_back(object);
+		}
+	}
+}
+
+bool PhysicsScene::dispatchCollision(PhysicsObject* objA, PhysicsObject* objB)
+{
+	Contact contact;
+	if (detectCollision(objA, objB, contact))
+	{
+		resolveContact(contact);
+		return true;
+	}
 	return false;
 }
+
+bool PhysicsScene::detectCollision(PhysicsObject* objA, PhysicsObject* objB, Contact& contact)
+{
+	return Narrowphase::Detect(objA, objB, contact);
+}
+
+void PhysicsScene::resolveContact(const Contact& contact)
+{
+	switch (contact.type)
+	{
+	case ContactType::SphereSphere:
+		resolveSphereToSphere(contact);
+		break;
+	case ContactType::SpherePlane:
+	case ContactType::SphereHeightfield:
+		resolveSphereToPlane(contact);
+		break;
+	case ContactType::BoxSphere:
+		resolveBoxToSphere(contact);
+		break;
+	case ContactType::BoxPlane:
+	case ContactType::BoxHeightfield:
+		resolveBoxToPlane(contact);
+		break;
+	case ContactType::BoxBox:
+		resolveBoxToBox(contact);
+		break;
+	}
+}
+/*********************************************************************************************************
+* Sphere to Object collsions
+**********************************************************************************************************/
+void PhysicsScene::resolveSphereToSphere(const Contact& contact)
+{
+	Sphere* sphereA = static_cast<Sphere*>(contact.objA);
+	Sphere* sphereB = static_cast<Sphere*>(contact.objB);
+	glm::vec3 collisionNormal = contact.normal;
+	float distance = contact.distance;
+
+	// cahce bool values
+	bool kinematicA = sphereA->Rigidbody()->isKinematic();
+	bool kinematicB = sphereB->Rigidbody()->isKinematic();
+	bool onGroundA = sphereA->Rigidbody()->isOnGround();
+	bool onGroundB = sphereB->Rigidbody()->isOnGround();
+	// check either is kinematic
+	if (!kinematicA || !kinematicB) {
+		// if both spheres are not on the ground
+		if (!onGroundA && !onGroundB) {
+			// calculate force vector
+			glm::vec3 relativeVelocity = sphereA->GetVelocity() - sphereB->GetVelocity();
+			glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
+			glm::vec3 forceVector =	collisionVector * 1.0f / (1.0f / sphereA->Rigidbody()->getMass() + 1.0f / sphereB->Rigidbody()->getMass());
+
+			// combine elasticity
+			float combinedElasticity = (sphereA->Rigidbody()->m_data.elasticity +
+										sphereB->Rigidbody()->m_data.elasticity / 2.0f);
+			// use Newton's third law to apply collision forces to colliding bodies 
+			sphereA->Rigidbody()->applyForceToAnotherBody(sphereB->Rigidbody(), forceVector + (forceVector*combinedElasticity));
+			
+			// apply torque
+			glm::vec3 centerPoint = sphereA->GetPosition() - sphereB->GetPosition();
+			glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
+
+			float torque = glm::dot(torqueLever, relativeVelocity) * 1.0f / (1.0f / sphereA->Rigidbody()->getMass() + 1.0f / sphereB->Rigidbody()->getMass());
+			
+			sphereA->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f,-torque));
+			sphereB->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
+
+			// move out spheres out of collision 
+			glm::vec3 separationVector = collisionNormal * distance * 0.5f;
+			sphereA->SetPosition(sphereA->GetPosition() - separationVector);
+			sphereB->SetPosition(sphereB->GetPosition() + separationVector);
+		}
+		// if one sphere is on the ground treat collsion as plane collision
+		if (onGroundA || onGroundB) 
+		{
+			// determine moving sphere
+			Sphere * sphere = (onGroundA ? sphereB : sphereA);
+			Sphere * sphereGround = (onGroundA ? sphereA : sphereB);
+			// calculate force vector
+			glm::vec3 forceVector = -1 * sphere->Rigidbody()->getMass() * collisionNormal * (glm::dot(collisionNormal, sphere->GetVelocity()));
+			// apply force
+			sphere->Rigidbody()->applyForce(forceVector * 2.0f);
+			// apply torque
+			glm::vec3 torqueLever = glm::normalize(glm::vec3(collisionNormal.y, -collisionNormal.x, 0.0f));
+
+			float torque =	glm::dot(torqueLever, sphere->GetVelocity()) * -1.0f /(1.0f / sphereA->Rigidbody()->getMass());
+			sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
+
+			// move out of collision
+			glm::vec3 separationVector = collisionNormal * distance * 0.5f;
+			sphere->SetPosition(sphere->GetPosition() - separationVector);
+			// stop other sphere from being on ground
+			sphereGround->Rigidbody()->setOnGround(false);
+		}
+	}
+	else 
+	{
+		// object colliding yes, stop objects
+		sphereA->SetVelocity(glm::vec3(0.0f));
+		sphereB->SetVelocity(glm::vec3(0.0f));
+		if (onGroundA || onGroundB) 
+		{
+			sphereA->Rigidbody()->setOnGround(true);
+			sphereB->Rigidbody()->setOnGround(true);
+		}
+	}
+}
+
+void PhysicsScene::resolveSphereToPlane(const Contact& contact)
+{
+	// heightfield contacts carry the surface normal under the sphere, they resolve like a plane
+	Sphere* sphere = static_cast<Sphere*>(contact.objA);
+	glm::vec3 planeNorm = contact.normal;
+	float collision = contact.distance;
+
+	bool kinematic = sphere->Rigidbody()->isKinematic();
+	if (!kinematic) {
+		// calculate force vector
+		glm::vec3 forceVector = -1 * sphere->Rigidbody()->getMass() * planeNorm * (glm::dot(planeNorm, sphere->GetVelocity()));
+		// combine elasticity
+		float combinedElasticity = (sphere->Rigidbody()->m_data.elasticity +
+									SurfaceElasticity(contact.objB) / 2.0f);
+		// only bounce if not resting on the ground
+		if (!sphere->Rigidbody()->isOnGround()) 
+		{
+			sphere->Rigidbody()->applyForce(forceVector + (forceVector*combinedElasticity));
+			// apply torque
+			glm::vec3 centerPoint = sphere->GetPosition() - planeNorm;
+			glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
+
+			float torque = glm::dot(torqueLever, sphere->GetVelocity()) * 1.0f / (1.0f / sphere->Rigidbody()->getMass());
+
+			sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
+
+			// move out of collision
+			glm::vec3 separationVector = planeNorm * collision * 0.5f;
+			sphere->SetPosition(sphere->GetPosition() - separationVector);
+		}
+	}
+	else 
+	{
+		// object colliding, stop object
+		sphere->SetVelocity(glm::vec3(0.0f));
+		sphere->Rigidbody()->setOnGround(true);
+	}
 }
 
+/*********************************************************************************************************
+* Box to Object collsions
+**********************************************************************************************************/
+void PhysicsScene::resolveBoxToSphere(const Contact& contact)
+{
+	Box* box = static_cast<Box*>(contact.objA);
+	Sphere* sphere = static_cast<Sphere*>(contact.objB);
+	glm::vec3 collisionNormal = contact.normal;
+	glm::vec3 overlap = contact.overlap;
+
+	// cache some bools for later use
+	bool kinematicA = box->Rigidbody()->isKinematic();
+	bool kinematicB = sphere->Rigidbody()->isKinematic();
+	// a static body is treated as ground, it is neither pushed nor moved
+	bool onGroundA = box->Rigidbody()->isOnGround() || box->Rigidbody()->isStatic();
+	bool onGroundB = sphere->Rigidbody()->isOnGround() || sphere->Rigidbody()->isStatic();
+	// check either is kinematic
+	if (!kinematicA || !kinematicB) 
+	{
+		// if both boxs are not on the ground
+		if (!onGroundA && !onGroundB) {
+			// calculate force vector
+			glm::vec3 relativeVelocity = box->GetVelocity() - sphere->GetVelocity();
+			glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
+			glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / box->Rigidbody()->getMass() + 1.0f / sphere->Rigidbody()->getMass());
+			// combine elasticity
+			float combinedElasticity = (box->Rigidbody()->m_data.elasticity +
+										sphere->Rigidbody()->m_data.elasticity / 2.0f);
+			// use Newton's third law to apply collision forces to colliding bodies 
+			box->Rigidbody()->applyForceToAnotherBody(sphere->Rigidbody(), forceVector + (forceVector*combinedElasticity));
+
+			// apply torque
+			float torque = glm::dot(collisionVector, relativeVelocity) * 1.0f / (1.0f / box->Rigidbody()->getMass() + 1.0f / sphere->Rigidbody()->getMass());
+
+			box->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
+			sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
+
+			// move out boxs out of collision 
+			glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
+			box->SetPosition(box->GetPosition() - separationVector);
+			sphere->SetPosition(sphere->GetPosition() + separationVector);
+		}
+		// if one box is on the ground treat collision as plane collision
+		if (onGroundA || onGroundB) 
+		{
+			// determine moving box, never the static one
+			bool groundA = onGroundA && !sphere->Rigidbody()->isStatic();
+			PhysicsObject* obj = (groundA ? static_cast<PhysicsObject*>(sphere) : static_cast<PhysicsObject*>(box));
+			PhysicsObject* objGround = (groundA ? static_cast<PhysicsObject*>(box) : static_cast<PhysicsObject*>(sphere));
+			// calculate force vector
+			glm::vec3 forceVector = -1 * obj->Rigidbody()->getMass() * collisionNormal * (glm::dot(collisionNormal, obj->GetVelocity()));
+			// apply force
+			obj->Rigidbody()->applyForce(forceVector * 2.0f);
+			// move out of collision
+			glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
+			obj->SetPosition(obj->GetPosition() - separationVector);
+			// stop other box from being on ground
+			objGround->Rigidbody()->setOnGround(objGround->Rigidbody()->isStatic() ? true : false);
+		}
+	}
+	else 
+	{
+		// object colliding yes, stop objects
+		box->SetVelocity(glm::vec3(0.0f));
+		sphere->SetVelocity(glm::vec3(0.0f));
+		if (onGroundA || onGroundB) {
+			box->Rigidbody()->setOnGround(true);
+			sphere->Rigidbody()->setOnGround(true);
+		}
+	}
+}
+
+void PhysicsScene::resolveBoxToPlane(const Contact& contact)
+{
+	Box* box = static_cast<Box*>(contact.objA);
+	glm::vec3 planeNormal = contact.normal;
+	float collision = contact.distance;
+
+	// cache some data
+	bool kinematic = box->Rigidbody()->isKinematic();
+	if (!kinematic) {
+		// calculate force vector
+		glm::vec3 forceVector = -1 * box->Rigidbody()->getMass() * planeNormal * (glm::dot(planeNormal, box->GetVelocity()));
+		// combine elasticity
+		float combinedElasticity = (box->Rigidbody()->m_data.elasticity +
+									SurfaceElasticity(contact.objB) / 2.0f);
+		// only bounce if not resting on the ground
+		if (!box->Rigidbody()->isOnGround()) {
+			// apply force
+			box->Rigidbody()->applyForce(forceVector + (forceVector*combinedElasticity));
+
+			// apply torque
+			glm::vec3 centerPoint = box->GetPosition() - planeNormal;
+			glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
+			float torque = glm::dot(torqueLever, box->GetVelocity()) * 1.0f / (1.0f / box->Rigidbody()->getMass());
+			box->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
+
+			// move out of collision
+			glm::vec3 separationVector = planeNormal * collision * 0.5f;
+			box->SetPosition(box->GetPosition() - separationVector);
+		}
+	}
+	else {
+		// object colliding, stop object
+		box->SetVelocity(glm::vec3(0.0f));
+		box->Rigidbody()->setOnGround(true);
+	}
+}
+
+void PhysicsScene::resolveBoxToBox(const Contact& contact)
+{
+	Box* boxA = static_cast<Box*>(contact.objA);
+	Box* boxB = static_cast<Box*>(contact.objB);
+	glm::vec3 collisionNormal = contact.normal;
+	glm::vec3 overlap = contact.overlap;
+
+	// cache some bools for later use
+	bool kinematicA = boxA->Rigidbody()->isKinematic();
+	bool kinematicB = boxB->Rigidbody()->isKinematic();
+	// a static body is treated as ground, it is neither pushed nor moved
+	bool onGroundA = boxA->Rigidbody()->isOnGround() || boxA->Rigidbody()->isStatic();
+	bool onGroundB = boxB->Rigidbody()->isOnGround() || boxB->Rigidbody()->isStatic();
+	// check either is kinematic
+	if (!kinematicA || !kinematicB) {
+		// if both boxs are not on the ground
+		if (!onGroundA && !onGroundB) 
+		{
+			// calculate force vector
+			glm::vec3 relativeVelocity = boxA->GetVelocity() - boxB->GetVelocity();
+			glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
+			glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / boxA->Rigidbody()->getMass() + 1.0f / boxB->Rigidbody()->getMass());
+			// combine elasticity
+			float combinedElasticity = (boxA->Rigidbody()->m_data.elasticity +
+										boxB->Rigidbody()->m_data.elasticity / 2.0f);
+			// use Newton's third law to apply collision forces to colliding bodies 
+			boxA->Rigidbody()->applyForceToAnotherBody(boxB->Rigidbody(), forceVector + (forceVector*combinedElasticity));
+
+			// apply torque
+			float torque = glm::dot(collisionVector, relativeVelocity) * 1.0f / (1.0f / boxA->Rigidbody()->getMass() + 1.0f / boxB->Rigidbody()->getMass());
+
+			boxA->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
+			boxB->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
+
+			// move out boxs out of collision 
+			glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
+			boxA->SetPosition(boxA->GetPosition() - separationVector);
+			boxB->SetPosition(boxB->GetPosition() + separationVector);
+		}
+		// if one box is on the ground treat collsion as plane collision
+		if (onGroundA || onGroundB) 
+		{
+			// determine moving box, never the static one
+			bool groundA = onGroundA && !boxB->Rigidbody()->isStatic();
+			Box* box = (groundA ? boxB : boxA);
+			Box* boxGround = (groundA ? boxA : boxB);
+			// calculate force vector
+			glm::vec3 forceVector = -1 * box->Rigidbody()->getMass() * collisionNormal * (glm::dot(collisionNormal, box->GetVelocity()));
+			// apply force
+			box->Rigidbody()->applyForce(forceVector * 2.0f);
+			// move out of collision
+			glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
+			box->SetPosition(box->GetPosition() - separationVector);
+			// stop other box from being on ground
+			boxGround->Rigidbody()->setOnGround(boxGround->Rigidbody()->isStatic());
+		}
+	}
+	else 
+	{
+		// object colliding yes, stop objects
+		boxA->SetVelocity(glm::vec3(0.0f));
+		boxB->SetVelocity(glm::vec3(0.0f));
+		if (onGroundA || onGroundB) {
+			boxA->Rigidbody()->setOnGround(true);
+			boxB->Rigidbody()->setOnGround(true);
+		}
+	}
+}
+}
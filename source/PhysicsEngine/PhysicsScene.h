@@ -1,18 +1,114 @@
 #pragma once
 #include <vector>
-#include "glm\glm.hpp"
+#include <memory>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+#include "Broadphase.h"
+#include "RigidBodyWorld.h"
+#include "Contact.h"
+#include "IslandGraph.h"
+#include "ContactSolver.h"
+#include "PhysicsSnapshot.h"
 
 namespace ntn
 {
 
+enum class BroadphaseType
+{
+	SweepAndPrune = 0,
+	DynamicTree = 1,
+	SpatialHash = 2
+};
+
+enum class ContactResponse
+{
+	Forces = 0,				// per pair forces and separation of the resolve* functions
+	SequentialImpulse = 1	// ContactSolver
+};
+
 struct PhysicsProperties
 {
 	bool gravity = false;
 	bool collisions = false;
 	bool collisionResponse = false;
+	// can be switched at runtime, the bodies move to the new broadphase on the next update
+	BroadphaseType broadphase = BroadphaseType::DynamicTree;
+	// an island falls asleep once all its bodies stayed slower than sleepVelocity for sleepFrames steps
+	bool sleeping = true;
+	int sleepFrames = 60;
+	float sleepVelocity = 0.1f;
+	// bodies moving farther than ccdMotionThreshold times their size in a step are swept to their first impact
+	bool continuousCollisions = true;
+	float ccdMotionThreshold = 0.5f;
+	ContactResponse response = ContactResponse::SequentialImpulse;
+	ContactSolverSettings solver;
+
+	PhysicsProperties() = default;
+	PhysicsProperties(bool gravity_, bool collisions_, bool collisionResponse_) :
+		gravity(gravity_), collisions(collisions_), collisionResponse(collisionResponse_) {};
+};
+
+// pair counters of the last collision pass
+struct CollisionStats
+{
+	int64_t candidatePairs = 0;	// pairs a brute force pass would test, n^2 outgrows an int
+	int testedPairs = 0;	// pairs that reached the narrowphase
+	int contacts = 0;		// narrowphase hits
+	int sweptBodies = 0;	// fast bodies that ran a swept test
+	int sweptHits = 0;		// fast bodies moved back to their first impact
+	int manifolds = 0;		// contacts the solver worked on
+	int warmStarted = 0;	// manifolds that started from the impulses of the last step
+	int joints = 0;			// joints the solver worked on
+	int colors = 0;			// constraint batches solved one after the other, each one in parallel
+
+	float PruningRatio() const { return candidatePairs > 0 ? (float)(1.0 - (double)testedPairs / (double)candidatePairs) : 0.0f; }
+};
+
+// wall time of the phases of the last Update in milliseconds, summed over its sub-steps
+struct PhysicsTimings
+{
+	float integrate = 0.0f;
+	float broadphase = 0.0f;	// refit and pair search
+	float continuous = 0.0f;	// swept tests of the fast bodies
+	float narrowphase = 0.0f;
+	float response = 0.0f;
+	float islands = 0.0f;		// waking, island building and sleeping
+	float total = 0.0f;
+};
+
+// counters of one Update, what a PhysicsProfiler records
+struct PhysicsProfileSample
+{
+	uint64_t update = 0;		// updates since the scene was created
+	int steps = 0;				// fixed steps the update ran
+	PhysicsTimings timings;
+	CollisionStats stats;
+	int bodies = 0;
+	int sleepingBodies = 0;
+	int islands = 0;
+	uint64_t allocations = 0;	// heap allocations of the update, job system workers included
+	uint64_t allocatedBytes = 0;
+};
+
+// closest hit of a ray query
+struct RayCastHit
+{
+	PhysicsObject* object = nullptr;
+	float distance = 0.0f;
+	glm::vec3 point = glm::vec3(0.0f);	// where the ray hit, the center of the sphere at impact for sphere casts
+};
+
+// one ray of a batch
+struct RayQuery
+{
+	glm::vec3 origin = glm::vec3(0.0f);
+	glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+	float maxDistance = 0.0f;
 };
 
 class PhysicsObject;
+class RigidBody;
 
 class PhysicsScene
 {
@@ -25,8 +121,14 @@ public:
 	void addObject(PhysicsObject* object);
 	void removeObject(PhysicsObject* object);
 
-	std::vector<PhysicsObject*> getAllObjects() { return m_allObjects; };
+	const std::vector<PhysicsObject*>& getAllObjects() const { return m_allObjects; };
 	int numberOfObjects() { return m_allObjects.size(); }
+	// changes whenever objects are added or removed
+	uint64_t getLayoutVersion() const { return m_layoutVersion; }
+	// bodies static when added go to a tree that is never refit, call this after moving one
+	// or turning it dynamic so it lands in the right structure
+	void updateStaticObject(PhysicsObject* object);
+	int numberOfStaticBodies() const { return m_staticBroadphase->numberOfProxies(); }
 
 	void resetScene();
 	void clearScene();
@@ -34,23 +136,61 @@ public:
 	void setGravity(const glm::vec3 gravity) { m_gravity = gravity; }
 	glm::vec3 getGravity() const { return m_gravity; }
 
+	// the simulation always advances by this step, frame time is accumulated
 	void setTimeStep(const float timeStep) { m_timeStep = timeStep; }
-	float setTimeStep() const { return m_timeStep; }
+	float getTimeStep() const { return m_timeStep; }
+	// steps allowed per Update, the time left over after the cap is dropped
+	void setMaxSubSteps(const int maxSubSteps) { m_maxSubSteps = maxSubSteps; }
+	int getMaxSubSteps() const { return m_maxSubSteps; }
+	// fraction of a step left in the accumulator, used to blend the last two states when rendering
+	float getInterpolationAlpha() const { return m_interpolationAlpha; }
+	int getStepsLastUpdate() const { return m_stepsLastUpdate; }
+
+	/**************     QUERIES     ****************/
+	// bodies whose broadphase bounds overlap the box
+	void QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results);
+	// closest body along the ray, direction does not need to be normalized
+	bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayCastHit& hit);
+	// one hit per ray, object stays null for the misses; the broadphase is synced once for the whole batch
+	void RayCastBatch(const std::vector<RayQuery>& rays, std::vector<RayCastHit>& hits);
+	// anything along the ray, stops at the first body found: line of sight tests
+	bool RayCastAny(const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+	// first body a sphere moving along the ray touches, the ones it starts in are hit at distance 0
+	bool SphereCast(const glm::vec3& origin, float radius, const glm::vec3& direction, float maxDistance, RayCastHit& hit);
+	// bodies the shape overlaps, exact tests on what the broadphase returns
+	void OverlapSphere(const glm::vec3& center, float radius, std::vector<PhysicsObject*>& results);
+	void OverlapBox(const glm::vec3& center, const glm::vec3& halfExtents, std::vector<PhysicsObject*>& results);
+	/************************************************/
+
+	/**************     SNAPSHOTS   ****************/
+	// whole simulation state between two Updates, restoring it and stepping again repeats the same steps
+	void SaveSnapshot(PhysicsSnapshot& snapshot);
+	// false when the snapshot was taken with other objects, the scene is left untouched then
+	bool RestoreSnapshot(const PhysicsSnapshot& snapshot);
+	/************************************************/
 
 	/**************     COLLISIONS  ****************/
+	// detection runs on the job system, the response runs afterwards in pair order or in the contact solver,
+	// joints added with addObject are solved with the contacts
 	void checkCollisions();
-	// plane
-	static bool planeToPlane(PhysicsObject* planeA, PhysicsObject* planeB);
-	static bool planeToSphere(PhysicsObject* plane, PhysicsObject* sphere);
-	static bool planeToBox(PhysicsObject*  plane, PhysicsObject* box);
-	// sphere
-	static bool sphereToSphere(PhysicsObject* sphereA, PhysicsObject* sphereB);
-	static bool sphereToPlane(PhysicsObject* sphere, PhysicsObject* plane);
-	static bool sphereToBox(PhysicsObject* sphere, PhysicsObject* box);
-	// box
-	static bool boxToSphere(PhysicsObject* box, PhysicsObject* sphere);
-	static bool boxToPlane(PhysicsObject* box, PhysicsObject* plane);
-	static bool boxToBox(PhysicsObject * boxA, PhysicsObject* boxB);
+	const CollisionStats& getCollisionStats() const { return m_collisionStats; }
+	const PhysicsTimings& getTimings() const { return m_timings; }
+	// everything above for the last Update, with its allocations
+	const PhysicsProfileSample& getProfile() const { return m_profile; }
+	RigidBodyWorld& getBodyWorld() { return m_bodyWorld; }
+	const std::vector<Contact>& getContacts() const { return m_contacts; }
+	int numberOfSleepingBodies() const { return m_bodyWorld.numberOfBodies() - m_bodyWorld.numberOfAwakeBodies(); }
+	int numberOfIslands() const { return m_numberOfIslands; }
+	// detect and resolve a single pair right away
+	static bool dispatchCollision(PhysicsObject* objA, PhysicsObject* objB);
+	static bool detectCollision(PhysicsObject* objA, PhysicsObject* objB, Contact& contact);
+	static void resolveContact(const Contact& contact);
+	// response, detection lives in the Narrowphase kernels
+	static void resolveSphereToSphere(const Contact& contact);
+	static void resolveSphereToPlane(const Contact& contact);
+	static void resolveBoxToSphere(const Contact& contact);
+	static void resolveBoxToPlane(const Contact& contact);
+	static void resolveBoxToBox(const Contact& contact);
 	/************************************************/
 
 	// scene properties
@@ -58,10 +198,75 @@ public:
 
 protected:
 	glm::vec3 m_gravity=glm::vec3(0.f);
-	float m_timeStep = 0.f;
+	float m_timeStep = 1.0f / 60.0f;
+	float m_lastStepTime = 1.0f / 60.0f;	// the contact solver works on the step that is running
+	int m_maxSubSteps = 4;
+	float m_accumulator = 0.0f;
+	float m_interpolationAlpha = 1.0f;
+	int m_stepsLastUpdate = 0;
 	std::vector<PhysicsObject*> m_allObjects;
+	// hot state of every body added to the scene
+	RigidBodyWorld m_bodyWorld;
+
+	// planes are unbounded, they stay out of the broadphase and are tested against every body
+	std::vector<PhysicsObject*> m_planes;
+	// heightfields stay out of the broadphase too, tested against the bodies inside their bounds
+	std::vector<PhysicsObject*> m_heightfields;
+	// joints have no body, they link two bodies in the solver
+	std::vector<Joint*> m_joints;
+	// the bodies m_broadphase holds, the per step loops only walk these
+	std::vector<PhysicsObject*> m_dynamicObjects;
+	std::unique_ptr<Broadphase> m_broadphase;
+	// static bodies, searched around each awake dynamic body so static pairs never come up
+	std::unique_ptr<Broadphase> m_staticBroadphase;
+	std::vector<PhysicsObject*> m_staticCandidates;
+	BroadphaseType m_broadphaseType = BroadphaseType::DynamicTree;
+	CollisionStats m_collisionStats;
+	std::vector<PhysicsObject*> m_sweepCandidates;
+	std::vector<PhysicsObject*> m_queryCandidates;
+	int m_sweptBodies = 0;
+	int m_sweptHits = 0;
+	PhysicsTimings m_timings;
+	PhysicsProfileSample m_profile;
+
+	// narrowphase buffers, kept between steps
+	std::vector<BroadphasePair> m_narrowphasePairs;
+	// the same pairs grouped by pair type, with their index in m_narrowphasePairs
+	std::vector<BroadphasePair> m_batchedPairs;
+	std::vector<int> m_batchedOrders;
+	std::vector<int> m_batchedTypes;
+	std::vector<int> m_batchStart;
+	std::vector<int> m_batchCursor;
+	std::vector<std::vector<Contact>> m_threadContacts;
+	std::vector<Contact> m_contacts;
+	ContactSolver m_solver;
+	std::vector<ContactSolver::CachedContact> m_cachedContacts;
+
+	// islands of the awake bodies, rebuilt every step
+	IslandGraph m_islands;
+	std::vector<RigidBody*> m_bodiesToSleep;
+	int m_numberOfIslands = 0;
+	uint64_t m_layoutVersion = 1;
 
 	bool m_applyForce;
 
+	// rebuild the broadphase when m_properties asks for another type
+	void syncBroadphase();
+	// ray query against a synced broadphase, the direction is normalized
+	bool closestRayHit(const glm::vec3& origin, const glm::vec3& rayDirection, float maxDistance, RayCastHit& hit);
+	void rebuildBroadphase(BroadphaseType type);
+	// one fixed step: integration, broadphase refit and collisions
+	void Step(float timeStep);
+	// move the fast bodies back to their first time of impact, returns how many were moved
+	int sweepFastBodies();
+	void detectContacts();
+	// a contact or joint with an awake body wakes a sleeping one
+	void wakeTouchingBodies();
+	// wake the sleeping bodies whose bounds overlap these, after a static body moved
+	void wakeBodiesIn(const AABB& bounds);
+	// link two awake bodies in the island graph
+	void linkIsland(PhysicsObject* objA, PhysicsObject* objB);
+	// link the awake bodies by their contacts and put the quiet islands to sleep
+	void updateSleeping();
 };
 }
@@ -0,0 +1,167 @@
+#include "PhysicsSnapshot.h"
+#include "Broadphase.h"
+
+#include <fstream>
+
+namespace ntn
+{
+
+static void WriteVarint(std::vector<uint8_t>& out, size_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((uint8_t)value);
+}
+
+static bool ReadVarint(const std::vector<uint8_t>& in, size_t& offset, size_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64 && offset < in.size(); shift += 7)
+	{
+		uint8_t byte = in[offset++];
+		value |= (size_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+PhysicsSnapshot::PhysicsSnapshot()
+{
+}
+
+PhysicsSnapshot::PhysicsSnapshot(const PhysicsSnapshot& other) : m_data(other.m_data)
+{
+	if (other.m_broadphase != nullptr)
+	{
+		m_broadphase = other.m_broadphase->Clone();
+	}
+	if (other.m_staticBroadphase != nullptr)
+	{
+		m_staticBroadphase = other.m_staticBroadphase->Clone();
+	}
+}
+
+PhysicsSnapshot& PhysicsSnapshot::operator=(const PhysicsSnapshot& other)
+{
+	if (this != &other)
+	{
+		m_data = other.m_data;
+		m_broadphase = other.m_broadphase != nullptr ? other.m_broadphase->Clone() : nullptr;
+		m_staticBroadphase = other.m_staticBroadphase != nullptr ? other.m_staticBroadphase->Clone() : nullptr;
+	}
+	return *this;
+}
+
+PhysicsSnapshot::~PhysicsSnapshot()
+{
+}
+
+bool PhysicsSnapshot::WriteFile(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(m_data.data()), (std::streamsize)m_data.size());
+	return (bool)file;
+}
+
+bool PhysicsSnapshot::ReadFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+	std::streamsize size = file.tellg();
+	file.seekg(0);
+	m_data.resize((size_t)size);
+	m_broadphase.reset();
+	m_staticBroadphase.reset();
+	return (bool)file.read(reinterpret_cast<char*>(m_data.data()), size);
+}
+
+/*********************************************************************************************************
+* Delta encoding
+**********************************************************************************************************/
+void PhysicsSnapshot::EncodeDelta(const PhysicsSnapshot& base, std::vector<uint8_t>& delta) const
+{
+	// runs of unchanged bytes, then the changed bytes xor-ed with the base: [zeros][count][bytes]...
+	const std::vector<uint8_t>& from = base.m_data;
+	size_t size = m_data.size();
+	delta.clear();
+	WriteVarint(delta, size);
+
+	size_t i = 0;
+	while (i < size)
+	{
+		size_t zeroStart = i;
+		while (i < size && i < from.size() && m_data[i] == from[i])
+		{
+			i++;
+		}
+		size_t literalStart = i;
+		// a short run of unchanged bytes inside a change is cheaper as literals
+		size_t unchanged = 0;
+		while (i < size && unchanged < 4)
+		{
+			bool same = i < from.size() && m_data[i] == from[i];
+			unchanged = same ? unchanged + 1 : 0;
+			i++;
+		}
+		if (unchanged > 0)
+		{
+			i -= unchanged;
+		}
+		WriteVarint(delta, literalStart - zeroStart);
+		WriteVarint(delta, i - literalStart);
+		for (size_t j = literalStart; j < i; j++)
+		{
+			delta.push_back(m_data[j] ^ (j < from.size() ? from[j] : 0));
+		}
+	}
+}
+
+bool PhysicsSnapshot::DecodeDelta(const PhysicsSnapshot& base, const std::vector<uint8_t>& delta)
+{
+	const std::vector<uint8_t>& from = base.m_data;
+	size_t offset = 0;
+	size_t size;
+	if (!ReadVarint(delta, offset, size))
+	{
+		return false;
+	}
+	m_data.resize(size);
+	size_t common = std::min(size, from.size());
+	std::memcpy(m_data.data(), from.data(), common);
+	std::memset(m_data.data() + common, 0, size - common);
+
+	size_t i = 0;
+	while (offset < delta.size())
+	{
+		size_t zeros, count;
+		if (!ReadVarint(delta, offset, zeros) || !ReadVarint(delta, offset, count) ||
+			zeros > size - i || count > size - i - zeros || count > delta.size() - offset)
+		{
+			return false;
+		}
+		i += zeros;
+		for (size_t j = 0; j < count; j++)
+		{
+			m_data[i++] ^= delta[offset++];
+		}
+	}
+	// the broadphases of base do not match the decoded bodies, restoring rebuilds them as for a file
+	m_broadphase.reset();
+	m_staticBroadphase.reset();
+	return i == size;
+}
+
+}
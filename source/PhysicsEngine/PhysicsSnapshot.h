@@ -0,0 +1,146 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+namespace ntn
+{
+	class Broadphase;
+
+	// Appends plain values and arrays to a byte buffer, arrays go in with one memcpy.
+	class SnapshotWriter
+	{
+	public:
+		explicit SnapshotWriter(std::vector<uint8_t>& data) : m_data(data) {}
+
+		void WriteBytes(const void* bytes, size_t size)
+		{
+			size_t offset = m_data.size();
+			m_data.resize(offset + size);
+			if (size > 0)
+			{
+				std::memcpy(m_data.data() + offset, bytes, size);
+			}
+		}
+		template<typename T>
+		void Write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain data only");
+			WriteBytes(&value, sizeof(T));
+		}
+		// count first, then the elements
+		template<typename T>
+		void WriteArray(const std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain data only");
+			Write((uint32_t)values.size());
+			WriteBytes(values.data(), values.size() * sizeof(T));
+		}
+
+	private:
+		std::vector<uint8_t>& m_data;
+	};
+
+	// Reads back what a SnapshotWriter wrote, every read fails once the data runs out.
+	class SnapshotReader
+	{
+	public:
+		SnapshotReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+		bool ReadBytes(void* bytes, size_t size)
+		{
+			if (m_failed || size > m_size - m_offset)
+			{
+				m_failed = true;
+				return false;
+			}
+			if (size > 0)
+			{
+				std::memcpy(bytes, m_data + m_offset, size);
+			}
+			m_offset += size;
+			return true;
+		}
+		template<typename T>
+		bool Read(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain data only");
+			return ReadBytes(&value, sizeof(T));
+		}
+		template<typename T>
+		bool ReadArray(std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain data only");
+			uint32_t count = 0;
+			if (!Read(count) || count > (m_size - m_offset) / sizeof(T))
+			{
+				m_failed = true;
+				return false;
+			}
+			values.resize(count);
+			return ReadBytes(values.data(), count * sizeof(T));
+		}
+
+		// moves over an array without copying it, count is its number of elements
+		template<typename T>
+		bool SkipArray(uint32_t& count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "snapshots hold plain data only");
+			count = 0;
+			if (!Read(count) || count > (m_size - m_offset) / sizeof(T))
+			{
+				m_failed = true;
+				return false;
+			}
+			m_offset += (size_t)count * sizeof(T);
+			return true;
+		}
+
+		bool failed() const { return m_failed; }
+		bool atEnd() const { return m_offset == m_size; }
+
+	private:
+		const uint8_t* m_data;
+		size_t m_size;
+		size_t m_offset = 0;
+		bool m_failed = false;
+	};
+
+	// Complete state of a PhysicsScene, taken with PhysicsScene::SaveSnapshot.
+	// The bodies, joints and cached contact impulses are kept as bytes, objects are referred to by their
+	// index in the scene, so a snapshot restores into a scene holding the same objects (the same one after
+	// a rollback, or one spawned the same way offline). The dynamic broadphase and the static tree are kept as
+	// copies of the live structures, they do not go into the bytes: a snapshot read from a file rebuilds them on restore.
+	class PhysicsSnapshot
+	{
+	public:
+		PhysicsSnapshot();
+		PhysicsSnapshot(const PhysicsSnapshot& other);
+		PhysicsSnapshot& operator=(const PhysicsSnapshot& other);
+		~PhysicsSnapshot();
+
+		const std::vector<uint8_t>& getData() const { return m_data; }
+		size_t size() const { return m_data.size(); }
+		bool hasBroadphase() const { return m_broadphase != nullptr && m_staticBroadphase != nullptr; }
+
+		// the bytes only, the broadphase is rebuilt when restoring what was read
+		bool WriteFile(const std::string& path) const;
+		bool ReadFile(const std::string& path);
+
+		// changes since base: the bytes are xor-ed with base and the zero runs collapsed,
+		// bodies that did not move cost a couple of bytes
+		void EncodeDelta(const PhysicsSnapshot& base, std::vector<uint8_t>& delta) const;
+		// rebuild the snapshot a delta was encoded from, base must be the same one
+		bool DecodeDelta(const PhysicsSnapshot& base, const std::vector<uint8_t>& delta);
+
+	private:
+		friend class PhysicsScene;
+
+		std::vector<uint8_t> m_data;
+		std::unique_ptr<Broadphase> m_broadphase;
+		std::unique_ptr<Broadphase> m_staticBroadphase;
+	};
+}
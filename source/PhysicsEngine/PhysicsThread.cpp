@@ -0,0 +1,182 @@
+#include "PhysicsThread.h"
+#include "PhysicsObject.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace ntn
+{
+
+typedef std::chrono::steady_clock Clock;
+
+static double Seconds()
+{
+	return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+}
+
+bool TransformFrame::GetTransform(const PhysicsObject* object, float alpha, glm::vec3& position, glm::vec3& rotation) const
+{
+	auto found = indexOf.find(object);
+	if (found == indexOf.end())
+	{
+		return false;
+	}
+	const PublishedTransform& transform = transforms[found->second];
+	position = glm::mix(transform.previousPosition, transform.position, alpha);
+	rotation = transform.rotation;
+	return true;
+}
+
+PhysicsThread::PhysicsThread(PhysicsScene& scene) : m_scene(scene)
+{
+}
+
+PhysicsThread::~PhysicsThread()
+{
+	Stop();
+}
+
+void PhysicsThread::Start()
+{
+	if (m_running)
+	{
+		return;
+	}
+	m_running = true;
+	m_thread = std::thread(&PhysicsThread::Run, this);
+}
+
+void PhysicsThread::Stop()
+{
+	if (!m_running)
+	{
+		return;
+	}
+	m_running = false;
+	m_thread.join();
+	// what the thread did not get to runs here
+	RunCommands();
+}
+
+void PhysicsThread::Update(float deltaTime)
+{
+	if (m_running)
+	{
+		return;
+	}
+	RunCommands();
+	m_scene.Update(deltaTime);
+	Publish();
+}
+
+void PhysicsThread::Enqueue(Command command)
+{
+	if (!m_running)
+	{
+		command(m_scene);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(m_commandMutex);
+	m_commands.push_back(std::move(command));
+}
+
+float PhysicsThread::RenderAlpha(const TransformFrame& frame) const
+{
+	if (!m_running)
+	{
+		return frame.interpolationAlpha;
+	}
+	// the frame is drawn one step behind, reaching its last step when the next one is due
+	if (frame.timeStep <= 0.0f)
+	{
+		return 1.0f;
+	}
+	float alpha = (float)((Seconds() - frame.publishTime) / frame.timeStep);
+	return std::min(std::max(alpha, 0.0f), 1.0f);
+}
+
+bool PhysicsThread::StartProfileCsv(const std::string& path)
+{
+	// Publish records under the scene lock
+	std::lock_guard<std::mutex> lock(m_sceneMutex);
+	m_streamingProfile = m_profiler.StartCsv(path);
+	return m_streamingProfile;
+}
+
+void PhysicsThread::StopProfileCsv()
+{
+	std::lock_guard<std::mutex> lock(m_sceneMutex);
+	m_profiler.StopCsv();
+	m_streamingProfile = false;
+}
+
+void PhysicsThread::Run()
+{
+	Clock::time_point next = Clock::now();
+	while (m_running)
+	{
+		float timeStep = m_scene.getTimeStep() > 0.0f ? m_scene.getTimeStep() : 1.0f / 60.0f;
+		{
+			std::lock_guard<std::mutex> lock(m_sceneMutex);
+			RunCommands();
+			// one whole step, the accumulator of the scene stays where it is
+			m_scene.Update(timeStep);
+			Publish();
+		}
+
+		// steps that ran late are not caught up, the simulation slows down instead of spiraling
+		next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(timeStep));
+		Clock::time_point now = Clock::now();
+		if (next < now)
+		{
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+	}
+}
+
+void PhysicsThread::RunCommands()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+		std::swap(m_commands, m_runningCommands);
+	}
+	for (Command& command : m_runningCommands)
+	{
+		command(m_scene);
+	}
+	m_runningCommands.clear();
+}
+
+void PhysicsThread::Publish()
+{
+	TransformFrame& frame = m_frames.WriteBuffer();
+	const std::vector<PhysicsObject*>& objects = m_scene.getAllObjects();
+	if (frame.layoutVersion != m_scene.getLayoutVersion())
+	{
+		frame.objects = objects;
+		frame.indexOf.clear();
+		for (int index = 0; index < (int)objects.size(); index++)
+		{
+			frame.indexOf[objects[index]] = index;
+		}
+		frame.layoutVersion = m_scene.getLayoutVersion();
+	}
+
+	frame.transforms.resize(objects.size());
+	for (size_t index = 0; index < objects.size(); index++)
+	{
+		PhysicsObject* object = objects[index];
+		frame.transforms[index] = { object->GetInterpolatedPosition(0.0f), object->GetPosition(), object->GetRotation() };
+	}
+
+	frame.step = ++m_step;
+	frame.publishTime = Seconds();
+	frame.timeStep = m_scene.getTimeStep();
+	frame.interpolationAlpha = m_scene.getInterpolationAlpha();
+	frame.profile = m_scene.getProfile();
+	m_frames.Publish();
+	m_profiler.Record(frame.profile);
+}
+
+}
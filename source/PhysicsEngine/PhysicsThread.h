@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+#include "PhysicsScene.h"
+#include "TripleBuffer.h"
+#include "PhysicsProfiler.h"
+
+namespace ntn
+{
+	// what the renderer draws of an object, as of one physics step
+	struct PublishedTransform
+	{
+		glm::vec3 previousPosition;
+		glm::vec3 position;
+		glm::vec3 rotation;
+	};
+
+	// Everything the render thread reads from the simulation, published after every step.
+	struct TransformFrame
+	{
+		std::vector<PhysicsObject*> objects;
+		std::vector<PublishedTransform> transforms;	// one per object
+		std::unordered_map<const PhysicsObject*, int> indexOf;
+		uint64_t layoutVersion = 0;	// objects and indexOf are only rebuilt when objects were added or removed
+
+		uint64_t step = 0;
+		double publishTime = 0.0;	// seconds on the steady clock
+		float timeStep = 0.0f;
+		float interpolationAlpha = 1.0f;	// of the scene, when it is stepped on the calling thread
+
+		PhysicsProfileSample profile;	// of the update that produced the frame
+
+		// blended between the last two steps, false for objects the frame does not know yet
+		bool GetTransform(const PhysicsObject* object, float alpha, glm::vec3& position, glm::vec3& rotation) const;
+	};
+
+	// Runs a PhysicsScene on its own thread at the fixed time step of the scene.
+	// While it runs the scene belongs to that thread: other threads read the published TransformFrame,
+	// send small changes through Enqueue and hold LockScene() around bigger ones (spawning, loading).
+	// When it is stopped, Update steps the scene on the calling thread and publishes the same frames.
+	class PhysicsThread
+	{
+	public:
+		typedef std::function<void(PhysicsScene& scene)> Command;
+
+		explicit PhysicsThread(PhysicsScene& scene);
+		~PhysicsThread();
+
+		PhysicsThread(const PhysicsThread&) = delete;
+		PhysicsThread& operator=(const PhysicsThread&) = delete;
+
+		void Start();
+		void Stop();
+		bool isRunning() const { return m_running; }
+
+		// steps the scene here when the thread is stopped, nothing to do while it runs
+		void Update(float deltaTime);
+
+		// runs on the physics thread before its next step, right away when stopped
+		void Enqueue(Command command);
+		// the physics thread waits between two steps while the lock is held
+		std::unique_lock<std::mutex> LockScene() { return std::unique_lock<std::mutex>(m_sceneMutex); }
+
+		// reader side: the newest frame, and how far to blend it towards its last step now
+		const TransformFrame& ReadFrame() { return m_frames.Read(); }
+		float RenderAlpha(const TransformFrame& frame) const;
+
+		// every update of the scene as one CSV row, written where the scene is stepped so none is missed
+		bool StartProfileCsv(const std::string& path);
+		void StopProfileCsv();
+		bool isStreamingProfile() const { return m_streamingProfile; }
+
+	private:
+		void Run();
+		void RunCommands();
+		void Publish();
+
+		PhysicsScene& m_scene;
+		std::thread m_thread;
+		std::atomic<bool> m_running{ false };
+		std::mutex m_sceneMutex;
+
+		std::mutex m_commandMutex;
+		std::vector<Command> m_commands;
+		std::vector<Command> m_runningCommands;
+
+		TripleBuffer<TransformFrame> m_frames;
+		uint64_t m_step = 0;
+
+		PhysicsProfiler m_profiler;
+		std::atomic<bool> m_streamingProfile{ false };
+	};
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include"../mesh.h"
+#include"../boundingBox.h"
+
+namespace ntn
+{
+
+// ground quad drawn under the scene, the collision plane is Plane
+class PlaneModel
+{
+public:
+	PlaneModel();
+
+	void Render(Shader& shader);
+
+	void ComputeBoundingBox();
+	void UpdateBoundingBox(glm::vec3 deltaPos);
+
+	const BoundingBox& GetBoundingBox() const { return m_bbox; };
+
+private:
+	Mesh* m_plane = nullptr;
+	void init();
+	BoundingBox m_bbox;
+};
+
+}
\ No newline at end of file
@@ -1,10 +1,6 @@
 #include "RigidBody.h"
 #include <string>
 
-
-#define MIN_LINEAR_THRESHOLD 0.05f
-#define MIN_ROTATION_THRESHOLD 0.05f
-
 namespace ntn
 {
 
@@ -28,32 +24,117 @@ namespace ntn
 		m_data.mass = mass;
 	}
 
+	RigidBody::RigidBody(const RigidBody& other) : m_data(other.getData())
+	{
+	}
+
 	RigidBody::~RigidBody()
 	{
+		if (m_world != nullptr)
+		{
+			m_world->Remove(this);
+		}
+	}
+
+	RigidBodyData RigidBody::getData() const
+	{
+		RigidBodyData data = m_data;
+		data.position = getPosition();
+		data.velocity = getVelocity();
+		data.mass = getMass();
+		data.linearDrag = getLinearDrag();
+		data.isStatic = isStatic();
+		data.isKinematic = isKinematic();
+		data.onGround = isOnGround();
+		data.rotationLock = isRotationLocked();
+		return data;
+	}
+
+	void RigidBody::setPosition(const glm::vec3& position)
+	{
+		if (m_world != nullptr)
+		{
+			m_world->Wake(this);
+			m_world->SetPosition(m_index, position);
+		}
+		else m_data.position = position;
+	}
+
+	void RigidBody::setVelocity(const glm::vec3& velocity)
+	{
+		if (m_world != nullptr)
+		{
+			m_world->Wake(this);
+			m_world->SetVelocity(m_index, velocity);
+		}
+		else m_data.velocity = velocity;
+	}
+
+	void RigidBody::setMass(float mass)
+	{
+		if (m_world != nullptr) m_world->SetMass(m_index, mass);
+		else m_data.mass = mass;
+	}
+
+	void RigidBody::setLinearDrag(float linearDrag)
+	{
+		if (m_world != nullptr) m_world->SetLinearDrag(m_index, linearDrag);
+		else m_data.linearDrag = linearDrag;
+	}
+
+	void RigidBody::setStatic(bool value)
+	{
+		if (m_world != nullptr) m_world->SetFlag(m_index, BODY_STATIC, value);
+		else m_data.isStatic = value;
+	}
+
+	void RigidBody::setKinematic(bool value)
+	{
+		if (m_world != nullptr) m_world->SetFlag(m_index, BODY_KINEMATIC, value);
+		else m_data.isKinematic = value;
+	}
+
+	void RigidBody::setOnGround(bool value)
+	{
+		if (m_world != nullptr) m_world->SetFlag(m_index, BODY_ON_GROUND, value);
+		else m_data.onGround = value;
+	}
+
+	void RigidBody::setRotationLock(bool value)
+	{
+		if (m_world != nullptr) m_world->SetFlag(m_index, BODY_ROTATION_LOCK, value);
+		else m_data.rotationLock = value;
+	}
+
+	void RigidBody::wake()
+	{
+		if (m_world != nullptr) m_world->Wake(this);
 	}
 
 	void RigidBody::UpdatePhysics(glm::vec3 gravity, float timeStep)
 	{
-		if (m_data.isStatic)
+		if (isStatic())
 		{
 			return;
 		}
+		glm::vec3 velocity = getVelocity();
 		// adjust gravity based on ground state
-		glm::vec3 totalGravity(m_data.onGround ? glm::vec3(0.0f) : gravity);
-		applyForce(totalGravity * m_data.mass * timeStep);
+		glm::vec3 totalGravity(isOnGround() ? glm::vec3(0.0f) : gravity);
+		velocity += totalGravity * timeStep;
 
 		// apply drag
-		if (!m_data.isKinematic && !m_data.rotationLock)
+		bool rotationLock = isRotationLocked();
+		if (!isKinematic() && !rotationLock)
 		{
-			m_data.velocity *= m_data.linearDrag;
+			velocity *= getLinearDrag();
 			m_data.angularVelocity *= m_data.angularDrag;
 		}
 
 		// update position
-		m_data.position += m_data.velocity * timeStep;
+		setPosition(getPosition() + velocity * timeStep);
 
 		// update rotation
-		if (!m_data.rotationLock)
+		if (!rotationLock)
 		{
 			if (m_data.rotation.z > 360.0f || m_data.rotation.z < -360.0f)
 			{
@@ -66,16 +147,17 @@ namespace ntn
 		}
 
 		// adjust velocity's to keep them in check
-		if (length(m_data.velocity) < MIN_LINEAR_THRESHOLD)
+		if (length(velocity) < MIN_LINEAR_THRESHOLD)
 		{
-			if (length(m_data.velocity) < length(gravity) * m_data.linearDrag * timeStep) {
-				m_data.velocity = glm::vec3(0.0f);
+			if (length(velocity) < length(gravity) * getLinearDrag() * timeStep) {
+				velocity = glm::vec3(0.0f);
 			}
 		}
+		setVelocity(velocity);
 
 		if (length(m_data.angularVelocity) < MIN_ROTATION_THRESHOLD)
 		{
-			if (length(m_data.velocity) < length(m_data.angularVelocity)) {
+			if (length(velocity) < length(m_data.angularVelocity)) {
 				m_data.angularVelocity = glm::vec3(0.0f);
 			}
 		}
@@ -83,16 +165,20 @@ namespace ntn
 
 	void RigidBody::applyForce(glm::vec3 force)
 	{
-		m_data.velocity += force / m_data.mass;
+		wake();
+		setVelocity(getVelocity() + force / getMass());
 	}
 
 	void RigidBody::applyForceToAnotherBody(RigidBody* otherBody, glm::vec3 force)
 	{
-		if (!otherBody->m_data.onGround)
+		// both bodies take part in the exchange, even the one resting on the ground
+		wake();
+		otherBody->wake();
+		if (!otherBody->isOnGround())
 		{
 			otherBody->applyForce(force);
 		}
-		if (!m_data.onGround)
+		if (!isOnGround())
 		{
 			applyForce(-force);
 		}
@@ -100,15 +186,16 @@ namespace ntn
 
 	void RigidBody::applyTorque(glm::vec3 force)
 	{
-		m_data.angularVelocity += force / m_data.mass;
+		wake();
+		m_data.angularVelocity += force / getMass();
 	}
 
 	void RigidBody::applyTorqueToAnotherBody(RigidBody* otherBody, glm::vec3 force)
 	{
-		if (!otherBody->m_data.onGround) {
+		if (!otherBody->isOnGround()) {
 			otherBody->applyTorque(force);
 		}
-		if (!m_data.onGround) {
+		if (!isOnGround()) {
 			applyTorque(-force);
 		}
 	}
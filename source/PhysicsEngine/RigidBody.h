@@ -1,5 +1,10 @@
 #pragma once
 #include "glm/glm.hpp"
+#include "RigidBodyWorld.h"
+#include "ObjectPool.h"
+
+#define MIN_LINEAR_THRESHOLD 0.05f
+#define MIN_ROTATION_THRESHOLD 0.05f
 
 namespace ntn
 {
@@ -9,7 +14,7 @@ namespace ntn
 		glm::vec3 velocity = glm::vec3(0.0f, 0.0f, 0.0f);
 
 		glm::vec3 rotation = glm::vec3(0.0f, 0.0f, 0.00000001f);
-		glm::vec3 angularVelocity;
+		glm::vec3 angularVelocity = glm::vec3(0.0f);
 
 		glm::vec3 startPosition = glm::vec3(0.0f);
 		glm::vec3 startVelocity = glm::vec3(0.0f);
@@ -35,15 +40,55 @@ namespace ntn
 	};
 
 
+	// Position, velocity, mass, linear drag and the flags live in the RigidBodyWorld once the
+	// body is attached to it, m_data only holds them while the body is detached.
+	// Always go through the accessors for those fields.
 	class RigidBody
 	{
 	public:
 		RigidBody() {};
 		RigidBody(glm::vec3 position, glm::vec3 velocity, glm::vec3 rotation, float mass);
 		RigidBody(glm::vec3 position, float angle, float speed, glm::vec3 rotation, float mass);
+		// the copy is detached from any world
+		RigidBody(const RigidBody& other);
+		RigidBody& operator=(const RigidBody& other) = delete;
 
 		~RigidBody();
 
+		// bodies are allocated from ObjectPool<RigidBody>
+		static void* operator new(size_t size) { return ObjectPool<RigidBody>::Allocate(size); }
+		static void operator delete(void* pointer, size_t size) { ObjectPool<RigidBody>::Free(pointer, size); }
+
+		glm::vec3 getPosition() const { return m_world != nullptr ? m_world->GetPosition(m_index) : m_data.position; }
+		// position between the last two steps, the current position while detached
+		glm::vec3 getInterpolatedPosition(float alpha) const { return m_world != nullptr ? m_world->GetInterpolatedPosition(m_index, alpha) : m_data.position; }
+		glm::vec3 getVelocity() const { return m_world != nullptr ? m_world->GetVelocity(m_index) : m_data.velocity; }
+		float getMass() const { return m_world != nullptr ? m_world->GetMass(m_index) : m_data.mass; }
+		float getLinearDrag() const { return m_world != nullptr ? m_world->GetLinearDrag(m_index) : m_data.linearDrag; }
+		bool isStatic() const { return m_world != nullptr ? m_world->HasFlag(m_index, BODY_STATIC) : m_data.isStatic; }
+		bool isKinematic() const { return m_world != nullptr ? m_world->HasFlag(m_index, BODY_KINEMATIC) : m_data.isKinematic; }
+		bool isOnGround() const { return m_world != nullptr ? m_world->HasFlag(m_index, BODY_ON_GROUND) : m_data.onGround; }
+		bool isRotationLocked() const { return m_world != nullptr ? m_world->HasFlag(m_index, BODY_ROTATION_LOCK) : m_data.rotationLock; }
+		// only bodies in a world can sleep
+		bool isSleeping() const { return m_world != nullptr && m_world->HasFlag(m_index, BODY_SLEEPING); }
+
+		void setPosition(const glm::vec3& position);
+		void setVelocity(const glm::vec3& velocity);
+		void setMass(float mass);
+		void setLinearDrag(float linearDrag);
+		void setStatic(bool value);
+		void setKinematic(bool value);
+		void setOnGround(bool value);
+		void setRotationLock(bool value);
+		// moving the body or changing its velocity from outside wakes it up
+		void wake();
+
+		RigidBodyWorld* getWorld() const { return m_world; }
+		// slot in the world arrays, changes whenever bodies are added, removed, put to sleep or woken
+		int getIndex() const { return m_index; }
+		// copy of m_data with the fields owned by the world filled in
+		RigidBodyData getData() const;
+
 		void UpdatePhysics(glm::vec3 gravity, float timeStep);
 
 		// force application
@@ -58,6 +103,11 @@ namespace ntn
 		glm::vec3 predictPosition(float deltatime, glm::vec3 gravity);
 
 		RigidBodyData m_data;
+
+	private:
+		friend class RigidBodyWorld;
+		RigidBodyWorld* m_world = nullptr;
+		int m_index = -1;
 	};
 }
 
@@ -0,0 +1,461 @@
+#include "RigidBodyWorld.h"
+#include "RigidBody.h"
+#include "Simd.h"
+#include "PhysicsSnapshot.h"
+
+#include <algorithm>
+
+namespace ntn
+{
+
+RigidBodyWorld::~RigidBodyWorld()
+{
+	Clear();
+}
+
+/*********************************************************************************************************
+* Bodies
+**********************************************************************************************************/
+void RigidBodyWorld::Add(RigidBody* body)
+{
+	if (body->m_world == this)
+	{
+		return;
+	}
+	if (body->m_world != nullptr)
+	{
+		body->m_world->Remove(body);
+	}
+
+	const RigidBodyData& data = body->m_data;
+	m_positionX.push_back(data.position.x);
+	m_positionY.push_back(data.position.y);
+	m_positionZ.push_back(data.position.z);
+	m_previousX.push_back(data.position.x);
+	m_previousY.push_back(data.position.y);
+	m_previousZ.push_back(data.position.z);
+	m_velocityX.push_back(data.velocity.x);
+	m_velocityY.push_back(data.velocity.y);
+	m_velocityZ.push_back(data.velocity.z);
+	m_mass.push_back(data.mass);
+	m_linearDrag.push_back(data.linearDrag);
+
+	uint8_t flags = 0;
+	if (data.isStatic) flags |= BODY_STATIC;
+	if (data.isKinematic) flags |= BODY_KINEMATIC;
+	if (data.onGround) flags |= BODY_ON_GROUND;
+	if (data.rotationLock) flags |= BODY_ROTATION_LOCK;
+	m_flags.push_back(flags);
+
+	m_gravityFactor.push_back(0.0f);
+	m_dragFactor.push_back(1.0f);
+	m_moveFactor.push_back(0.0f);
+	m_sleepFrames.push_back(0);
+	m_bodies.push_back(body);
+
+	body->m_world = this;
+	body->m_index = (int)m_bodies.size() - 1;
+	UpdateCoefficients(body->m_index);
+
+	// new bodies start awake, in front of the sleeping ones
+	SwapBodies(body->m_index, m_numberOfAwake);
+	m_numberOfAwake++;
+}
+
+void RigidBodyWorld::Remove(RigidBody* body)
+{
+	if (body->m_world != this)
+	{
+		return;
+	}
+
+	// hand the state back to the body
+	int index = body->m_index;
+	RigidBodyData& data = body->m_data;
+	data.position = GetPosition(index);
+	data.velocity = GetVelocity(index);
+	data.mass = m_mass[index];
+	data.linearDrag = m_linearDrag[index];
+	data.isStatic = HasFlag(index, BODY_STATIC);
+	data.isKinematic = HasFlag(index, BODY_KINEMATIC);
+	data.onGround = HasFlag(index, BODY_ON_GROUND);
+	data.rotationLock = HasFlag(index, BODY_ROTATION_LOCK);
+
+	// move the body to the end, keeping the awake bodies packed in front
+	if (index < m_numberOfAwake)
+	{
+		SwapBodies(index, m_numberOfAwake - 1);
+		index = m_numberOfAwake - 1;
+		m_numberOfAwake--;
+	}
+	SwapBodies(index, (int)m_bodies.size() - 1);
+	body->m_world = nullptr;
+	body->m_index = -1;
+
+	m_positionX.pop_back();
+	m_positionY.pop_back();
+	m_positionZ.pop_back();
+	m_previousX.pop_back();
+	m_previousY.pop_back();
+	m_previousZ.pop_back();
+	m_velocityX.pop_back();
+	m_velocityY.pop_back();
+	m_velocityZ.pop_back();
+	m_mass.pop_back();
+	m_linearDrag.pop_back();
+	m_flags.pop_back();
+	m_gravityFactor.pop_back();
+	m_dragFactor.pop_back();
+	m_moveFactor.pop_back();
+	m_sleepFrames.pop_back();
+	m_bodies.pop_back();
+}
+
+void RigidBodyWorld::SwapBodies(int indexA, int indexB)
+{
+	if (indexA == indexB)
+	{
+		return;
+	}
+	std::swap(m_positionX[indexA], m_positionX[indexB]);
+	std::swap(m_positionY[indexA], m_positionY[indexB]);
+	std::swap(m_positionZ[indexA], m_positionZ[indexB]);
+	std::swap(m_previousX[indexA], m_previousX[indexB]);
+	std::swap(m_previousY[indexA], m_previousY[indexB]);
+	std::swap(m_previousZ[indexA], m_previousZ[indexB]);
+	std::swap(m_velocityX[indexA], m_velocityX[indexB]);
+	std::swap(m_velocityY[indexA], m_velocityY[indexB]);
+	std::swap(m_velocityZ[indexA], m_velocityZ[indexB]);
+	std::swap(m_mass[indexA], m_mass[indexB]);
+	std::swap(m_linearDrag[indexA], m_linearDrag[indexB]);
+	std::swap(m_flags[indexA], m_flags[indexB]);
+	std::swap(m_gravityFactor[indexA], m_gravityFactor[indexB]);
+	std::swap(m_dragFactor[indexA], m_dragFactor[indexB]);
+	std::swap(m_moveFactor[indexA], m_moveFactor[indexB]);
+	std::swap(m_sleepFrames[indexA], m_sleepFrames[indexB]);
+	std::swap(m_bodies[indexA], m_bodies[indexB]);
+	m_bodies[indexA]->m_index = indexA;
+	m_bodies[indexB]->m_index = indexB;
+}
+
+void RigidBodyWorld::Clear()
+{
+	while (!m_bodies.empty())
+	{
+		Remove(m_bodies.back());
+	}
+}
+
+/*********************************************************************************************************
+* Snapshots
+**********************************************************************************************************/
+void RigidBodyWorld::WriteState(SnapshotWriter& writer) const
+{
+	writer.Write(m_numberOfAwake);
+	writer.WriteArray(m_positionX);
+	writer.WriteArray(m_positionY);
+	writer.WriteArray(m_positionZ);
+	writer.WriteArray(m_previousX);
+	writer.WriteArray(m_previousY);
+	writer.WriteArray(m_previousZ);
+	writer.WriteArray(m_velocityX);
+	writer.WriteArray(m_velocityY);
+	writer.WriteArray(m_velocityZ);
+	writer.WriteArray(m_mass);
+	writer.WriteArray(m_linearDrag);
+	writer.WriteArray(m_flags);
+	writer.WriteArray(m_gravityFactor);
+	writer.WriteArray(m_dragFactor);
+	writer.WriteArray(m_moveFactor);
+	writer.WriteArray(m_sleepFrames);
+}
+
+bool RigidBodyWorld::ReadState(SnapshotReader& reader, const std::vector<RigidBody*>& bodies)
+{
+	reader.Read(m_numberOfAwake);
+	reader.ReadArray(m_positionX);
+	reader.ReadArray(m_positionY);
+	reader.ReadArray(m_positionZ);
+	reader.ReadArray(m_previousX);
+	reader.ReadArray(m_previousY);
+	reader.ReadArray(m_previousZ);
+	reader.ReadArray(m_velocityX);
+	reader.ReadArray(m_velocityY);
+	reader.ReadArray(m_velocityZ);
+	reader.ReadArray(m_mass);
+	reader.ReadArray(m_linearDrag);
+	reader.ReadArray(m_flags);
+	reader.ReadArray(m_gravityFactor);
+	reader.ReadArray(m_dragFactor);
+	reader.ReadArray(m_moveFactor);
+	reader.ReadArray(m_sleepFrames);
+	size_t count = bodies.size();
+	if (reader.failed() || m_positionX.size() != count || m_velocityX.size() != count || m_flags.size() != count || m_sleepFrames.size() != count)
+	{
+		return false;
+	}
+
+	m_bodies = bodies;
+	for (int index = 0; index < (int)m_bodies.size(); index++)
+	{
+		m_bodies[index]->m_world = this;
+		m_bodies[index]->m_index = index;
+	}
+	return true;
+}
+
+bool RigidBodyWorld::CheckState(SnapshotReader& reader, size_t count)
+{
+	int numberOfAwake = 0;
+	reader.Read(numberOfAwake);
+	bool valid = numberOfAwake >= 0 && (size_t)numberOfAwake <= count;
+	uint32_t size = 0;
+	// positions, previous positions, velocities, mass, drag
+	for (int array = 0; array < 11; array++)
+	{
+		valid = reader.SkipArray<float>(size) && size == count && valid;
+	}
+	valid = reader.SkipArray<uint8_t>(size) && size == count && valid;
+	// gravity, drag and move factors
+	for (int array = 0; array < 3; array++)
+	{
+		valid = reader.SkipArray<float>(size) && size == count && valid;
+	}
+	valid = reader.SkipArray<int>(size) && size == count && valid;
+	return valid && !reader.failed();
+}
+
+/*********************************************************************************************************
+* Sleeping
+**********************************************************************************************************/
+void RigidBodyWorld::Sleep(RigidBody* body)
+{
+	int index = body->m_index;
+	if (body->m_world != this || HasFlag(index, BODY_SLEEPING))
+	{
+		return;
+	}
+	// the body stops where it is, nothing is left to interpolate
+	SetVelocity(index, glm::vec3(0.0f));
+	m_previousX[index] = m_positionX[index];
+	m_previousY[index] = m_positionY[index];
+	m_previousZ[index] = m_positionZ[index];
+	m_flags[index] |= BODY_SLEEPING;
+
+	SwapBodies(index, m_numberOfAwake - 1);
+	m_numberOfAwake--;
+}
+
+void RigidBodyWorld::Wake(RigidBody* body)
+{
+	int index = body->m_index;
+	// static bodies sleep for good, their proxies sit in a tree that is only rebuilt by PhysicsScene::updateStaticObject
+	if (body->m_world != this || !HasFlag(index, BODY_SLEEPING) || HasFlag(index, BODY_STATIC))
+	{
+		return;
+	}
+	m_flags[index] &= ~BODY_SLEEPING;
+	m_sleepFrames[index] = 0;
+
+	SwapBodies(index, m_numberOfAwake);
+	m_numberOfAwake++;
+}
+
+void RigidBodyWorld::UpdateSleepFrames(float velocityThreshold)
+{
+	float thresholdSq = velocityThreshold * velocityThreshold;
+	for (int i = 0; i < m_numberOfAwake; i++)
+	{
+		float speedSq = m_velocityX[i] * m_velocityX[i] + m_velocityY[i] * m_velocityY[i] + m_velocityZ[i] * m_velocityZ[i];
+		bool resting = speedSq < thresholdSq;
+		if (resting && (m_flags[i] & BODY_ROTATION_LOCK) == 0)
+		{
+			const glm::vec3& angularVelocity = m_bodies[i]->m_data.angularVelocity;
+			resting = glm::dot(angularVelocity, angularVelocity) < thresholdSq;
+		}
+		m_sleepFrames[i] = resting ? m_sleepFrames[i] + 1 : 0;
+	}
+}
+
+void RigidBodyWorld::SetFlag(int index, RigidBodyFlags flag, bool value)
+{
+	if (value)
+	{
+		m_flags[index] |= flag;
+	}
+	else
+	{
+		m_flags[index] &= ~flag;
+	}
+	UpdateCoefficients(index);
+}
+
+void RigidBodyWorld::UpdateCoefficients(int index)
+{
+	uint8_t flags = m_flags[index];
+	bool isStatic = (flags & BODY_STATIC) != 0;
+	bool applyDrag = (flags & (BODY_KINEMATIC | BODY_ROTATION_LOCK)) == 0;
+
+	m_gravityFactor[index] = (isStatic || (flags & BODY_ON_GROUND) != 0) ? 0.0f : 1.0f;
+	m_dragFactor[index] = (!isStatic && applyDrag) ? m_linearDrag[index] : 1.0f;
+	m_moveFactor[index] = isStatic ? 0.0f : 1.0f;
+}
+
+/*********************************************************************************************************
+* Integration
+**********************************************************************************************************/
+void RigidBodyWorld::Integrate(const glm::vec3& gravity, float timeStep)
+{
+	IntegrateRange(0, m_numberOfAwake, gravity, timeStep);
+	IntegrateRotations(timeStep);
+}
+
+void RigidBodyWorld::StorePreviousPositions()
+{
+	// sleeping bodies already have previous == current
+	std::copy(m_positionX.begin(), m_positionX.begin() + m_numberOfAwake, m_previousX.begin());
+	std::copy(m_positionY.begin(), m_positionY.begin() + m_numberOfAwake, m_previousY.begin());
+	std::copy(m_positionZ.begin(), m_positionZ.begin() + m_numberOfAwake, m_previousZ.begin());
+}
+
+void RigidBodyWorld::IntegrateRange(int begin, int end, const glm::vec3& gravity, float timeStep)
+{
+	float* positionX = m_positionX.data();
+	float* positionY = m_positionY.data();
+	float* positionZ = m_positionZ.data();
+	float* velocityX = m_velocityX.data();
+	float* velocityY = m_velocityY.data();
+	float* velocityZ = m_velocityZ.data();
+	const float* linearDrag = m_linearDrag.data();
+	const float* gravityFactor = m_gravityFactor.data();
+	const float* dragFactor = m_dragFactor.data();
+	const float* moveFactor = m_moveFactor.data();
+
+	// same steps as RigidBody::UpdatePhysics:
+	// v += g * dt, v *= drag, p += v * dt, then slow bodies stop.
+	// A body stops when |v| < min(MIN_LINEAR_THRESHOLD, |g| * drag * dt), static bodies get a 0 threshold.
+	glm::vec3 gravityStep = gravity * timeStep;
+	float gravityThreshold = glm::length(gravity) * timeStep;
+
+	int i = begin;
+#if defined(PHYSICS_SIMD_AVX)
+	{
+		const __m256 gx = _mm256_set1_ps(gravityStep.x);
+		const __m256 gy = _mm256_set1_ps(gravityStep.y);
+		const __m256 gz = _mm256_set1_ps(gravityStep.z);
+		const __m256 dt = _mm256_set1_ps(timeStep);
+		const __m256 minThreshold = _mm256_set1_ps(MIN_LINEAR_THRESHOLD);
+		const __m256 gThreshold = _mm256_set1_ps(gravityThreshold);
+		for (; i + 8 <= end; i += 8)
+		{
+			__m256 gf = _mm256_loadu_ps(gravityFactor + i);
+			__m256 df = _mm256_loadu_ps(dragFactor + i);
+			__m256 mf = _mm256_loadu_ps(moveFactor + i);
+
+			__m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(velocityX + i), _mm256_mul_ps(gx, gf)), df);
+			__m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(velocityY + i), _mm256_mul_ps(gy, gf)), df);
+			__m256 vz = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(velocityZ + i), _mm256_mul_ps(gz, gf)), df);
+
+			__m256 step = _mm256_mul_ps(dt, mf);
+			_mm256_storeu_ps(positionX + i, _mm256_add_ps(_mm256_loadu_ps(positionX + i), _mm256_mul_ps(vx, step)));
+			_mm256_storeu_ps(positionY + i, _mm256_add_ps(_mm256_loadu_ps(positionY + i), _mm256_mul_ps(vy, step)));
+			_mm256_storeu_ps(positionZ + i, _mm256_add_ps(_mm256_loadu_ps(positionZ + i), _mm256_mul_ps(vz, step)));
+
+			__m256 speedSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+			__m256 threshold = _mm256_mul_ps(_mm256_min_ps(minThreshold, _mm256_mul_ps(gThreshold, _mm256_loadu_ps(linearDrag + i))), mf);
+			__m256 keep = _mm256_cmp_ps(speedSq, _mm256_mul_ps(threshold, threshold), _CMP_GE_OQ);
+
+			_mm256_storeu_ps(velocityX + i, _mm256_and_ps(vx, keep));
+			_mm256_storeu_ps(velocityY + i, _mm256_and_ps(vy, keep));
+			_mm256_storeu_ps(velocityZ + i, _mm256_and_ps(vz, keep));
+		}
+	}
+#endif
+#if defined(PHYSICS_SIMD_SSE)
+	{
+		const __m128 gx = _mm_set1_ps(gravityStep.x);
+		const __m128 gy = _mm_set1_ps(gravityStep.y);
+		const __m128 gz = _mm_set1_ps(gravityStep.z);
+		const __m128 dt = _mm_set1_ps(timeStep);
+		const __m128 minThreshold = _mm_set1_ps(MIN_LINEAR_THRESHOLD);
+		const __m128 gThreshold = _mm_set1_ps(gravityThreshold);
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 gf = _mm_loadu_ps(gravityFactor + i);
+			__m128 df = _mm_loadu_ps(dragFactor + i);
+			__m128 mf = _mm_loadu_ps(moveFactor + i);
+
+			__m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocityX + i), _mm_mul_ps(gx, gf)), df);
+			__m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocityY + i), _mm_mul_ps(gy, gf)), df);
+			__m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocityZ + i), _mm_mul_ps(gz, gf)), df);
+
+			__m128 step = _mm_mul_ps(dt, mf);
+			_mm_storeu_ps(positionX + i, _mm_add_ps(_mm_loadu_ps(positionX + i), _mm_mul_ps(vx, step)));
+			_mm_storeu_ps(positionY + i, _mm_add_ps(_mm_loadu_ps(positionY + i), _mm_mul_ps(vy, step)));
+			_mm_storeu_ps(positionZ + i, _mm_add_ps(_mm_loadu_ps(positionZ + i), _mm_mul_ps(vz, step)));
+
+			__m128 speedSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+			__m128 threshold = _mm_mul_ps(_mm_min_ps(minThreshold, _mm_mul_ps(gThreshold, _mm_loadu_ps(linearDrag + i))), mf);
+			__m128 keep = _mm_cmpge_ps(speedSq, _mm_mul_ps(threshold, threshold));
+
+			_mm_storeu_ps(velocityX + i, _mm_and_ps(vx, keep));
+			_mm_storeu_ps(velocityY + i, _mm_and_ps(vy, keep));
+			_mm_storeu_ps(velocityZ + i, _mm_and_ps(vz, keep));
+		}
+	}
+#endif
+	// remaining bodies
+	for (; i < end; i++)
+	{
+		float vx = (velocityX[i] + gravityStep.x * gravityFactor[i]) * dragFactor[i];
+		float vy = (velocityY[i] + gravityStep.y * gravityFactor[i]) * dragFactor[i];
+		float vz = (velocityZ[i] + gravityStep.z * gravityFactor[i]) * dragFactor[i];
+
+		float step = timeStep * moveFactor[i];
+		positionX[i] += vx * step;
+		positionY[i] += vy * step;
+		positionZ[i] += vz * step;
+
+		float speedSq = vx * vx + vy * vy + vz * vz;
+		float threshold = std::min(MIN_LINEAR_THRESHOLD, gravityThreshold * linearDrag[i]) * moveFactor[i];
+		bool keep = speedSq >= threshold * threshold;
+		velocityX[i] = keep ? vx : 0.0f;
+		velocityY[i] = keep ? vy : 0.0f;
+		velocityZ[i] = keep ? vz : 0.0f;
+	}
+}
+
+void RigidBodyWorld::IntegrateRotations(float timeStep)
+{
+	// rotations are rare (bodies are rotation locked by default), they stay on the bodies
+	for (int i = 0; i < m_numberOfAwake; i++)
+	{
+		if ((m_flags[i] & (BODY_STATIC | BODY_ROTATION_LOCK)) != 0)
+		{
+			continue;
+		}
+		RigidBodyData& data = m_bodies[i]->m_data;
+		if ((m_flags[i] & BODY_KINEMATIC) == 0)
+		{
+			data.angularVelocity *= data.angularDrag;
+		}
+
+		if (data.rotation.z > 360.0f || data.rotation.z < -360.0f)
+		{
+			data.rotation.z = 0.0f;
+		}
+		else
+		{
+			data.rotation += data.angularVelocity * timeStep;
+		}
+
+		if (glm::length(data.angularVelocity) < MIN_ROTATION_THRESHOLD)
+		{
+			if (glm::length(GetVelocity(i)) < glm::length(data.angularVelocity))
+			{
+				data.angularVelocity = glm::vec3(0.0f);
+			}
+		}
+	}
+}
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include "glm/glm.hpp"
+
+namespace ntn
+{
+	class RigidBody;
+	class SnapshotWriter;
+	class SnapshotReader;
+
+	enum RigidBodyFlags : uint8_t
+	{
+		BODY_STATIC = 1 << 0,
+		BODY_KINEMATIC = 1 << 1,
+		BODY_ON_GROUND = 1 << 2,
+		BODY_ROTATION_LOCK = 1 << 3,
+		BODY_SLEEPING = 1 << 4
+	};
+
+	// Hot state of every rigid body of a scene in structure of arrays form.
+	// Bodies added here keep only a handle (world + index), their position, velocity, mass,
+	// drag and flags live in the arrays below so integration streams through memory.
+	// Removing a body moves the last one into its slot, indices are not stable.
+	// Awake bodies are kept in front of the sleeping ones so the kernels only walk [0, numberOfAwakeBodies()).
+	class RigidBodyWorld
+	{
+	public:
+		RigidBodyWorld() = default;
+		~RigidBodyWorld();
+
+		RigidBodyWorld(const RigidBodyWorld&) = delete;
+		RigidBodyWorld& operator=(const RigidBodyWorld&) = delete;
+
+		// copy the body state in and attach the body
+		void Add(RigidBody* body);
+		// copy the state back to the body and detach it
+		void Remove(RigidBody* body);
+		void Clear();
+
+		// gravity, drag and position for every awake body, SSE/AVX when available
+		void Integrate(const glm::vec3& gravity, float timeStep);
+		// keep the positions of the last step for render interpolation
+		void StorePreviousPositions();
+
+		// sleeping bodies keep their state but are not integrated until woken up
+		void Sleep(RigidBody* body);
+		void Wake(RigidBody* body);
+		// count the frames each awake body stays below the velocity threshold, reset it otherwise
+		void UpdateSleepFrames(float velocityThreshold);
+		int GetSleepFrames(int index) const { return m_sleepFrames[index]; }
+
+		// every array as it is, the bodies themselves are matched by the caller
+		void WriteState(SnapshotWriter& writer) const;
+		// bodies[i] takes slot i, they must be the bodies of this world
+		bool ReadState(SnapshotReader& reader, const std::vector<RigidBody*>& bodies);
+		// reads past what ReadState would read, false when it would fail for count bodies
+		static bool CheckState(SnapshotReader& reader, size_t count);
+
+		int numberOfBodies() const { return (int)m_bodies.size(); }
+		int numberOfAwakeBodies() const { return m_numberOfAwake; }
+		RigidBody* GetBody(int index) const { return m_bodies[index]; }
+
+		glm::vec3 GetPosition(int index) const { return glm::vec3(m_positionX[index], m_positionY[index], m_positionZ[index]); }
+		glm::vec3 GetPreviousPosition(int index) const { return glm::vec3(m_previousX[index], m_previousY[index], m_previousZ[index]); }
+		// alpha 0 is the previous step, 1 the current one
+		glm::vec3 GetInterpolatedPosition(int index, float alpha) const { return glm::mix(GetPreviousPosition(index), GetPosition(index), alpha); }
+		glm::vec3 GetVelocity(int index) const { return glm::vec3(m_velocityX[index], m_velocityY[index], m_velocityZ[index]); }
+		float GetMass(int index) const { return m_mass[index]; }
+		float GetLinearDrag(int index) const { return m_linearDrag[index]; }
+		bool HasFlag(int index, RigidBodyFlags flag) const { return (m_flags[index] & flag) != 0; }
+
+		void SetPosition(int index, const glm::vec3& position)
+		{
+			m_positionX[index] = position.x;
+			m_positionY[index] = position.y;
+			m_positionZ[index] = position.z;
+		}
+		void SetVelocity(int index, const glm::vec3& velocity)
+		{
+			m_velocityX[index] = velocity.x;
+			m_velocityY[index] = velocity.y;
+			m_velocityZ[index] = velocity.z;
+		}
+		void SetMass(int index, float mass) { m_mass[index] = mass; }
+		void SetLinearDrag(int index, float linearDrag) { m_linearDrag[index] = linearDrag; UpdateCoefficients(index); }
+		void SetFlag(int index, RigidBodyFlags flag, bool value);
+
+	private:
+		// flags folded into per body factors so the kernels run without branches
+		void UpdateCoefficients(int index);
+		void IntegrateRange(int begin, int end, const glm::vec3& gravity, float timeStep);
+		void IntegrateRotations(float timeStep);
+		void SwapBodies(int indexA, int indexB);
+
+		std::vector<float> m_positionX, m_positionY, m_positionZ;
+		std::vector<float> m_previousX, m_previousY, m_previousZ;
+		std::vector<float> m_velocityX, m_velocityY, m_velocityZ;
+		std::vector<float> m_mass;
+		std::vector<float> m_linearDrag;
+		std::vector<uint8_t> m_flags;
+
+		std::vector<float> m_gravityFactor;	// 0 for static and grounded bodies
+		std::vector<float> m_dragFactor;	// velocity multiplier, 1 when drag does not apply
+		std::vector<float> m_moveFactor;	// 0 for static bodies
+
+		std::vector<int> m_sleepFrames;
+
+		std::vector<RigidBody*> m_bodies;
+		int m_numberOfAwake = 0;
+	};
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// Instruction set picked at compile time for the physics kernels.
+// AVX needs /arch:AVX (or -mavx), SSE2 is always there on x64. Other targets take the scalar paths.
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define PHYSICS_SIMD_AVX
+	#define PHYSICS_SIMD_SSE
+	#define PHYSICS_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define PHYSICS_SIMD_SSE
+	#define PHYSICS_SIMD_WIDTH 4
+#else
+	#define PHYSICS_SIMD_WIDTH 1
+#endif
@@ -0,0 +1,634 @@
+#include "SpatialHashGrid.h"
+#include "PhysicsObject.h"
+#include "RigidBody.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ntn
+{
+
+// sleeping bodies do not move until something wakes them, like static ones they never collide with each other
+static bool IsStaticBody(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && (object->Rigidbody()->isStatic() || object->Rigidbody()->isSleeping());
+}
+
+static bool IsSleepingBody(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && object->Rigidbody()->isSleeping();
+}
+
+/*********************************************************************************************************
+* Proxies
+**********************************************************************************************************/
+void SpatialHashGrid::Insert(PhysicsObject* object)
+{
+	int proxyId;
+	if (!m_freeProxies.empty())
+	{
+		proxyId = m_freeProxies.back();
+		m_freeProxies.pop_back();
+	}
+	else
+	{
+		proxyId = (int)m_proxies.size();
+		m_proxies.emplace_back();
+		m_rayStamps.push_back(0);
+	}
+
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.object = object;
+	proxy.bounds = object->GetWorldBounds();
+	proxy.isStatic = IsStaticBody(object);
+	object->SetProxyId(proxyId);
+	m_dirty = true;
+	m_restingDirty = m_restingDirty || proxy.isStatic;
+}
+
+void SpatialHashGrid::Remove(PhysicsObject* object)
+{
+	int proxyId = object->GetProxyId();
+	if (proxyId < 0 || proxyId >= (int)m_proxies.size() || m_proxies[proxyId].object != object)
+	{
+		return;
+	}
+	m_restingDirty = m_restingDirty || m_proxies[proxyId].isStatic;
+	m_proxies[proxyId] = Proxy();
+	m_freeProxies.push_back(proxyId);
+	object->SetProxyId(-1);
+	m_dirty = true;
+}
+
+void SpatialHashGrid::Clear()
+{
+	for (Proxy& proxy : m_proxies)
+	{
+		if (proxy.object != nullptr)
+		{
+			proxy.object->SetProxyId(-1);
+		}
+	}
+	m_proxies.clear();
+	m_freeProxies.clear();
+	m_largeProxies.clear();
+	m_awakeTable.usedCells.clear();
+	m_awakeTable.cellProxies.clear();
+	m_restingTable.usedCells.clear();
+	m_restingTable.cellProxies.clear();
+	m_rayStamps.clear();
+	m_pairs.clear();
+	m_pairIds.clear();
+	m_dirty = true;
+	m_restingDirty = true;
+}
+
+void SpatialHashGrid::Update(float)
+{
+	for (Proxy& proxy : m_proxies)
+	{
+		if (proxy.object == nullptr)
+		{
+			continue;
+		}
+		bool isStatic = IsStaticBody(proxy.object);
+		if (isStatic != proxy.isStatic)
+		{
+			m_restingDirty = true;
+			proxy.isStatic = isStatic;
+		}
+		// a sleeping body kept the bounds it had when it fell asleep
+		if (IsSleepingBody(proxy.object))
+		{
+			continue;
+		}
+		AABB bounds = proxy.object->GetWorldBounds();
+		// a static body only moves when the user drags it
+		if (isStatic && (bounds.min != proxy.bounds.min || bounds.max != proxy.bounds.max))
+		{
+			m_restingDirty = true;
+		}
+		proxy.bounds = bounds;
+	}
+
+	Rebuild();
+}
+
+/*********************************************************************************************************
+* Hash table
+**********************************************************************************************************/
+glm::ivec3 SpatialHashGrid::CellCoord(const glm::vec3& position) const
+{
+	// clamp so far away bodies cannot overflow the integer coordinates
+	const float limit = 1073741824.0f;
+	glm::vec3 coord = glm::clamp(glm::floor(position / m_cellSize), glm::vec3(-limit), glm::vec3(limit));
+	return glm::ivec3(coord);
+}
+
+uint32_t SpatialHashGrid::HashCell(const glm::ivec3& coord)
+{
+	return ((uint32_t)coord.x * 73856093u) ^ ((uint32_t)coord.y * 19349663u) ^ ((uint32_t)coord.z * 83492791u);
+}
+
+int SpatialHashGrid::FindCell(const CellTable& table, const glm::ivec3& coord)
+{
+	if (table.cells.empty())
+	{
+		return -1;
+	}
+	uint32_t mask = (uint32_t)table.cells.size() - 1;
+	// linear probing, the table is at most half full so an empty slot ends the search
+	for (uint32_t slot = HashCell(coord) & mask;; slot = (slot + 1) & mask)
+	{
+		const Cell& cell = table.cells[slot];
+		if (cell.stamp != table.stamp)
+		{
+			return -1;
+		}
+		if (cell.coord == coord)
+		{
+			return (int)slot;
+		}
+	}
+}
+
+int SpatialHashGrid::FindOrAddCell(CellTable& table, const glm::ivec3& coord)
+{
+	uint32_t mask = (uint32_t)table.cells.size() - 1;
+	for (uint32_t slot = HashCell(coord) & mask;; slot = (slot + 1) & mask)
+	{
+		Cell& cell = table.cells[slot];
+		if (cell.stamp != table.stamp)
+		{
+			cell.coord = coord;
+			cell.stamp = table.stamp;
+			cell.start = 0;
+			cell.count = 0;
+			table.usedCells.push_back((int)slot);
+			return (int)slot;
+		}
+		if (cell.coord == coord)
+		{
+			return (int)slot;
+		}
+	}
+}
+
+void SpatialHashGrid::ComputeCellSize()
+{
+	m_sizes.clear();
+	for (const Proxy& proxy : m_proxies)
+	{
+		if (proxy.object != nullptr)
+		{
+			glm::vec3 size = proxy.bounds.max - proxy.bounds.min;
+			m_sizes.push_back(std::max(std::max(size.x, size.y), size.z));
+		}
+	}
+	if (m_sizes.empty())
+	{
+		return;
+	}
+	// median body size: half the bodies fit in one cell, the others span a few
+	auto median = m_sizes.begin() + m_sizes.size() / 2;
+	std::nth_element(m_sizes.begin(), median, m_sizes.end());
+	m_cellSize = std::max(*median, 0.01f);
+}
+
+void SpatialHashGrid::Rebuild()
+{
+	// body sizes only change with the set of bodies, a new cell size moves every cell
+	if (m_dirty)
+	{
+		float cellSize = m_cellSize;
+		ComputeCellSize();
+		m_restingDirty = m_restingDirty || m_cellSize != cellSize;
+	}
+	m_dirty = false;
+
+	if (m_restingDirty)
+	{
+		BuildTable(m_restingTable, true);
+		m_restingDirty = false;
+	}
+	BuildTable(m_awakeTable, false);
+	m_gridBounds = AABB::Union(m_awakeTable.bounds, m_restingTable.bounds);
+
+	m_largeProxies.clear();
+	for (int proxyId = 0; proxyId < (int)m_proxies.size(); proxyId++)
+	{
+		if (m_proxies[proxyId].object != nullptr && m_proxies[proxyId].isLarge)
+		{
+			m_largeProxies.push_back(proxyId);
+		}
+	}
+}
+
+void SpatialHashGrid::BuildTable(CellTable& table, bool resting)
+{
+	table.usedCells.clear();
+	table.bounds = AABB();
+
+	// cell ranges first, it gives the number of entries to size the table
+	int entryCount = 0;
+	for (Proxy& proxy : m_proxies)
+	{
+		if (proxy.object == nullptr || proxy.isStatic != resting)
+		{
+			continue;
+		}
+		proxy.minCell = CellCoord(proxy.bounds.min);
+		proxy.maxCell = CellCoord(proxy.bounds.max);
+		table.bounds = AABB::Union(table.bounds, proxy.bounds);
+
+		glm::ivec3 span = proxy.maxCell - proxy.minCell + glm::ivec3(1);
+		long long cellCount = (long long)span.x * span.y * span.z;
+		proxy.isLarge = cellCount > MAX_CELLS_PER_PROXY;
+		if (!proxy.isLarge)
+		{
+			entryCount += (int)cellCount;
+		}
+	}
+
+	// keep the load factor under one half, the table only ever grows
+	size_t capacity = 64;
+	while (capacity < (size_t)entryCount * 2)
+	{
+		capacity *= 2;
+	}
+	if (table.cells.size() < capacity)
+	{
+		table.cells.assign(capacity, Cell());
+		table.stamp = 0;
+	}
+	// a new stamp empties every slot without touching the table
+	table.stamp++;
+	if (table.stamp == 0)
+	{
+		std::fill(table.cells.begin(), table.cells.end(), Cell());
+		table.stamp = 1;
+	}
+
+	// count the entries per cell
+	for (const Proxy& proxy : m_proxies)
+	{
+		if (proxy.object == nullptr || proxy.isStatic != resting || proxy.isLarge)
+		{
+			continue;
+		}
+		for (int z = proxy.minCell.z; z <= proxy.maxCell.z; z++)
+			for (int y = proxy.minCell.y; y <= proxy.maxCell.y; y++)
+				for (int x = proxy.minCell.x; x <= proxy.maxCell.x; x++)
+				{
+					table.cells[FindOrAddCell(table, glm::ivec3(x, y, z))].count++;
+				}
+	}
+
+	// prefix sum gives every cell its range in the flat entry array
+	int offset = 0;
+	for (int slot : table.usedCells)
+	{
+		Cell& cell = table.cells[slot];
+		cell.start = offset;
+		offset += cell.count;
+		cell.count = 0;
+	}
+	table.cellProxies.resize(offset);
+
+	// scatter, proxies end up sorted by id inside each cell
+	for (int proxyId = 0; proxyId < (int)m_proxies.size(); proxyId++)
+	{
+		const Proxy& proxy = m_proxies[proxyId];
+		if (proxy.object == nullptr || proxy.isStatic != resting || proxy.isLarge)
+		{
+			continue;
+		}
+		for (int z = proxy.minCell.z; z <= proxy.maxCell.z; z++)
+			for (int y = proxy.minCell.y; y <= proxy.maxCell.y; y++)
+				for (int x = proxy.minCell.x; x <= proxy.maxCell.x; x++)
+				{
+					Cell& cell = table.cells[FindCell(table, glm::ivec3(x, y, z))];
+					table.cellProxies[cell.start + cell.count++] = proxyId;
+				}
+	}
+}
+
+/*********************************************************************************************************
+* Pairs
+**********************************************************************************************************/
+void SpatialHashGrid::CollectCellPairs(int cellIndex, std::vector<std::pair<int, int>>& pairIds) const
+{
+	// two bodies can share several cells, only the cell holding
+	// the min corner of their overlap reports the pair
+	const Cell& cell = m_awakeTable.cells[cellIndex];
+	const int* entries = m_awakeTable.cellProxies.data() + cell.start;
+	for (int i = 0; i < cell.count; i++)
+	{
+		const Proxy& proxyA = m_proxies[entries[i]];
+		for (int j = i + 1; j < cell.count; j++)
+		{
+			const Proxy& proxyB = m_proxies[entries[j]];
+			if (!proxyA.bounds.Overlaps(proxyB.bounds) || !PhysicsObject::CanCollide(proxyA.object, proxyB.object))
+			{
+				continue;
+			}
+			glm::vec3 overlapMin = glm::max(proxyA.bounds.min, proxyB.bounds.min);
+			if (CellCoord(overlapMin) == cell.coord)
+			{
+				pairIds.emplace_back(entries[i], entries[j]);
+			}
+		}
+	}
+
+	// awake bodies against the resting ones of the same cell, resting bodies never collide with each other
+	int restingSlot = FindCell(m_restingTable, cell.coord);
+	if (restingSlot < 0)
+	{
+		return;
+	}
+	const Cell& restingCell = m_restingTable.cells[restingSlot];
+	const int* restingEntries = m_restingTable.cellProxies.data() + restingCell.start;
+	for (int i = 0; i < cell.count; i++)
+	{
+		const Proxy& proxyA = m_proxies[entries[i]];
+		for (int j = 0; j < restingCell.count; j++)
+		{
+			const Proxy& proxyB = m_proxies[restingEntries[j]];
+			if (!proxyA.bounds.Overlaps(proxyB.bounds) || !PhysicsObject::CanCollide(proxyA.object, proxyB.object))
+			{
+				continue;
+			}
+			glm::vec3 overlapMin = glm::max(proxyA.bounds.min, proxyB.bounds.min);
+			if (CellCoord(overlapMin) == cell.coord)
+			{
+				pairIds.emplace_back(std::min(entries[i], restingEntries[j]), std::max(entries[i], restingEntries[j]));
+			}
+		}
+	}
+}
+
+const std::vector<BroadphasePair>& SpatialHashGrid::ComputePairs()
+{
+	if (m_dirty)
+	{
+		Rebuild();
+	}
+
+	JobSystem& jobSystem = JobSystem::getInstance();
+	if ((int)m_threadPairs.size() < jobSystem.numberOfThreads())
+	{
+		m_threadPairs.resize(jobSystem.numberOfThreads());
+	}
+	for (auto& threadPairs : m_threadPairs)
+	{
+		threadPairs.clear();
+	}
+
+	// cells are independent, each thread fills its own buffer
+	jobSystem.ParallelFor((int)m_awakeTable.usedCells.size(), 256, [this](int begin, int end, int threadIndex)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				CollectCellPairs(m_awakeTable.usedCells[i], m_threadPairs[threadIndex]);
+			}
+		});
+
+	m_pairIds.clear();
+	for (const auto& threadPairs : m_threadPairs)
+	{
+		m_pairIds.insert(m_pairIds.end(), threadPairs.begin(), threadPairs.end());
+	}
+
+	// large bodies against everything
+	for (int largeId : m_largeProxies)
+	{
+		const Proxy& large = m_proxies[largeId];
+		for (int proxyId = 0; proxyId < (int)m_proxies.size(); proxyId++)
+		{
+			const Proxy& proxy = m_proxies[proxyId];
+			if (proxy.object == nullptr || proxyId == largeId || (proxy.isLarge && proxyId < largeId))
+			{
+				continue;
+			}
+			if ((large.isStatic && proxy.isStatic) || !large.bounds.Overlaps(proxy.bounds) || !PhysicsObject::CanCollide(large.object, proxy.object))
+			{
+				continue;
+			}
+			m_pairIds.emplace_back(std::min(largeId, proxyId), std::max(largeId, proxyId));
+		}
+	}
+
+	// the thread split must not change the response order
+	std::sort(m_pairIds.begin(), m_pairIds.end());
+
+	m_pairs.clear();
+	for (const auto& pairId : m_pairIds)
+	{
+		m_pairs.push_back({ m_proxies[pairId.first].object, m_proxies[pairId.second].object });
+	}
+	return m_pairs;
+}
+
+/*********************************************************************************************************
+* Queries
+**********************************************************************************************************/
+void SpatialHashGrid::QueryCell(const CellTable& table, const glm::ivec3& coord, const AABB& bounds, std::vector<PhysicsObject*>& results) const
+{
+	int slot = FindCell(table, coord);
+	if (slot < 0)
+	{
+		return;
+	}
+	const Cell& cell = table.cells[slot];
+	for (int i = 0; i < cell.count; i++)
+	{
+		const Proxy& proxy = m_proxies[table.cellProxies[cell.start + i]];
+		if (proxy.object == nullptr || !proxy.bounds.Overlaps(bounds))
+		{
+			continue;
+		}
+		// same rule as the pairs, one report per proxy
+		if (CellCoord(glm::max(proxy.bounds.min, bounds.min)) == coord)
+		{
+			results.push_back(proxy.object);
+		}
+	}
+}
+
+void SpatialHashGrid::QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results)
+{
+	if (m_dirty)
+	{
+		Rebuild();
+	}
+
+	glm::ivec3 minCell = CellCoord(bounds.min);
+	glm::ivec3 maxCell = CellCoord(bounds.max);
+	glm::ivec3 span = maxCell - minCell + glm::ivec3(1);
+	long long cellCount = (long long)span.x * span.y * span.z;
+
+	// a box wider than the populated cells is cheaper to test against every proxy
+	if (cellCount > (long long)numberOfCells())
+	{
+		for (const Proxy& proxy : m_proxies)
+		{
+			if (proxy.object != nullptr && proxy.bounds.Overlaps(bounds))
+			{
+				results.push_back(proxy.object);
+			}
+		}
+		return;
+	}
+
+	for (int z = minCell.z; z <= maxCell.z; z++)
+		for (int y = minCell.y; y <= maxCell.y; y++)
+			for (int x = minCell.x; x <= maxCell.x; x++)
+			{
+				QueryCell(m_awakeTable, glm::ivec3(x, y, z), bounds, results);
+				QueryCell(m_restingTable, glm::ivec3(x, y, z), bounds, results);
+			}
+
+	for (int largeId : m_largeProxies)
+	{
+		const Proxy& large = m_proxies[largeId];
+		if (large.object != nullptr && large.bounds.Overlaps(bounds))
+		{
+			results.push_back(large.object);
+		}
+	}
+}
+
+bool SpatialHashGrid::GetBounds(const PhysicsObject* object, AABB& bounds) const
+{
+	int proxyId = object->GetProxyId();
+	if (proxyId < 0 || proxyId >= (int)m_proxies.size() || m_proxies[proxyId].object != object)
+	{
+		return false;
+	}
+	bounds = m_proxies[proxyId].bounds;
+	return true;
+}
+
+void SpatialHashGrid::ReportRayProxy(int proxyId, const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& direction,
+									 float& maxDistance, const RayCastCallback& callback, bool& stop)
+{
+	const Proxy& proxy = m_proxies[proxyId];
+	if (proxy.object == nullptr || m_rayStamps[proxyId] == m_rayStamp)
+	{
+		return;
+	}
+	m_rayStamps[proxyId] = m_rayStamp;
+
+	float distance;
+	if (!proxy.bounds.RayIntersect(origin, invDirection, maxDistance, distance))
+	{
+		return;
+	}
+	float value = callback(proxy.object, origin, direction, maxDistance);
+	if (value == 0.0f)
+	{
+		stop = true;
+		return;
+	}
+	maxDistance = std::min(maxDistance, value);
+}
+
+void SpatialHashGrid::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback)
+{
+	if (m_dirty)
+	{
+		Rebuild();
+	}
+
+	m_rayStamp++;
+	if (m_rayStamp == 0)
+	{
+		std::fill(m_rayStamps.begin(), m_rayStamps.end(), 0u);
+		m_rayStamp = 1;
+	}
+
+	glm::vec3 invDirection = 1.0f / direction;
+	bool stop = false;
+	for (int largeId : m_largeProxies)
+	{
+		ReportRayProxy(largeId, origin, invDirection, direction, maxDistance, callback, stop);
+		if (stop)
+		{
+			return;
+		}
+	}
+
+	// clip the ray to the populated part of the grid
+	float tEnter;
+	if (numberOfCells() == 0 || !m_gridBounds.RayIntersect(origin, invDirection, maxDistance, tEnter))
+	{
+		return;
+	}
+
+	// walk the cells in ray order, a cell starting past the closest hit ends the walk
+	glm::vec3 start = origin + direction * tEnter;
+	glm::ivec3 cell = glm::clamp(CellCoord(start), CellCoord(m_gridBounds.min), CellCoord(m_gridBounds.max));
+	glm::ivec3 step;
+	glm::vec3 tNext;
+	glm::vec3 tDelta;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (direction[axis] > 0.0f)
+		{
+			step[axis] = 1;
+			tNext[axis] = tEnter + ((cell[axis] + 1) * m_cellSize - start[axis]) * invDirection[axis];
+			tDelta[axis] = m_cellSize * invDirection[axis];
+		}
+		else if (direction[axis] < 0.0f)
+		{
+			step[axis] = -1;
+			tNext[axis] = tEnter + (cell[axis] * m_cellSize - start[axis]) * invDirection[axis];
+			tDelta[axis] = -m_cellSize * invDirection[axis];
+		}
+		else
+		{
+			step[axis] = 0;
+			tNext[axis] = std::numeric_limits<float>::max();
+			tDelta[axis] = std::numeric_limits<float>::max();
+		}
+	}
+
+	glm::ivec3 lastCell = CellCoord(m_gridBounds.max);
+	glm::ivec3 firstCell = CellCoord(m_gridBounds.min);
+	for (;;)
+	{
+		for (const CellTable* table : { &m_awakeTable, &m_restingTable })
+		{
+			int slot = FindCell(*table, cell);
+			if (slot < 0)
+			{
+				continue;
+			}
+			const Cell& gridCell = table->cells[slot];
+			for (int i = 0; i < gridCell.count; i++)
+			{
+				ReportRayProxy(table->cellProxies[gridCell.start + i], origin, invDirection, direction, maxDistance, callback, stop);
+				if (stop)
+				{
+					return;
+				}
+			}
+		}
+
+		int axis = 0;
+		if (tNext[1] < tNext[axis]) axis = 1;
+		if (tNext[2] < tNext[axis]) axis = 2;
+		if (tNext[axis] > maxDistance)
+		{
+			return;
+		}
+		cell[axis] += step[axis];
+		if (cell[axis] < firstCell[axis] || cell[axis] > lastCell[axis])
+		{
+			return;
+		}
+		tNext[axis] += tDelta[axis];
+	}
+}
+}
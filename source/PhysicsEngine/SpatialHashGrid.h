@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Broadphase.h"
+
+namespace ntn
+{
+	// Uniform grid hashed into open addressed tables. Suited to many bodies of similar size: the cell size
+	// follows the median body size so most bodies touch at most 8 cells. Bodies spanning too many cells are tested apart.
+	// Awake bodies are hashed again every step, static and sleeping ones sit in a second table that is only
+	// rebuilt when one of them wakes, falls asleep or moves.
+	// All buffers keep their capacity between steps, a rebuild does not allocate once warm.
+	class SpatialHashGrid : public Broadphase
+	{
+	public:
+		SpatialHashGrid() = default;
+
+		void Insert(PhysicsObject* object) override;
+		void Remove(PhysicsObject* object) override;
+		void Clear() override;
+
+		// refresh bounds and rebuild the awake table, the resting one only when it changed
+		void Update(float timeStep) override;
+		// cells are split in ranges across the job system, pairs are sorted afterwards
+		const std::vector<BroadphasePair>& ComputePairs() override;
+
+		void QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results) override;
+		bool GetBounds(const PhysicsObject* object, AABB& bounds) const override;
+		void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback) override;
+
+		int numberOfProxies() const override { return (int)(m_proxies.size() - m_freeProxies.size()); }
+		std::unique_ptr<Broadphase> Clone() const override { return std::make_unique<SpatialHashGrid>(*this); }
+		int numberOfCells() const { return (int)(m_awakeTable.usedCells.size() + m_restingTable.usedCells.size()); }
+		float GetCellSize() const { return m_cellSize; }
+
+	private:
+		// a body covering more cells than this goes to the large list
+		static const int MAX_CELLS_PER_PROXY = 64;
+
+		struct Proxy
+		{
+			PhysicsObject* object = nullptr;
+			AABB bounds;
+			glm::ivec3 minCell = glm::ivec3(0);
+			glm::ivec3 maxCell = glm::ivec3(0);
+			bool isStatic = false;	// static or sleeping, hashed in the resting table
+			bool isLarge = false;
+		};
+
+		struct Cell
+		{
+			glm::ivec3 coord = glm::ivec3(0);
+			uint32_t stamp = 0;	// cell is empty unless stamp matches the current build
+			int start = 0;		// first entry in cellProxies
+			int count = 0;
+		};
+
+		// open addressed table, capacity is a power of two
+		struct CellTable
+		{
+			std::vector<Cell> cells;
+			uint32_t stamp = 0;
+			std::vector<int> usedCells;
+			std::vector<int> cellProxies;
+			AABB bounds;
+		};
+
+		glm::ivec3 CellCoord(const glm::vec3& position) const;
+		static uint32_t HashCell(const glm::ivec3& coord);
+		static int FindCell(const CellTable& table, const glm::ivec3& coord);
+		static int FindOrAddCell(CellTable& table, const glm::ivec3& coord);
+
+		void ComputeCellSize();
+		void Rebuild();
+		// hash the proxies resting or not into the table
+		void BuildTable(CellTable& table, bool resting);
+		void CollectCellPairs(int cellIndex, std::vector<std::pair<int, int>>& pairIds) const;
+		void QueryCell(const CellTable& table, const glm::ivec3& coord, const AABB& bounds, std::vector<PhysicsObject*>& results) const;
+		void ReportRayProxy(int proxyId, const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& direction,
+							float& maxDistance, const RayCastCallback& callback, bool& stop);
+
+		std::vector<Proxy> m_proxies;
+		std::vector<int> m_freeProxies;
+		std::vector<int> m_largeProxies;
+
+		float m_cellSize = 1.0f;
+		std::vector<float> m_sizes;
+
+		CellTable m_awakeTable;
+		CellTable m_restingTable;
+		AABB m_gridBounds;
+		bool m_dirty = true;			// proxies were inserted or removed
+		bool m_restingDirty = true;		// a proxy joined or left the resting table, or a static one moved
+
+		// proxies already reported by the current ray query
+		std::vector<uint32_t> m_rayStamps;
+		uint32_t m_rayStamp = 0;
+
+		std::vector<std::vector<std::pair<int, int>>> m_threadPairs;
+		std::vector<std::pair<int, int>> m_pairIds;
+		std::vector<BroadphasePair> m_pairs;
+	};
+}
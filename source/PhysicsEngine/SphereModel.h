@@ -0,0 +1,68 @@
+#pragma once
+
+#include"Sphere.h"
+#include"../Model.h"
+#include"../BoundingBox.h"
+
+#include<memory>
+
+namespace ntn
+{
+// Sphere rendered with a model, the physics side stays in Sphere
+class SphereModel : public Sphere
+{
+public:
+	SphereModel() = default;
+
+	SphereModel(const std::string& pathToModel, const glm::vec3& position = glm::vec3(0.0f),
+		glm::vec3 velocity = glm::vec3(1.0f, 0.0f, 0.0f),
+		float mass = 10.f, const glm::vec3& scale = glm::vec3(1.0f),
+		float radius= 10.f);
+
+	//Ball(Model* model, const glm::vec3& position = glm::vec3(0.0f),
+	//const glm::vec3& rotation = glm::vec3(0.0f),
+	//const glm::vec3& scale = glm::vec3(1.0f));
+
+	virtual ~SphereModel() {};
+
+	// larger than a Sphere, the models get their own pool
+	static void* operator new(size_t size) { return ObjectPool<SphereModel>::Allocate(size); }
+	static void operator delete(void* pointer, size_t size) { ObjectPool<SphereModel>::Free(pointer, size); }
+
+	std::string GetInfo();
+	// from a published transform, other threads must not read the live body
+	std::string GetInfo(const glm::vec3& position, const glm::vec3& rotation) const;
+	
+//	glm::vec3 GetPosition() override;
+
+//	void SetRotation(const glm::vec3& newRotation);
+//	inline glm::vec3 GetRotation() const { return m_rotation; }
+
+	inline void SetScale(const glm::vec3& newScale) { m_scale = newScale; }
+	inline glm::vec3 GetScale() const { return m_scale; }
+	
+	void Translation(const glm::vec3&& deltaPos = glm::vec3(0.0f));
+
+	inline void SetModel(Model* model) { m_model.reset(model); }
+	inline const std::unique_ptr<Model>& GetModel() const { return m_model; }
+
+	// at the transform published by the physics thread, not the live one it is stepping
+	void Render(Shader& shader, const glm::vec3& position, const glm::vec3& rotation);
+
+	void ComputeBoundingBox();
+
+	// the box follows the body lazily, integration does not touch it
+	const BoundingBox& GetBoundingBox() const;
+	// the same box around a published position, leaves the cached one alone
+	BoundingBox GetBoundingBoxAt(const glm::vec3& position) const;
+
+private:
+	std::unique_ptr<Model> m_model = nullptr;
+	void LoadModel(const std::string& pathToModel);
+	glm::vec3 m_scale = glm::vec3(1.0f);
+	mutable BoundingBox m_bbox;
+	mutable glm::vec3 m_bboxPosition = glm::vec3(0.0f);
+
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include "SweepAndPrune.h"
+#include "PhysicsObject.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ntn
+{
+
+// sleeping bodies do not move until something wakes them, like static ones they never collide with each other
+static bool IsStaticBody(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && (object->Rigidbody()->isStatic() || object->Rigidbody()->isSleeping());
+}
+
+static bool IsSleepingBody(PhysicsObject* object)
+{
+	return object->Rigidbody() != nullptr && object->Rigidbody()->isSleeping();
+}
+
+static bool EndpointLess(float valueA, bool isMinA, float valueB, bool isMinB)
+{
+	// at equal values min endpoints go first so touching boxes still overlap
+	if (valueA != valueB)
+	{
+		return valueA < valueB;
+	}
+	return isMinA && !isMinB;
+}
+
+void SweepAndPrune::Insert(PhysicsObject* object)
+{
+	int proxyId;
+	if (!m_freeProxies.empty())
+	{
+		proxyId = m_freeProxies.back();
+		m_freeProxies.pop_back();
+	}
+	else
+	{
+		proxyId = (int)m_proxies.size();
+		m_proxies.emplace_back();
+	}
+
+	Proxy& proxy = m_proxies[proxyId];
+	proxy.object = object;
+	proxy.bounds = object->GetWorldBounds();
+	proxy.isStatic = IsStaticBody(object);
+	object->SetProxyId(proxyId);
+
+	// new endpoints are appended, the next insertion sort moves them in place
+	m_endpoints.push_back({ proxy.bounds.min[m_sortAxis], (uint32_t)proxyId, true });
+	m_endpoints.push_back({ proxy.bounds.max[m_sortAxis], (uint32_t)proxyId, false });
+	m_maxExtent = std::max(m_maxExtent, proxy.bounds.max[m_sortAxis] - proxy.bounds.min[m_sortAxis]);
+	m_sorted = false;
+}
+
+void SweepAndPrune::Remove(PhysicsObject* object)
+{
+	int proxyId = object->GetProxyId();
+	if (proxyId < 0 || proxyId >= (int)m_proxies.size() || m_proxies[proxyId].object != object)
+	{
+		return;
+	}
+
+	// the endpoints stay until the next sort drops all the removed ones in one pass
+	m_proxies[proxyId] = Proxy();
+	m_removedProxies.push_back(proxyId);
+	m_sorted = false;
+	object->SetProxyId(-1);
+}
+
+void SweepAndPrune::Clear()
+{
+	for (Proxy& proxy : m_proxies)
+	{
+		if (proxy.object != nullptr)
+		{
+			proxy.object->SetProxyId(-1);
+		}
+	}
+	m_proxies.clear();
+	m_freeProxies.clear();
+	m_removedProxies.clear();
+	m_endpoints.clear();
+	m_active.clear();
+	m_pairs.clear();
+	m_pairIds.clear();
+	m_maxExtent = 0.0f;
+	m_sorted = true;
+}
+
+void SweepAndPrune::Update(float)
+{
+	for (Proxy& proxy : m_proxies)
+	{
+		if (proxy.object == nullptr)
+		{
+			continue;
+		}
+		// a sleeping body kept the bounds it had when it fell asleep
+		if (!IsSleepingBody(proxy.object))
+		{
+			proxy.bounds = proxy.object->GetWorldBounds();
+		}
+		proxy.isStatic = IsStaticBody(proxy.object);
+	}
+
+	SelectSortAxis();
+	RefreshEndpointValues();
+	InsertionSortEndpoints();
+}
+
+void SweepAndPrune::SelectSortAxis()
+{
+	// sort along the axis where the bodies are spread the most,
+	// this keeps the number of boxes overlapping on the sort axis low
+	glm::vec3 sum(0.0f);
+	glm::vec3 sumSq(0.0f);
+	int count = 0;
+	for (const Proxy& proxy : m_proxies)
+	{
+		if (proxy.object == nullptr)
+		{
+			continue;
+		}
+		glm::vec3 center = proxy.bounds.GetCenter();
+		sum += center;
+		sumSq += center * center;
+		count++;
+	}
+	if (count < 2)
+	{
+		return;
+	}
+
+	glm::vec3 variance = sumSq / (float)count - (sum * sum) / (float)(count * count);
+	int bestAxis = 0;
+	if (variance[1] > variance[bestAxis]) bestAxis = 1;
+	if (variance[2] > variance[bestAxis]) bestAxis = 2;
+
+	// only switch on a clear winner, a switch costs a full sort
+	if (bestAxis != m_sortAxis && variance[bestAxis] > 1.5f * variance[m_sortAxis])
+	{
+		m_sortAxis = bestAxis;
+		RefreshEndpointValues();
+		std::sort(m_endpoints.begin(), m_endpoints.end(), [](const Endpoint& a, const Endpoint& b)
+			{
+				return EndpointLess(a.value, a.isMin, b.value, b.isMin);
+			});
+	}
+}
+
+void SweepAndPrune::RefreshEndpointValues()
+{
+	m_maxExtent = 0.0f;
+	for (Endpoint& endpoint : m_endpoints)
+	{
+		const AABB& bounds = m_proxies[endpoint.proxy].bounds;
+		endpoint.value = endpoint.isMin ? bounds.min[m_sortAxis] : bounds.max[m_sortAxis];
+		if (!endpoint.isMin)
+		{
+			m_maxExtent = std::max(m_maxExtent, bounds.max[m_sortAxis] - bounds.min[m_sortAxis]);
+		}
+	}
+}
+
+void SweepAndPrune::CompactEndpoints()
+{
+	if (m_removedProxies.empty())
+	{
+		return;
+	}
+	// a removed proxy has no object, its slot is only reused once its endpoints are gone
+	m_endpoints.erase(std::remove_if(m_endpoints.begin(), m_endpoints.end(),
+		[this](const Endpoint& endpoint) { return m_proxies[endpoint.proxy].object == nullptr; }),
+		m_endpoints.end());
+	m_freeProxies.insert(m_freeProxies.end(), m_removedProxies.begin(), m_removedProxies.end());
+	m_removedProxies.clear();
+}
+
+void SweepAndPrune::InsertionSortEndpoints()
+{
+	CompactEndpoints();
+	// the list is nearly sorted from last frame, so this is close to O(n)
+	for (size_t i = 1; i < m_endpoints.size(); i++)
+	{
+		Endpoint key = m_endpoints[i];
+		size_t j = i;
+		while (j > 0 && EndpointLess(key.value, key.isMin, m_endpoints[j - 1].value, m_endpoints[j - 1].isMin))
+		{
+			m_endpoints[j] = m_endpoints[j - 1];
+			j--;
+		}
+		m_endpoints[j] = key;
+	}
+	m_sorted = true;
+}
+
+size_t SweepAndPrune::LowerEndpoint(float value) const
+{
+	auto endpoint = std::lower_bound(m_endpoints.begin(), m_endpoints.end(), value, [](const Endpoint& endpoint, float value)
+		{
+			return endpoint.value < value;
+		});
+	return (size_t)(endpoint - m_endpoints.begin());
+}
+
+const std::vector<BroadphasePair>& SweepAndPrune::ComputePairs()
+{
+	if (!m_sorted)
+	{
+		InsertionSortEndpoints();
+	}
+	m_active.clear();
+	m_pairIds.clear();
+
+	for (const Endpoint& endpoint : m_endpoints)
+	{
+		if (endpoint.isMin)
+		{
+			const Proxy& proxy = m_proxies[endpoint.proxy];
+			for (uint32_t activeId : m_active)
+			{
+				const Proxy& other = m_proxies[activeId];
+				// static bodies never collide with each other
+				if (proxy.isStatic && other.isStatic)
+				{
+					continue;
+				}
+				if (proxy.bounds.Overlaps(other.bounds) && PhysicsObject::CanCollide(proxy.object, other.object))
+				{
+					m_pairIds.emplace_back(std::min(activeId, endpoint.proxy), std::max(activeId, endpoint.proxy));
+				}
+			}
+			m_proxies[endpoint.proxy].activeIndex = (uint32_t)m_active.size();
+			m_active.push_back(endpoint.proxy);
+		}
+		else
+		{
+			// the min endpoint always comes first, the proxy is active
+			uint32_t activeIndex = m_proxies[endpoint.proxy].activeIndex;
+			m_active[activeIndex] = m_active.back();
+			m_proxies[m_active[activeIndex]].activeIndex = activeIndex;
+			m_active.pop_back();
+		}
+	}
+
+	// proxy order is insertion order, it keeps the response order independent of the sort axis
+	std::sort(m_pairIds.begin(), m_pairIds.end());
+
+	m_pairs.clear();
+	m_pairs.reserve(m_pairIds.size());
+	for (const auto& pairId : m_pairIds)
+	{
+		m_pairs.push_back({ m_proxies[pairId.first].object, m_proxies[pairId.second].object });
+	}
+	return m_pairs;
+}
+
+void SweepAndPrune::QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results)
+{
+	if (!m_sorted)
+	{
+		InsertionSortEndpoints();
+	}
+
+	// only the proxies starting less than the widest one before the box can reach it
+	size_t begin = LowerEndpoint(bounds.min[m_sortAxis] - m_maxExtent);
+	for (size_t index = begin; index < m_endpoints.size() && m_endpoints[index].value <= bounds.max[m_sortAxis]; index++)
+	{
+		const Endpoint& endpoint = m_endpoints[index];
+		const Proxy& proxy = m_proxies[endpoint.proxy];
+		if (endpoint.isMin && proxy.bounds.Overlaps(bounds))
+		{
+			results.push_back(proxy.object);
+		}
+	}
+}
+
+bool SweepAndPrune::GetBounds(const PhysicsObject* object, AABB& bounds) const
+{
+	int proxyId = object->GetProxyId();
+	if (proxyId < 0 || proxyId >= (int)m_proxies.size() || m_proxies[proxyId].object != object)
+	{
+		return false;
+	}
+	bounds = m_proxies[proxyId].bounds;
+	return true;
+}
+
+void SweepAndPrune::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback)
+{
+	if (!m_sorted)
+	{
+		InsertionSortEndpoints();
+	}
+
+	// the endpoints under the segment along the sort axis, walked in ray order
+	// so the walk ends once the proxies start past the closest hit
+	const int axis = m_sortAxis;
+	auto reachAlongAxis = [&](float distance)
+		{
+			return direction[axis] != 0.0f ? origin[axis] + direction[axis] * distance : origin[axis];
+		};
+	float segmentEnd = reachAlongAxis(maxDistance);
+	size_t begin = LowerEndpoint(std::min(origin[axis], segmentEnd) - m_maxExtent);
+	size_t end = LowerEndpoint(std::nextafter(std::max(origin[axis], segmentEnd), std::numeric_limits<float>::max()));
+	bool forward = direction[axis] >= 0.0f;
+
+	glm::vec3 invDirection = 1.0f / direction;
+	for (size_t step = begin; step < end; step++)
+	{
+		const Endpoint& endpoint = m_endpoints[forward ? step : begin + end - 1 - step];
+		if (!endpoint.isMin)
+		{
+			continue;
+		}
+		float reach = reachAlongAxis(maxDistance);
+		if (forward ? endpoint.value > reach : endpoint.value + m_maxExtent < reach)
+		{
+			return;
+		}
+		const Proxy& proxy = m_proxies[endpoint.proxy];
+		float distance;
+		if (!proxy.bounds.RayIntersect(origin, invDirection, maxDistance, distance))
+		{
+			continue;
+		}
+		float value = callback(proxy.object, origin, direction, maxDistance);
+		if (value == 0.0f)
+		{
+			return;
+		}
+		maxDistance = std::min(maxDistance, value);
+	}
+}
+}
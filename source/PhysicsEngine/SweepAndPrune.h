@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+#include "Broadphase.h"
+
+namespace ntn
+{
+	// Incremental sweep and prune.
+	// Min/max endpoints of every proxy are kept sorted along one axis between frames,
+	// bodies move little from one step to the next so an insertion sort restores the
+	// order in close to linear time. Only pairs overlapping on all three axes are reported.
+	class SweepAndPrune : public Broadphase
+	{
+	public:
+		SweepAndPrune() = default;
+
+		void Insert(PhysicsObject* object) override;
+		void Remove(PhysicsObject* object) override;
+		void Clear() override;
+
+		// refresh bounds from the objects and restore the endpoint order
+		void Update(float timeStep) override;
+		// sweep the sorted endpoints, pairs are returned in a stable order
+		const std::vector<BroadphasePair>& ComputePairs() override;
+
+		void QueryAABB(const AABB& bounds, std::vector<PhysicsObject*>& results) override;
+		bool GetBounds(const PhysicsObject* object, AABB& bounds) const override;
+		void RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, const RayCastCallback& callback) override;
+
+		int GetSortAxis() const { return m_sortAxis; }
+		int numberOfProxies() const override { return (int)(m_proxies.size() - m_freeProxies.size() - m_removedProxies.size()); }
+		std::unique_ptr<Broadphase> Clone() const override { return std::make_unique<SweepAndPrune>(*this); }
+
+	private:
+		struct Proxy
+		{
+			PhysicsObject* object = nullptr;
+			AABB bounds;
+			bool isStatic = false;
+			// slot in m_active while the sweep is inside the proxy
+			uint32_t activeIndex = 0;
+		};
+
+		struct Endpoint
+		{
+			float value = 0.0f;
+			uint32_t proxy = 0;
+			bool isMin = true;
+		};
+
+		void SelectSortAxis();
+		void RefreshEndpointValues();
+		void InsertionSortEndpoints();
+		// drop the endpoints of the removed proxies and free their slots
+		void CompactEndpoints();
+		// first endpoint at or after value, the endpoints must be sorted
+		size_t LowerEndpoint(float value) const;
+
+		std::vector<Proxy> m_proxies;
+		std::vector<int> m_freeProxies;
+		// removed since the last sort, their endpoints are still in m_endpoints
+		std::vector<int> m_removedProxies;
+		std::vector<Endpoint> m_endpoints;
+
+		std::vector<uint32_t> m_active;
+		std::vector<BroadphasePair> m_pairs;
+		std::vector<std::pair<uint32_t, uint32_t>> m_pairIds;
+
+		int m_sortAxis = 0;
+		// widest proxy along the sort axis, a proxy overlapping [a, b] has its min endpoint in [a - m_maxExtent, b]
+		float m_maxExtent = 0.0f;
+		// endpoints appended since the last sort are out of place
+		bool m_sorted = true;
+	};
+}
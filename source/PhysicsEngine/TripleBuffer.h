@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+
+namespace ntn
+{
+	// One writer thread hands whole values to one reader thread without locks.
+	// The writer fills its own buffer and swaps it with the middle one, the reader swaps the middle one
+	// with its own only when something new was published, so neither side ever waits or sees a half written value.
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		// writer side, filled in place then published
+		T& WriteBuffer() { return m_buffers[m_write]; }
+		void Publish()
+		{
+			m_write = m_middle.exchange(m_write | NewBit, std::memory_order_acq_rel) & IndexMask;
+		}
+
+		// reader side, the newest published value, the same one until the writer publishes again
+		const T& Read()
+		{
+			if ((m_middle.load(std::memory_order_relaxed) & NewBit) != 0)
+			{
+				m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & IndexMask;
+			}
+			return m_buffers[m_read];
+		}
+
+	private:
+		static const int IndexMask = 3;
+		static const int NewBit = 4;
+
+		T m_buffers[3];
+		int m_write = 0;
+		int m_read = 1;
+		std::atomic<int> m_middle{ 2 };
+	};
+}
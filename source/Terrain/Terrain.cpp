@@ -5,18 +5,41 @@
 #include"../PhysicsEngine/RigidBody.h"
 #include"../Logger.h"
 #include"../Timer.h"
+#include"../PhysicsEngine/JobSystem.h"
+#include"../PhysicsEngine/Simd.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 
 namespace ntn
 {
 unsigned int nbrPatchesTess = 20;
 
-Terrain::Terrain(TerrainType typeTerrain,glm::vec3 scale):m_typeRealTerrain(typeTerrain), m_scale(scale)
-{ 
-	m_rigidbody = new RigidBody();
+// apply a scale+shift to the height data
+static const float yScale = 128.0f / 256.0f, yShift = 16.0f;
+// rows of samples a thread takes at once while building
+static const int RowBand = 32;
 
-	if (m_typeRealTerrain == TerrainType::Raw)
+Terrain::Terrain(TerrainType typeTerrain,glm::vec3 scale):Heightfield(scale), m_typeRealTerrain(typeTerrain)
+{ 
+	if (m_typeRealTerrain == TerrainType::Raw || m_typeRealTerrain == TerrainType::Lod || m_typeRealTerrain == TerrainType::Compact)
 	{
-		InitTerrain();
+		if (m_typeRealTerrain == TerrainType::Raw)
+		{
+			InitTerrain();
+		}
+		else if (m_typeRealTerrain == TerrainType::Lod)
+		{
+			InitTerrainLod();
+		}
+		else
+		{
+			InitTerrainCompact();
+		}
+		// samples sit where InitVerticesWithHeightMapFromFile put the vertices
+		m_origin = glm::vec2(-(int)m_width / 2.0f, -(int)m_depth / 2.0f);
+		UpdateHeightRange();
 	}
 	else
 	{
@@ -49,6 +72,80 @@ void Terrain::Render(Shader& shader)
 	}
 }
 
+void Terrain::Render(Shader& shader, const Camera& camera)
+{
+	if (m_typeRealTerrain == TerrainType::Lod)
+	{
+		if (m_lod)
+		{
+			m_lod->Render(shader, camera);
+		}
+		return;
+	}
+	if (m_typeRealTerrain != TerrainType::Raw && m_typeRealTerrain != TerrainType::Compact)
+	{
+		Render(shader);
+		return;
+	}
+	shader.activate();
+
+	Frustum frustum = camera.getFrustum();
+
+	m_drawCounts.clear();
+	m_drawOffsets.clear();
+	m_chunkOffsets.clear();
+	m_drawnChunks = 0;
+	m_drawnTriangles = 0;
+	unsigned int rangeEnd = 0;
+	for (const TerrainChunk& chunk : m_chunks)
+	{
+		if (!frustum.Intersects(chunk.bbox))
+		{
+			continue;
+		}
+		m_drawnChunks++;
+		m_drawnTriangles += chunk.indexCount / 3;
+		if (m_compact)
+		{
+			m_chunkOffsets.push_back(glm::vec2((float)chunk.x, (float)chunk.z));
+			continue;
+		}
+		// neighbours in the same row of chunks are neighbours in the index buffer too
+		if (!m_drawCounts.empty() && rangeEnd == chunk.firstIndex)
+		{
+			m_drawCounts.back() += chunk.indexCount;
+		}
+		else
+		{
+			m_drawCounts.push_back(chunk.indexCount);
+			m_drawOffsets.push_back((const void*)(chunk.firstIndex * sizeof(unsigned int)));
+		}
+		rangeEnd = chunk.firstIndex + chunk.indexCount;
+	}
+
+	if (m_compact)
+	{
+		m_compact->Render(shader, m_chunkOffsets);
+	}
+	else
+	{
+		m_terrain->renderRanges(shader, m_drawCounts, m_drawOffsets);
+	}
+}
+
+size_t Terrain::getGpuBytes() const
+{
+	if (m_compact)
+	{
+		return m_compact->getGpuBytes();
+	}
+	if (m_terrain)
+	{
+		return m_terrain->vertices.size() * sizeof(Vertex) + m_terrain->indices.size() * sizeof(unsigned int);
+	}
+	return 0;
+}
+
 
 void Terrain::InitTerrain()
 {
@@ -56,45 +153,39 @@ void Terrain::InitTerrain()
 	std::string heightMapFilePath = ResourceManager::getInstance().getResourcePath("terrain/heightmap_paris.png");
 	std::vector<Vertex> vertices = InitVerticesWithHeightMapFromFile(heightMapFilePath.c_str(), m_width, m_depth);
 
-	// Initialize indices for triangles 
-	unsigned int num_indices = (m_width - 1) * (m_depth - 1) * 6;
-	std::vector<unsigned int> indices(num_indices, 0);
-	int Index = 0;
+	// Initialize indices for triangles, chunk by chunk
+	std::vector<unsigned int> indices;
+	FillChunkIndices(indices);
 
-	for (unsigned int z = 0; z < m_depth - 1; z++)
-	{
-		for (unsigned int x = 0; x < m_width - 1; x++)
-		{
-			/*  0 ----- 1 ----- 2
-				| \     | \     |
-				|  \    |   \   |
-				|    \  |     \ |
-				3 ----- 4 ----- 5
-				| \     |  \    |
-				|   \   |   \   |
-				|     \ |     \ |
-				6 ----- 7 ----- 8 */
-
-			unsigned int IndexBottomLeft = z * m_width + x; //0
-			unsigned int IndexTopLeft = (z + 1) * m_width + x; //3
-			unsigned int IndexTopRight = (z + 1) * m_width + x + 1; //4
-			unsigned int IndexBottomRight = z * m_width + x + 1; //1
-
-			// Add top left triangle
-			indices[Index++] = IndexBottomLeft;
-			indices[Index++] = IndexTopLeft;
-			indices[Index++] = IndexTopRight;
-
-			// Add bottom right triangle
-			indices[Index++] = IndexBottomLeft;
-			indices[Index++] = IndexTopRight;
-			indices[Index++] = IndexBottomRight;
-		}
-	}
+	// the normals are in the vertices now
+	std::vector<glm::vec3>().swap(m_gridNormals);
+	m_cache.Close();
 
-	// Update Normals for vertices
-	CalculateNormals(vertices, indices);
+	std::vector<Texture> textures_terrain = LoadRawTerrainTextures();
+	m_terrain = std::make_unique<Mesh>(vertices, indices, textures_terrain);
+}
+void Terrain::InitTerrainLod()
+{
+	// no mesh of the whole terrain, the heights go to a texture the grids of the quadtree are displaced with
+	std::string heightMapFilePath = ResourceManager::getInstance().getResourcePath("terrain/heightmap_paris.png");
+	// the normals are taken from the heights on the GPU
+	LoadHeightMapFromFile(heightMapFilePath.c_str(), false);
+	glm::vec2 origin(-(int)m_width / 2.0f, -(int)m_depth / 2.0f);
+	m_lod = std::make_unique<TerrainLod>(m_heightMap, m_width, m_depth, origin, LoadRawTerrainTextures());
+}
+
+void Terrain::InitTerrainCompact()
+{
+	// only the heights and the chunk bounds, the vertices are rebuilt by the vertex shader
+	std::string heightMapFilePath = ResourceManager::getInstance().getResourcePath("terrain/heightmap_paris.png");
+	// the normals are taken from the heights on the GPU
+	LoadHeightMapFromFile(heightMapFilePath.c_str(), false);
+	glm::vec2 origin(-(int)m_width / 2.0f, -(int)m_depth / 2.0f);
+	m_compact = std::make_unique<TerrainCompact>(m_heightMap, m_width, m_depth, origin, ChunkSize, LoadRawTerrainTextures());
+}
 
+std::vector<Texture> Terrain::LoadRawTerrainTextures()
+{
 	// textures
 	std::vector<Texture> textures_terrain;
 	
@@ -107,9 +198,113 @@ void Terrain::InitTerrain()
 	textures_terrain.push_back(grass);
 	textures_terrain.push_back(rdiffuse);
 	textures_terrain.push_back(snow);
-	
-	m_terrain = std::make_unique<Mesh>(vertices, indices, textures_terrain);
+	return textures_terrain;
+}
+
+void Terrain::LayoutChunks()
+{
+	// the index range of every chunk is known up front, the chunks are then filled in parallel
+	m_chunks.clear();
+	if (m_width < 2 || m_depth < 2)
+	{
+		return;
+	}
+	unsigned int indexCount = 0;
+	for (unsigned int chunkZ = 0; chunkZ < m_depth - 1; chunkZ += ChunkSize)
+	{
+		for (unsigned int chunkX = 0; chunkX < m_width - 1; chunkX += ChunkSize)
+		{
+			unsigned int endX = std::min(chunkX + ChunkSize, m_width - 1);
+			unsigned int endZ = std::min(chunkZ + ChunkSize, m_depth - 1);
+			TerrainChunk chunk;
+			chunk.x = chunkX;
+			chunk.z = chunkZ;
+			chunk.firstIndex = indexCount;
+			chunk.indexCount = (endX - chunkX) * (endZ - chunkZ) * 6;
+			indexCount += chunk.indexCount;
+			m_chunks.push_back(chunk);
+		}
+	}
+}
+
+void Terrain::ComputeChunkBounds()
+{
+	JobSystem::getInstance().ParallelFor((int)m_chunks.size(), 1, [&](int begin, int end, int threadIndex)
+	{
+		for (int chunkIndex = begin; chunkIndex < end; chunkIndex++)
+		{
+			TerrainChunk& chunk = m_chunks[chunkIndex];
+			unsigned int endX = std::min(chunk.x + ChunkSize, m_width - 1);
+			unsigned int endZ = std::min(chunk.z + ChunkSize, m_depth - 1);
+
+			// the samples on the far edges belong to the quads of this chunk too
+			float minHeight = m_heightMap[chunk.z * m_width + chunk.x];
+			float maxHeight = minHeight;
+			for (unsigned int z = chunk.z; z <= endZ; z++)
+			{
+				for (unsigned int x = chunk.x; x <= endX; x++)
+				{
+					float height = m_heightMap[z * m_width + x];
+					minHeight = std::min(minHeight, height);
+					maxHeight = std::max(maxHeight, height);
+				}
+			}
+
+			// where InitVerticesWithHeightMapFromFile put the vertices
+			glm::vec3 minBound(-(int)m_width / 2.0f + chunk.x, minHeight, -(int)m_depth / 2.0f + chunk.z);
+			glm::vec3 maxBound(-(int)m_width / 2.0f + endX, maxHeight, -(int)m_depth / 2.0f + endZ);
+			chunk.bbox.setMinBound(minBound);
+			chunk.bbox.setMaxBound(maxBound);
+		}
+	});
 }
+
+void Terrain::FillChunkIndices(std::vector<unsigned int>& indices)
+{
+	indices.resize(m_chunks.empty() ? 0 : m_chunks.back().firstIndex + m_chunks.back().indexCount);
+	JobSystem::getInstance().ParallelFor((int)m_chunks.size(), 1, [&](int begin, int end, int threadIndex)
+	{
+		for (int chunkIndex = begin; chunkIndex < end; chunkIndex++)
+		{
+			const TerrainChunk& chunk = m_chunks[chunkIndex];
+			unsigned int endX = std::min(chunk.x + ChunkSize, m_width - 1);
+			unsigned int endZ = std::min(chunk.z + ChunkSize, m_depth - 1);
+
+			unsigned int Index = chunk.firstIndex;
+			for (unsigned int z = chunk.z; z < endZ; z++)
+			{
+				for (unsigned int x = chunk.x; x < endX; x++)
+				{
+					/*  0 ----- 1 ----- 2
+						| \     | \     |
+						|  \    |   \   |
+						|    \  |     \ |
+						3 ----- 4 ----- 5
+						| \     |  \    |
+						|   \   |   \   |
+						|     \ |     \ |
+						6 ----- 7 ----- 8 */
+
+					unsigned int IndexBottomLeft = z * m_width + x; //0
+					unsigned int IndexTopLeft = (z + 1) * m_width + x; //3
+					unsigned int IndexTopRight = (z + 1) * m_width + x + 1; //4
+					unsigned int IndexBottomRight = z * m_width + x + 1; //1
+
+					// Add top left triangle
+					indices[Index++] = IndexBottomLeft;
+					indices[Index++] = IndexTopLeft;
+					indices[Index++] = IndexTopRight;
+
+					// Add bottom right triangle
+					indices[Index++] = IndexBottomLeft;
+					indices[Index++] = IndexTopRight;
+					indices[Index++] = IndexBottomRight;
+				}
+			}
+		}
+	});
+}
+
 void Terrain::InitTerrainTesselation()
 {
 	// Initialize vertices
@@ -179,55 +374,125 @@ Texture Terrain::LoadTerrainTextures(std::string name_texture,std::string pathFi
 	return texture_loaded;
 }
 
-std::vector<Vertex> Terrain::InitVerticesWithHeightMapFromFile(const char* imagePath, unsigned int&width, unsigned int& height)
+bool Terrain::LoadHeightMapFromFile(const char* imagePath, bool withNormals)
 {
-	// Initialize vertices
-	std::vector<Vertex> vertices;
-	int nChannels; 
-	unsigned char* data = stbi_load(imagePath, (int*)(&width), (int*)&height, &nChannels, 0);
+	Timer timer("LoadHeightMapFromFile");
+	std::ifstream file(imagePath, std::ios::binary | std::ios::ate);
+	std::vector<uint8_t> source(file ? (size_t)file.tellg() : 0);
+	if (!file || !file.seekg(0) || !file.read(reinterpret_cast<char*>(source.data()), (std::streamsize)source.size()))
+	{
+		Log::error("Can not read Height Texture image");
+		return false;
+	}
 
-	if (!data) 
+	// what was derived from the same file with the same parameters is mapped back as it is
+	uint64_t sourceHash = TerrainCache::Hash(source);
+	std::string cachePath = TerrainCache::PathFor(imagePath, withNormals);
+	m_gridNormals.clear();
+	// without normals the file of the raw terrain does as well, its normals are skipped
+	if (m_cache.Open(cachePath, sourceHash, yScale, yShift, ChunkSize, withNormals) ||
+		(!withNormals && m_cache.Open(TerrainCache::PathFor(imagePath, true), sourceHash, yScale, yShift, ChunkSize, false)))
+	{
+		m_width = m_cache.getWidth();
+		m_depth = m_cache.getDepth();
+		// the heightfield answers the collision and height queries from its own copy
+		m_heightMap.assign(m_cache.heights(), m_cache.heights() + (size_t)m_width * m_depth);
+		LayoutChunks();
+		if (m_chunks.size() == m_cache.numberOfChunks())
+		{
+			for (size_t i = 0; i < m_chunks.size(); i++)
+			{
+				glm::vec3 minBound = m_cache.chunkBounds()[2 * i];
+				glm::vec3 maxBound = m_cache.chunkBounds()[2 * i + 1];
+				m_chunks[i].bbox.setMinBound(minBound);
+				m_chunks[i].bbox.setMaxBound(maxBound);
+			}
+			// the normals stay in the mapping until the vertices took them
+			if (!withNormals)
+			{
+				m_cache.Close();
+			}
+			return true;
+		}
+	}
+	// closed so it can be written again
+	m_cache.Close();
+
+	int width, height, nChannels;
+	unsigned char* data = stbi_load_from_memory(source.data(), (int)source.size(), &width, &height, &nChannels, 0);
+	if (!data)
 	{
 		Log::error("Can not read Height Texture image");
+		return false;
+	}
+
+	// the same heights InitVerticesWithHeightMapFromFile gives the vertices, from the first channel
+	m_width = width;
+	m_depth = height;
+	m_heightMap.resize((size_t)width * height);
+	JobSystem::getInstance().ParallelFor(height, RowBand, [&](int begin, int end, int threadIndex)
+	{
+		for (size_t i = (size_t)begin * width; i < (size_t)end * width; i++)
+		{
+			m_heightMap[i] = (int)data[i * nChannels] * yScale - yShift;
+		}
+	});
+	stbi_image_free(data);
+
+	if (withNormals)
+	{
+		CalculateGridNormals(m_heightMap, m_width, m_depth, m_gridNormals);
+	}
+	LayoutChunks();
+	ComputeChunkBounds();
+
+	std::vector<glm::vec3> chunkBounds;
+	chunkBounds.reserve(m_chunks.size() * 2);
+	for (const TerrainChunk& chunk : m_chunks)
+	{
+		chunkBounds.push_back(chunk.bbox.GetMinBounds());
+		chunkBounds.push_back(chunk.bbox.GetMaxBounds());
+	}
+	if (!TerrainCache::Write(cachePath, sourceHash, yScale, yShift, ChunkSize, m_width, m_depth, m_heightMap, m_gridNormals, chunkBounds))
+	{
+		Log::warning("Can not write terrain cache " + cachePath);
+	}
+	return true;
+}
+
+std::vector<Vertex> Terrain::InitVerticesWithHeightMapFromFile(const char* imagePath, unsigned int&width, unsigned int& height)
+{
+	Timer timer("InitVerticesWithHeightMapFromFile");
+	if (!LoadHeightMapFromFile(imagePath, true))
+	{
 		return {};
 	}
-	
-	static float yScale = 128.0f / 256.0f, yShift = 16.0f;  // apply a scale+shift to the height data
-	
-	if (nChannels == 1 || nChannels == 3 || nChannels == 4) //RGB || RGBA
+	width = m_width;
+	height = m_depth;
+
+	// Initialize vertices, every one written by the band of its row
+	const glm::vec3* normals = GridNormals();
+	std::vector<Vertex> vertices(m_heightMap.size());
+	JobSystem::getInstance().ParallelFor(height, RowBand, [&](int begin, int end, int threadIndex)
 	{
-		for (unsigned int i = 0; i < height; ++i)
+		for (unsigned int i = begin; i < (unsigned int)end; ++i)
 		{
-			std::vector<float> height_width;
 			for (unsigned int j = 0; j < width; ++j)
 			{
-				// retrieve texel for (i,j) tex coord
-				unsigned char* texel = data + (j + width * i) * nChannels;
-				// raw height at coordinate
-				unsigned char h = texel[0];
-
+				size_t index = (size_t)i * width + j;
 				float x = -(int)width / 2.0f + j;
 				float z = -(int)height / 2.0f + i;
-				float y = (int)h * yScale - yShift;
-				//	float y = 1.0f;
-				Vertex vertex;
-				vertex.Position = glm::vec3(x, y, z);
-				//    vertex.Position = glm::vec3(x, 1.0f, z);
-				
-				//Normals will be computed later
-		
+				Vertex& vertex = vertices[index];
+				vertex.Position = glm::vec3(x, m_heightMap[index], z);
+				vertex.Normal = normals[index];
+
 				// Add texture coordinates
 				float u = (float)j / (width - 1);
-				float v = 1.0 - (float)i / (height - 1);
-				vertex.TexCoords = glm::vec2(u,v);
-
-				vertices.push_back(vertex);
-
-				m_heightMap.push_back(y);
+				float v = 1.0f - (float)i / (height - 1);
+				vertex.TexCoords = glm::vec2(u, v);
 			}
 		}
-	}
-	stbi_image_free(data);
+	});
 	return vertices;
 }
 std::vector<Vertex> Terrain::InitVerticesTessWithHeightMapTexture(const char* heightMapFilePath, 
@@ -299,31 +564,109 @@ std::vector<Vertex> Terrain::InitVerticesTessWithHeightMapTexture(const char* he
 	return vertices;
 }
 
-void Terrain::CalculateNormals(std::vector<Vertex>& Vertices, std::vector<unsigned int>& Indices)
+// normals of one row of samples, from the height differences to the neighbours: (-dh/dx, 1, -dh/dz) normalized.
+// Central differences inside the grid, one-sided ones on its borders, so it needs at least 2x2 samples.
+static void GridNormalsRow(const float* heights, int width, int depth, int z, float* normalX, float* normalY, float* normalZ)
 {
-	unsigned int Index = 0;
+	const float* row = heights + (size_t)z * width;
+	const float* rowDown = heights + (size_t)std::max(z - 1, 0) * width;
+	const float* rowUp = heights + (size_t)std::min(z + 1, depth - 1) * width;
+	float invDz = 1.0f / (float)(std::min(z + 1, depth - 1) - std::max(z - 1, 0));
 
-	// Accumulate each triangle normal into each of the triangle vertices
-	for (unsigned int i = 0; i < Indices.size(); i += 3) {
-		unsigned int Index0 = Indices[i];
-		unsigned int Index1 = Indices[i + 1];
-		unsigned int Index2 = Indices[i + 2];
-		glm::vec3 v1 = Vertices[Index1].Position - Vertices[Index0].Position;
-		glm::vec3 v2 = Vertices[Index2].Position - Vertices[Index0].Position;
-		glm::vec3 Normal = glm::cross( v1,v2);
-		Normal = glm::normalize(Normal);
+	// the first and last columns have a single neighbour along x
+	auto border = [&](int x)
+	{
+		int left = std::max(x - 1, 0), right = std::min(x + 1, width - 1);
+		glm::vec3 normal = glm::normalize(glm::vec3((row[left] - row[right]) / (float)(right - left), 1.0f, (rowDown[x] - rowUp[x]) * invDz));
+		normalX[x] = normal.x;
+		normalY[x] = normal.y;
+		normalZ[x] = normal.z;
+	};
+	border(0);
+	border(width - 1);
+
+	int x = 1;
+#if defined(PHYSICS_SIMD_AVX)
+	const __m256 half8 = _mm256_set1_ps(0.5f);
+	const __m256 one8 = _mm256_set1_ps(1.0f);
+	const __m256 invDz8 = _mm256_set1_ps(invDz);
+	for (; x + 8 <= width - 1; x += 8)
+	{
+		__m256 dx = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(row + x - 1), _mm256_loadu_ps(row + x + 1)), half8);
+		__m256 dz = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(rowDown + x), _mm256_loadu_ps(rowUp + x)), invDz8);
+		__m256 invLength = _mm256_div_ps(one8, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz)), one8)));
+		_mm256_storeu_ps(normalX + x, _mm256_mul_ps(dx, invLength));
+		_mm256_storeu_ps(normalY + x, invLength);
+		_mm256_storeu_ps(normalZ + x, _mm256_mul_ps(dz, invLength));
+	}
+#endif
+#if defined(PHYSICS_SIMD_SSE)
+	const __m128 half4 = _mm_set1_ps(0.5f);
+	const __m128 one4 = _mm_set1_ps(1.0f);
+	const __m128 invDz4 = _mm_set1_ps(invDz);
+	for (; x + 4 <= width - 1; x += 4)
+	{
+		__m128 dx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row + x - 1), _mm_loadu_ps(row + x + 1)), half4);
+		__m128 dz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(rowDown + x), _mm_loadu_ps(rowUp + x)), invDz4);
+		__m128 invLength = _mm_div_ps(one4, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)), one4)));
+		_mm_storeu_ps(normalX + x, _mm_mul_ps(dx, invLength));
+		_mm_storeu_ps(normalY + x, invLength);
+		_mm_storeu_ps(normalZ + x, _mm_mul_ps(dz, invLength));
+	}
+#endif
+	// remaining columns
+	for (; x < width - 1; x++)
+	{
+		float dx = (row[x - 1] - row[x + 1]) * 0.5f;
+		float dz = (rowDown[x] - rowUp[x]) * invDz;
+		float invLength = 1.0f / std::sqrt(dx * dx + dz * dz + 1.0f);
+		normalX[x] = dx * invLength;
+		normalY[x] = invLength;
+		normalZ[x] = dz * invLength;
+	}
+}
 
-		Vertices[Index0].Normal += Normal;
-		Vertices[Index1].Normal += Normal;
-		Vertices[Index2].Normal += Normal;
+void Terrain::CalculateGridNormals(const std::vector<float>& heights, unsigned int width, unsigned int depth, std::vector<glm::vec3>& normals)
+{
+	normals.resize((size_t)width * depth);
+	// a single row or column has no slope along one axis, it stays flat
+	if (width < 2 || depth < 2 || heights.size() < normals.size())
+	{
+		std::fill(normals.begin(), normals.end(), glm::vec3(0.0f, 1.0f, 0.0f));
+		return;
 	}
 
-	// Normalize all the vertex normals
-	for (unsigned int i = 0; i < Vertices.size(); i++) 
+	// one scratch row per thread, the kernel writes each coordinate apart
+	JobSystem& jobSystem = JobSystem::getInstance();
+	std::vector<std::vector<float>> scratch(jobSystem.maxThreads(), std::vector<float>());
+	jobSystem.ParallelFor(depth, RowBand, [&](int begin, int end, int threadIndex)
+	{
+		std::vector<float>& row = scratch[threadIndex];
+		row.resize((size_t)width * 3);
+		float* normalX = row.data();
+		float* normalY = normalX + width;
+		float* normalZ = normalY + width;
+		for (int z = begin; z < end; z++)
+		{
+			GridNormalsRow(heights.data(), width, depth, z, normalX, normalY, normalZ);
+			glm::vec3* out = normals.data() + (size_t)z * width;
+			for (unsigned int x = 0; x < width; x++)
+			{
+				out[x] = glm::vec3(normalX[x], normalY[x], normalZ[x]);
+			}
+		}
+	});
+}
+
+const glm::vec3* Terrain::GridNormals() const
+{
+	if (m_cache.isOpen())
 	{
-		Vertices[i].Normal = glm::normalize(Vertices[i].Normal);
+		return m_cache.normals();
 	}
+	return m_gridNormals.empty() ? nullptr : m_gridNormals.data();
 }
+
 void Terrain::SetPosition(const glm::vec3& newPosition)
 {
 	glm::vec3 pos = GetPosition();
@@ -336,6 +679,7 @@ void Terrain::ComputeBoundingBox()
 {
 	if (!m_terrain)
 	{
+		ComputeGridBoundingBox();
 		return;
 	}
 	m_bbox.Reset();
@@ -363,6 +707,19 @@ void Terrain::ComputeBoundingBox()
 	m_bbox.setMaxBound(maxBound_temp);
 }
 
+void Terrain::ComputeGridBoundingBox()
+{
+	if (!HasGrid())
+	{
+		return;
+	}
+	glm::vec3 pos = GetPosition();
+	glm::vec3 minBound_temp = (glm::vec3(m_origin.x, m_minHeight, m_origin.y) + pos) * m_scale;
+	glm::vec3 maxBound_temp = (glm::vec3(m_origin.x + m_width - 1, m_maxHeight, m_origin.y + m_depth - 1) + pos) * m_scale;
+	m_bbox.setMinBound(minBound_temp);
+	m_bbox.setMaxBound(maxBound_temp);
+}
+
 void Terrain::UpdateBoundingBox(glm::vec3 deltaPos)
 {
 	m_bbox.Move(deltaPos);
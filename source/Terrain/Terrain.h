@@ -1,8 +1,12 @@
 #pragma once
 
-#include"../PhysicsEngine/PhysicsObject.h"
+#include"../PhysicsEngine/Heightfield.h"
 #include"../model.h"
 #include "../boundingBox.h"
+#include "../camera.h"
+#include "TerrainLod.h"
+#include "TerrainCompact.h"
+#include "TerrainCache.h"
 
 namespace ntn
 {
@@ -11,11 +15,23 @@ namespace ntn
 	enum class TerrainType
 	{
 		Raw = 0,
-		Tess = 1
+		Tess = 1,
+		Lod = 2,
+		Compact = 3
 	};
 
 
-	class Terrain :public PhysicsObject
+	// a square of the raw terrain drawn or skipped as a whole, its indices are contiguous in the shared index buffer
+	struct TerrainChunk
+	{
+		BoundingBox bbox;
+		unsigned int x = 0, z = 0;	// first sample
+		unsigned int firstIndex = 0;
+		unsigned int indexCount = 0;
+	};
+
+	// the height samples of the raw terrain double as its collision shape
+	class Terrain :public Heightfield
 	{
 	public:
 		Terrain(TerrainType typeTerrain = TerrainType::Raw, glm::vec3 scale = glm::vec3(1.0f));
@@ -24,14 +40,23 @@ namespace ntn
 
 		virtual void UpdatePhysics(glm::vec3 gravity, float timeStep);
 
-		inline void SetScale(const glm::vec3& newScale) { m_scale = newScale; }
-		inline glm::vec3 GetScale() const { return m_scale; }
-
 		void Render(Shader& shader);
+		// the raw terrain only draws the chunks inside the frustum of the camera, the lod terrain picks its nodes for it
+		void Render(Shader& shader, const Camera& camera);
 		void RenderTesselation(Shader& shader);
 
 		void InitTerrain();
 		std::vector<Vertex> InitVerticesWithHeightMapFromFile(const char* imagePath, unsigned int& width, unsigned int& height);
+		// heights and the chunks with their bounds, from the .terrain cache next to the image when it matches.
+		// With normals they come from the mapped cache on a hit, see GridNormals
+		bool LoadHeightMapFromFile(const char* imagePath, bool withNormals);
+
+		// Continuous level of detail
+		void InitTerrainLod();
+		TerrainLod* getLod() { return m_lod.get(); }
+
+		// raw terrain drawn from a height texture, chunks culled as for the raw one
+		void InitTerrainCompact();
 
 		//Tesselation
 		void InitTerrainTesselation();
@@ -39,44 +64,69 @@ namespace ntn
 			unsigned int& width, unsigned int& height);
 
 		Texture LoadTerrainTextures(std::string name_texture, std::string pathFile_texture);
+		std::vector<Texture> LoadRawTerrainTextures();
 
 		float GetHeightForPos(float x, float z);
 		float GetHeightInterpolated(float x, float z);
 
 		glm::vec3 ConstrainCameraPosToTerrain(glm::vec3 camPos);
 
-		void CalculateNormals(std::vector<Vertex>& Vertices, std::vector<unsigned int>& Indices);
+		// normal of every sample from the height differences to its neighbours, the grid is walked in parallel bands of rows
+		static void CalculateGridNormals(const std::vector<float>& heights, unsigned int width, unsigned int depth, std::vector<glm::vec3>& normals);
 
 		void SetPosition(const glm::vec3& newPosition);
 
 
 		void ComputeBoundingBox();
+		void ComputeGridBoundingBox();
 		void UpdateBoundingBox(glm::vec3 deltaPos);
 
 		const BoundingBox& GetBoundingBox() const { return m_bbox; };
 
-		inline unsigned int getWidth() { return m_width; }
-		inline unsigned int getDepth() { return m_depth; }
-
 		void storeTerrainHeightData(std::vector<float>& heightData)
 		{
 			m_heightMap = std::move(heightData);
+			UpdateHeightRange();
 		};
 
 		inline const std::vector<float>& getHeightMap() { return m_heightMap; }
 
+		// quads along a side of a chunk
+		static const unsigned int ChunkSize = 64;
+		const std::vector<TerrainChunk>& getChunks() const { return m_chunks; }
+		// of the last culled render
+		int getNumberOfDrawnChunks() const { return m_drawnChunks; }
+		int getNumberOfDrawnTriangles() const { return m_drawnTriangles; }
+		// vertex, index and height data of the raw terrain on the GPU
+		size_t getGpuBytes() const;
+
 		TerrainType m_typeRealTerrain = TerrainType::Raw;
 
 	private:
 
-		glm::vec3 m_scale = glm::vec3(1.0f);
+		// chunk ranges from the size of the grid, their bounds from the heights
+		void LayoutChunks();
+		void ComputeChunkBounds();
+		void FillChunkIndices(std::vector<unsigned int>& indices);
+
+		// loaded with LoadHeightMapFromFile, null when they were not asked for
+		const glm::vec3* GridNormals() const;
 
-		unsigned int m_width = 0; //x-axis
-		unsigned int m_depth = 0; //z-axis
 		std::unique_ptr<Mesh> m_terrain = nullptr;
+		std::unique_ptr<TerrainLod> m_lod = nullptr;
+		std::unique_ptr<TerrainCompact> m_compact = nullptr;
+
+		std::vector<TerrainChunk> m_chunks;
+		// normals of the samples until the raw terrain puts them in its vertices:
+		// computed here on a cache miss, read from the still mapped cache on a hit
+		std::vector<glm::vec3> m_gridNormals;
+		TerrainCache m_cache;
+		std::vector<GLsizei> m_drawCounts;
+		std::vector<const void*> m_drawOffsets;
+		std::vector<glm::vec2> m_chunkOffsets;
+		int m_drawnChunks = 0;
+		int m_drawnTriangles = 0;
 
 		BoundingBox m_bbox;
-
-		std::vector<float> m_heightMap;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "TerrainCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ntn
+{
+
+static const char Magic[8] = { 'N', 'T', 'N', 'T', 'E', 'R', 'R', 0 };
+
+/*********************************************************************************************************
+* Mapped file
+**********************************************************************************************************/
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	m_file = file;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != nullptr)
+	{
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = nullptr;
+}
+#else
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+	m_file = open(path.c_str(), O_RDONLY);
+	if (m_file < 0)
+	{
+		return false;
+	}
+	struct stat status;
+	if (fstat(m_file, &status) != 0 || status.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	void* data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	m_data = static_cast<const uint8_t*>(data);
+	m_size = (size_t)status.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(m_data), m_size);
+	}
+	if (m_file >= 0)
+	{
+		close(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_file = -1;
+}
+#endif
+
+/*********************************************************************************************************
+* Terrain cache
+**********************************************************************************************************/
+std::string TerrainCache::PathFor(const std::string& sourcePath, bool withNormals)
+{
+	const char* suffix = withNormals ? ".terrain" : ".heights.terrain";
+	size_t separator = sourcePath.find_last_of("/\\");
+	size_t extension = sourcePath.find_last_of('.');
+	if (extension == std::string::npos || (separator != std::string::npos && extension < separator))
+	{
+		return sourcePath + suffix;
+	}
+	return sourcePath.substr(0, extension) + suffix;
+}
+
+uint64_t TerrainCache::Hash(const std::vector<uint8_t>& bytes)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (uint8_t byte : bytes)
+	{
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool TerrainCache::Open(const std::string& path, uint64_t sourceHash, float yScale, float yShift, unsigned int chunkSize, bool needNormals)
+{
+	Close();
+	if (!m_file.Open(path) || m_file.size() < sizeof(Header))
+	{
+		m_file.Close();
+		return false;
+	}
+
+	Header header;
+	std::memcpy(&header, m_file.data(), sizeof(Header));
+	if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version || header.sourceHash != sourceHash ||
+		header.yScale != yScale || header.yShift != yShift || header.chunkSize != chunkSize || (needNormals && header.hasNormals == 0))
+	{
+		m_file.Close();
+		return false;
+	}
+
+	size_t samples = (size_t)header.width * header.depth;
+	size_t normalBytes = header.hasNormals != 0 ? samples * sizeof(glm::vec3) : 0;
+	size_t expected = sizeof(Header) + samples * sizeof(float) + normalBytes + (size_t)header.chunkCount * 2 * sizeof(glm::vec3);
+	if (m_file.size() != expected)
+	{
+		m_file.Close();
+		return false;
+	}
+
+	// every block is a whole number of floats after the header, the mapping is page aligned
+	const uint8_t* data = m_file.data() + sizeof(Header);
+	m_width = header.width;
+	m_depth = header.depth;
+	m_chunkCount = header.chunkCount;
+	m_heights = reinterpret_cast<const float*>(data);
+	m_normals = normalBytes > 0 ? reinterpret_cast<const glm::vec3*>(data + samples * sizeof(float)) : nullptr;
+	m_chunkBounds = reinterpret_cast<const glm::vec3*>(data + samples * sizeof(float) + normalBytes);
+	return true;
+}
+
+void TerrainCache::Close()
+{
+	m_file.Close();
+	m_width = 0;
+	m_depth = 0;
+	m_chunkCount = 0;
+	m_heights = nullptr;
+	m_normals = nullptr;
+	m_chunkBounds = nullptr;
+}
+
+bool TerrainCache::Write(const std::string& path, uint64_t sourceHash, float yScale, float yShift, unsigned int chunkSize,
+						 unsigned int width, unsigned int depth, const std::vector<float>& heights, const std::vector<glm::vec3>& normals,
+						 const std::vector<glm::vec3>& chunkBounds)
+{
+	size_t samples = (size_t)width * depth;
+	if (heights.size() != samples || (!normals.empty() && normals.size() != samples) || chunkBounds.size() % 2 != 0)
+	{
+		return false;
+	}
+
+	Header header = {};
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.chunkSize = chunkSize;
+	header.sourceHash = sourceHash;
+	header.yScale = yScale;
+	header.yShift = yShift;
+	header.width = width;
+	header.depth = depth;
+	header.chunkCount = (uint32_t)(chunkBounds.size() / 2);
+	header.hasNormals = normals.empty() ? 0 : 1;
+
+	// written under another name first, a crash never leaves a truncated cache behind
+	std::string partialPath = path + ".partial";
+	{
+		std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		file.write(reinterpret_cast<const char*>(heights.data()), (std::streamsize)(samples * sizeof(float)));
+		file.write(reinterpret_cast<const char*>(normals.data()), (std::streamsize)(normals.size() * sizeof(glm::vec3)));
+		file.write(reinterpret_cast<const char*>(chunkBounds.data()), (std::streamsize)(chunkBounds.size() * sizeof(glm::vec3)));
+		if (!file)
+		{
+			return false;
+		}
+	}
+	std::remove(path.c_str());
+	return std::rename(partialPath.c_str(), path.c_str()) == 0;
+}
+
+}
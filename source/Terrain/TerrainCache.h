@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ntn
+{
+	// A whole file mapped read only into memory, unmapped when destroyed.
+	class MappedFile
+	{
+	public:
+		MappedFile() {}
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+	private:
+		const uint8_t* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+	};
+
+	// Everything the terrain derives from its heightmap image, stored next to it as a .terrain file:
+	// the heights, their normals and the bounds of every chunk, for one source file and one set of build parameters.
+	// The normals are only stored by the terrains that read them, in a file of their own so switching terrain modes
+	// never overwrites the other one. The file is mapped, a hit costs the reads and no decoding.
+	class TerrainCache
+	{
+	public:
+		static const uint32_t Version = 2;
+
+		// the cache of "dir/name.png" is "dir/name.terrain", "dir/name.heights.terrain" without the normals
+		static std::string PathFor(const std::string& sourcePath, bool withNormals);
+		// FNV-1a of the source file content
+		static uint64_t Hash(const std::vector<uint8_t>& bytes);
+
+		// false when the file is missing, truncated, built from another source or with other parameters,
+		// or without normals when they are needed
+		bool Open(const std::string& path, uint64_t sourceHash, float yScale, float yShift, unsigned int chunkSize, bool needNormals);
+		void Close();
+		bool isOpen() const { return m_heights != nullptr; }
+
+		// normals may be empty, the file is then written without them
+		static bool Write(const std::string& path, uint64_t sourceHash, float yScale, float yShift, unsigned int chunkSize,
+						  unsigned int width, unsigned int depth, const std::vector<float>& heights, const std::vector<glm::vec3>& normals,
+						  const std::vector<glm::vec3>& chunkBounds);
+
+		unsigned int getWidth() const { return m_width; }
+		unsigned int getDepth() const { return m_depth; }
+		unsigned int numberOfChunks() const { return m_chunkCount; }
+
+		// point into the mapped file, valid while the cache is open
+		const float* heights() const { return m_heights; }
+		// null when the file has no normals
+		const glm::vec3* normals() const { return m_normals; }
+		// min and max of every chunk, one after the other
+		const glm::vec3* chunkBounds() const { return m_chunkBounds; }
+
+	private:
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t chunkSize;
+			uint64_t sourceHash;
+			float yScale;
+			float yShift;
+			uint32_t width;
+			uint32_t depth;
+			uint32_t chunkCount;
+			uint32_t hasNormals;
+		};
+
+		MappedFile m_file;
+		unsigned int m_width = 0;
+		unsigned int m_depth = 0;
+		unsigned int m_chunkCount = 0;
+		const float* m_heights = nullptr;
+		const glm::vec3* m_normals = nullptr;
+		const glm::vec3* m_chunkBounds = nullptr;
+	};
+}
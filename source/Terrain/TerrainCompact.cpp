@@ -0,0 +1,135 @@
+#include "TerrainCompact.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ntn
+{
+
+TerrainCompact::TerrainCompact(const std::vector<float>& heights, unsigned int width, unsigned int depth, glm::vec2 origin,
+							   unsigned int chunkSize, const std::vector<Texture>& textures)
+	: m_width(width), m_depth(depth), m_origin(origin), m_chunkSize(chunkSize), m_textures(textures)
+{
+	if (m_width < 2 || m_depth < 2 || m_chunkSize == 0 || heights.size() < (size_t)m_width * m_depth)
+	{
+		return;
+	}
+	InitIndexGrid();
+	InitHeightTexture(heights);
+}
+
+TerrainCompact::~TerrainCompact()
+{
+	glDeleteTextures(1, &m_heightTexture);
+	glDeleteBuffers(1, &m_instanceVBO);
+	glDeleteBuffers(1, &m_EBO);
+	glDeleteVertexArrays(1, &m_VAO);
+}
+
+void TerrainCompact::Render(Shader& shader, const std::vector<glm::vec2>& chunkOffsets)
+{
+	if (chunkOffsets.empty() || m_VAO == 0)
+	{
+		return;
+	}
+
+	shader.activate();
+	shader.setVec2("gOrigin", m_origin);
+	shader.setVec2("gHeightRange", glm::vec2(m_minHeight, m_heightRange));
+	shader.setInt("gChunkSize", (int)m_chunkSize);
+	glUniform2i(glGetUniformLocation(shader.ID, "gSize"), (int)m_width, (int)m_depth);
+
+	for (unsigned int i = 0; i < m_textures.size(); i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glUniform1i(glGetUniformLocation(shader.ID, m_textures[i].type.c_str()), i);
+		glBindTexture(GL_TEXTURE_2D, m_textures[i].id);
+	}
+	unsigned int heightUnit = (unsigned int)m_textures.size();
+	glActiveTexture(GL_TEXTURE0 + heightUnit);
+	glUniform1i(glGetUniformLocation(shader.ID, "gHeightMap"), heightUnit);
+	glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, chunkOffsets.size() * sizeof(glm::vec2), chunkOffsets.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_instanceCapacity = std::max(m_instanceCapacity, chunkOffsets.size());
+
+	glBindVertexArray(m_VAO);
+	glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0, (GLsizei)chunkOffsets.size());
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+size_t TerrainCompact::getGpuBytes() const
+{
+	return (size_t)m_width * m_depth * sizeof(uint16_t) + m_indexCount * sizeof(unsigned int) + m_instanceCapacity * sizeof(glm::vec2);
+}
+
+void TerrainCompact::InitIndexGrid()
+{
+	// indices of the (chunkSize + 1)^2 samples of a chunk, the same triangles as the raw terrain
+	unsigned int rowLength = m_chunkSize + 1;
+	std::vector<unsigned int> indices;
+	indices.reserve((size_t)m_chunkSize * m_chunkSize * 6);
+	for (unsigned int z = 0; z < m_chunkSize; z++)
+	{
+		for (unsigned int x = 0; x < m_chunkSize; x++)
+		{
+			unsigned int bottomLeft = z * rowLength + x;
+			unsigned int topLeft = (z + 1) * rowLength + x;
+			indices.push_back(bottomLeft);
+			indices.push_back(topLeft);
+			indices.push_back(topLeft + 1);
+			indices.push_back(bottomLeft);
+			indices.push_back(topLeft + 1);
+			indices.push_back(bottomLeft + 1);
+		}
+	}
+	m_indexCount = (int)indices.size();
+
+	// no vertex attribute but the chunk offset, the rest comes from gl_VertexID
+	glGenVertexArrays(1, &m_VAO);
+	glBindVertexArray(m_VAO);
+
+	glGenBuffers(1, &m_EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+	glVertexAttribDivisor(0, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TerrainCompact::InitHeightTexture(const std::vector<float>& heights)
+{
+	auto range = std::minmax_element(heights.begin(), heights.begin() + (size_t)m_width * m_depth);
+	m_minHeight = *range.first;
+	m_heightRange = std::max(*range.second - *range.first, 1.0e-6f);
+
+	std::vector<uint16_t> normalized((size_t)m_width * m_depth);
+	float scale = 65535.0f / m_heightRange;
+	for (size_t i = 0; i < normalized.size(); i++)
+	{
+		normalized[i] = (uint16_t)((heights[i] - m_minHeight) * scale + 0.5f);
+	}
+
+	glGenTextures(1, &m_heightTexture);
+	glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, m_width, m_depth, 0, GL_RED, GL_UNSIGNED_SHORT, normalized.data());
+	// read with texelFetch, one texel per sample
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+}
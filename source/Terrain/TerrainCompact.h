@@ -0,0 +1,51 @@
+#pragma once
+
+#define NOMINMAX
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "../mesh.h"
+
+namespace ntn
+{
+	// The raw terrain without vertex buffer: the heights live in a 16 bit texture and every chunk is drawn as an instance
+	// of one shared index grid. The vertex shader finds its sample from gl_VertexID and the chunk offset,
+	// then rebuilds position, texture coordinates and normal from the texture.
+	class TerrainCompact
+	{
+	public:
+		// heights row by row (z major), sample (x, z) sits at (origin.x + x, height, origin.y + z)
+		TerrainCompact(const std::vector<float>& heights, unsigned int width, unsigned int depth, glm::vec2 origin,
+					   unsigned int chunkSize, const std::vector<Texture>& textures);
+		~TerrainCompact();
+
+		TerrainCompact(const TerrainCompact&) = delete;
+		TerrainCompact& operator=(const TerrainCompact&) = delete;
+
+		// first sample of every chunk to draw, in one instanced call
+		void Render(Shader& shader, const std::vector<glm::vec2>& chunkOffsets);
+
+		// height texture, index grid and the instance buffer at its largest
+		size_t getGpuBytes() const;
+
+	private:
+		void InitIndexGrid();
+		void InitHeightTexture(const std::vector<float>& heights);
+
+		unsigned int m_width = 0;
+		unsigned int m_depth = 0;
+		glm::vec2 m_origin = glm::vec2(0.0f);
+		unsigned int m_chunkSize = 0;
+		std::vector<Texture> m_textures;
+
+		// heights are stored normalized over this range
+		float m_minHeight = 0.0f;
+		float m_heightRange = 1.0f;
+
+		unsigned int m_heightTexture = 0;
+		unsigned int m_VAO = 0, m_EBO = 0, m_instanceVBO = 0;
+		int m_indexCount = 0;
+		size_t m_instanceCapacity = 0;
+	};
+}
@@ -0,0 +1,286 @@
+#include "TerrainLod.h"
+
+#include <algorithm>
+#include <string>
+
+namespace ntn
+{
+
+static bool SphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& minBounds, const glm::vec3& maxBounds)
+{
+	glm::vec3 closest = glm::clamp(center, minBounds, maxBounds);
+	glm::vec3 offset = closest - center;
+	return glm::dot(offset, offset) <= radius * radius;
+}
+
+TerrainLod::TerrainLod(const std::vector<float>& heights, unsigned int width, unsigned int depth, glm::vec2 origin,
+					   const std::vector<Texture>& textures)
+	: m_heights(heights), m_width(width), m_depth(depth), m_origin(origin), m_textures(textures)
+{
+	if (m_width < 2 || m_depth < 2 || m_heights.size() < (size_t)m_width * m_depth)
+	{
+		return;
+	}
+
+	// the fewest levels whose root covers the grid, more roots side by side when they run out
+	int leafSize = 2 * GridSize;
+	int cells = (int)std::max(m_width, m_depth) - 1;
+	m_levels = 1;
+	while (m_levels < MaxLevels && (leafSize << (m_levels - 1)) < cells)
+	{
+		m_levels++;
+	}
+	int rootSize = leafSize << (m_levels - 1);
+	for (int z = 0; z < (int)m_depth - 1; z += rootSize)
+	{
+		for (int x = 0; x < (int)m_width - 1; x += rootSize)
+		{
+			m_roots.push_back(BuildNode(x, z, rootSize, m_levels - 1));
+		}
+	}
+
+	InitGridMesh();
+	InitHeightTexture();
+}
+
+TerrainLod::~TerrainLod()
+{
+	glDeleteTextures(1, &m_heightTexture);
+	glDeleteBuffers(1, &m_instanceVBO);
+	glDeleteBuffers(1, &m_EBO);
+	glDeleteBuffers(1, &m_VBO);
+	glDeleteVertexArrays(1, &m_VAO);
+}
+
+int TerrainLod::BuildNode(int x, int z, int size, int level)
+{
+	int index = (int)m_nodes.size();
+	m_nodes.push_back(Node());
+	Node node;
+	node.x = x;
+	node.z = z;
+	node.size = size;
+	node.level = level;
+
+	int endX = std::min(x + size, (int)m_width - 1);
+	int endZ = std::min(z + size, (int)m_depth - 1);
+	float minHeight = m_heights[z * m_width + x];
+	float maxHeight = minHeight;
+	if (level == 0)
+	{
+		for (int sampleZ = z; sampleZ <= endZ; sampleZ++)
+		{
+			for (int sampleX = x; sampleX <= endX; sampleX++)
+			{
+				float height = m_heights[sampleZ * m_width + sampleX];
+				minHeight = std::min(minHeight, height);
+				maxHeight = std::max(maxHeight, height);
+			}
+		}
+	}
+	else
+	{
+		// children outside the grid are left out, the parent never draws their area
+		int half = size / 2;
+		for (int child = 0; child < 4; child++)
+		{
+			int childX = x + (child & 1) * half;
+			int childZ = z + (child >> 1) * half;
+			if (childX >= (int)m_width - 1 || childZ >= (int)m_depth - 1)
+			{
+				continue;
+			}
+			int childIndex = BuildNode(childX, childZ, half, level - 1);
+			node.children[child] = childIndex;
+			minHeight = std::min(minHeight, m_nodes[childIndex].minBounds.y);
+			maxHeight = std::max(maxHeight, m_nodes[childIndex].maxBounds.y);
+		}
+	}
+
+	node.minBounds = glm::vec3(m_origin.x + x, minHeight, m_origin.y + z);
+	node.maxBounds = glm::vec3(m_origin.x + endX, maxHeight, m_origin.y + endZ);
+	m_nodes[index] = node;
+	return index;
+}
+
+bool TerrainLod::SelectNode(int index, const Frustum& frustum, const glm::vec3& cameraPos)
+{
+	const Node& node = m_nodes[index];
+	// the roots draw whatever is beyond the range of every level
+	if (node.level < m_levels - 1 && !SphereIntersectsBox(cameraPos, m_ranges[node.level], node.minBounds, node.maxBounds))
+	{
+		return false;
+	}
+	if (!frustum.Intersects(node.minBounds, node.maxBounds))
+	{
+		// out of sight, nothing to draw but the parent must not draw it either
+		return true;
+	}
+	if (node.level == 0 || !SphereIntersectsBox(cameraPos, m_ranges[node.level - 1], node.minBounds, node.maxBounds))
+	{
+		AddArea(node, node.level, 0xF);
+		return true;
+	}
+
+	int childMask = 0;
+	for (int child = 0; child < 4; child++)
+	{
+		if (node.children[child] >= 0 && !SelectNode(node.children[child], frustum, cameraPos))
+		{
+			childMask |= 1 << child;
+		}
+	}
+	if (childMask != 0)
+	{
+		AddArea(node, node.level, childMask);
+	}
+	return true;
+}
+
+void TerrainLod::AddArea(const Node& node, int level, int childMask)
+{
+	int half = node.size / 2;
+	for (int child = 0; child < 4; child++)
+	{
+		int x = node.x + (child & 1) * half;
+		int z = node.z + (child >> 1) * half;
+		if ((childMask & (1 << child)) == 0 || x >= (int)m_width - 1 || z >= (int)m_depth - 1)
+		{
+			continue;
+		}
+		Instance instance;
+		instance.offsetSizeLevel = glm::vec4((float)x, (float)z, (float)half, (float)level);
+		m_instances.push_back(instance);
+	}
+	m_drawnNodes++;
+}
+
+void TerrainLod::Render(Shader& shader, const Camera& camera)
+{
+	m_instances.clear();
+	m_drawnNodes = 0;
+	if (m_roots.empty())
+	{
+		return;
+	}
+
+	for (int level = 0; level < m_levels; level++)
+	{
+		m_ranges[level] = m_lodDistance * (float)(1 << level);
+	}
+	Frustum frustum = camera.getFrustum();
+	for (int root : m_roots)
+	{
+		SelectNode(root, frustum, camera.getPosition());
+	}
+	if (m_instances.empty())
+	{
+		return;
+	}
+
+	shader.activate();
+	for (int level = 0; level < m_levels; level++)
+	{
+		// the last level has no parent to morph into
+		float morphEnd = level < m_levels - 1 ? m_ranges[level] : 1.0e30f;
+		float previous = level > 0 ? m_ranges[level - 1] : 0.0f;
+		float morphStart = level < m_levels - 1 ? morphEnd - (morphEnd - previous) * m_morphRatio : morphEnd - 1.0f;
+		shader.setVec2("gMorphRange[" + std::to_string(level) + "]", glm::vec2(morphStart, morphEnd));
+	}
+	shader.setVec3("gCameraPos", camera.getPosition());
+	shader.setVec2("gOrigin", m_origin);
+	shader.setVec2("gSize", glm::vec2((float)m_width, (float)m_depth));
+	shader.setFloat("gGridSize", (float)GridSize);
+
+	for (unsigned int i = 0; i < m_textures.size(); i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glUniform1i(glGetUniformLocation(shader.ID, m_textures[i].type.c_str()), i);
+		glBindTexture(GL_TEXTURE_2D, m_textures[i].id);
+	}
+	unsigned int heightUnit = (unsigned int)m_textures.size();
+	glActiveTexture(GL_TEXTURE0 + heightUnit);
+	glUniform1i(glGetUniformLocation(shader.ID, "gHeightMap"), heightUnit);
+	glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(Instance), m_instances.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindVertexArray(m_VAO);
+	glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0, (GLsizei)m_instances.size());
+	glBindVertexArray(0);
+
+	glActiveTexture(GL_TEXTURE0);
+}
+
+void TerrainLod::InitGridMesh()
+{
+	// vertices are grid coordinates, the instance places and scales them
+	std::vector<glm::vec2> vertices;
+	vertices.reserve((GridSize + 1) * (GridSize + 1));
+	for (int z = 0; z <= GridSize; z++)
+	{
+		for (int x = 0; x <= GridSize; x++)
+		{
+			vertices.push_back(glm::vec2((float)x, (float)z));
+		}
+	}
+
+	// the same triangles as the raw terrain
+	std::vector<unsigned int> indices;
+	indices.reserve(GridSize * GridSize * 6);
+	for (int z = 0; z < GridSize; z++)
+	{
+		for (int x = 0; x < GridSize; x++)
+		{
+			unsigned int bottomLeft = z * (GridSize + 1) + x;
+			unsigned int topLeft = (z + 1) * (GridSize + 1) + x;
+			indices.push_back(bottomLeft);
+			indices.push_back(topLeft);
+			indices.push_back(topLeft + 1);
+			indices.push_back(bottomLeft);
+			indices.push_back(topLeft + 1);
+			indices.push_back(bottomLeft + 1);
+		}
+	}
+	m_indexCount = (int)indices.size();
+
+	glGenVertexArrays(1, &m_VAO);
+	glBindVertexArray(m_VAO);
+
+	glGenBuffers(1, &m_VBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), vertices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+
+	glGenBuffers(1, &m_EBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+	// one instance per drawn grid
+	glGenBuffers(1, &m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, offsetSizeLevel));
+	glVertexAttribDivisor(1, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void TerrainLod::InitHeightTexture()
+{
+	glGenTextures(1, &m_heightTexture);
+	glBindTexture(GL_TEXTURE_2D, m_heightTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_width, m_depth, 0, GL_RED, GL_FLOAT, m_heights.data());
+	// linear filtering interpolates the morphed vertices between two samples
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#define NOMINMAX
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "../mesh.h"
+#include "../camera.h"
+
+namespace ntn
+{
+	// Continuous distance-based level of detail (CDLOD) for a grid of height samples.
+	// A quadtree over the samples picks per frame the coarsest nodes that are fine enough for their distance to the camera,
+	// every picked node is drawn as four instances of one small grid mesh, the vertex shader reads the heights from a texture
+	// and morphs the vertices far in the range of a level onto the grid of the next one, so a level blends into its parent without popping.
+	class TerrainLod
+	{
+	public:
+		// quads along a side of the grid mesh, a node is drawn as 2x2 grids
+		static const int GridSize = 32;
+		static const int MaxLevels = 8;
+
+		// heights row by row (z major), sample (x, z) sits at (origin.x + x, height, origin.y + z)
+		TerrainLod(const std::vector<float>& heights, unsigned int width, unsigned int depth, glm::vec2 origin,
+				   const std::vector<Texture>& textures);
+		~TerrainLod();
+
+		TerrainLod(const TerrainLod&) = delete;
+		TerrainLod& operator=(const TerrainLod&) = delete;
+
+		// picks the nodes for the camera and draws them in one instanced call
+		void Render(Shader& shader, const Camera& camera);
+
+		int getNumberOfLevels() const { return m_levels; }
+		// of the last render
+		int getNumberOfDrawnNodes() const { return m_drawnNodes; }
+		int getNumberOfDrawnTriangles() const { return (int)m_instances.size() * GridSize * GridSize * 2; }
+
+		// distance from the camera up to which the finest level is used, each next level reaches twice as far
+		float m_lodDistance = 256.0f;
+		// part of the range of a level over which its vertices morph into the next one
+		float m_morphRatio = 0.35f;
+
+	private:
+		struct Node
+		{
+			glm::vec3 minBounds;
+			glm::vec3 maxBounds;
+			int x = 0, z = 0;	// first sample
+			int size = 0;	// in samples
+			int level = 0;	// 0 for leaves
+			int children[4] = { -1, -1, -1, -1 };
+		};
+
+		// where the vertex shader places one grid: first sample, sample size and level
+		struct Instance
+		{
+			glm::vec4 offsetSizeLevel;
+		};
+
+		int BuildNode(int x, int z, int size, int level);
+		// false when the node is out of the range of its level, the parent then draws its area
+		bool SelectNode(int index, const Frustum& frustum, const glm::vec3& cameraPos);
+		void AddArea(const Node& node, int level, int childMask);
+
+		void InitGridMesh();
+		void InitHeightTexture();
+
+		std::vector<float> m_heights;
+		unsigned int m_width = 0;
+		unsigned int m_depth = 0;
+		glm::vec2 m_origin = glm::vec2(0.0f);
+		std::vector<Texture> m_textures;
+
+		std::vector<Node> m_nodes;
+		std::vector<int> m_roots;
+		int m_levels = 1;
+		float m_ranges[MaxLevels] = {};
+
+		std::vector<Instance> m_instances;
+		int m_drawnNodes = 0;
+
+		unsigned int m_heightTexture = 0;
+		unsigned int m_VAO = 0, m_VBO = 0, m_EBO = 0, m_instanceVBO = 0;
+		int m_indexCount = 0;
+	};
+}
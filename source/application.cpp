@@ -1,10 +1,13 @@
 #include "application.h"
 #include "logger.h"
-#include "PhysicsEngine/Sphere.h"
+#include "PhysicsEngine/SphereModel.h"
+#include "PhysicsEngine/BoxModel.h"
+#include "PhysicsEngine/ObjectPool.h"
 
 #include<imgui.h>
 #include<imgui_impl_glfw.h>
 #include<imgui_impl_opengl3.h>
+#include<atomic>
 
 namespace ntn
 
@@ -256,82 +259,114 @@ namespace ntn
 
     void Application::MoveObjects()
     {
-        static bool isObjectGrabbed = false;
+        // the box being dragged, the handle goes stale if the box is deleted meanwhile
+        static PoolHandle grabbedBox;
         static glm::vec3 grabOffset;
-        static PhysicsObject* grabbedPhysicsObject = nullptr; // Track the currently grabbed object
+        // the pick ray is cast on the physics thread before its next step, the answer comes back here
+        struct PickResult
+        {
+            std::atomic<bool> done{ false };
+            PoolHandle box;
+            glm::vec3 point = glm::vec3(0.0f);
+        };
+        static std::shared_ptr<PickResult> pendingPick;
         // Click on objects
         if (m_mouseHandler.leftButton.isLeftPressed)
         {
             double mouseX, mouseY;
             glfwGetCursorPos(m_window, &mouseX, &mouseY);
             glm::vec2 mousePosition((float)mouseX, (float)mouseY);
+            float rayLength;
+            Ray ray = MouseRay(mousePosition, rayLength);
 
-            for (PhysicsObject* physicsItem : m_scene->AllPhysicsObjects())
+            glm::vec3 clickedPtsOnScene;
+            if (!RayIntersectsBoundingBox(ray, m_scene->getSceneBounds(), clickedPtsOnScene))
             {
-                if (BoxModel* item_box = dynamic_cast<BoxModel*>(physicsItem))
+                return;
+            }
+
+            // positions come from the physics thread, moves are queued back to it
+            PhysicsThread& physics = m_scene->getPhysicsThread();
+            const TransformFrame& frame = physics.ReadFrame();
+            ObjectPool<BoxModel>& boxes = ObjectPool<BoxModel>::getInstance();
+
+            if (!grabbedBox.isValid())
+            {
+                // closest body under the cursor, found through the broadphase of the physics scene
+                if (!pendingPick)
                 {
-                    glm::vec3 intersectPoint;
-                    bool hit = RayIntersectsBoundingBox(mousePosition, item_box->GetBoundingBox(), intersectPoint);
-
-                    glm::vec3 clickedPtsOnScene;
-                    bool hitScene = RayIntersectsBoundingBox(mousePosition, m_scene->getSceneBounds(), clickedPtsOnScene);
-
-                    if ((hit && hitScene) || isObjectGrabbed)
-                    {
-                        Log::info("Object Clicked!");
-                        Log::info("Intersection Point: " +
-                            std::to_string(intersectPoint.x) + " " +
-                            std::to_string(intersectPoint.y) + " " +
-                            std::to_string(intersectPoint.z));
-                        if (!isObjectGrabbed)
+                    pendingPick = std::make_shared<PickResult>();
+                    std::shared_ptr<PickResult> pick = pendingPick;
+                    physics.Enqueue([pick, ray, rayLength](PhysicsScene& scene) {
+                        RayCastHit hit;
+                        if (scene.RayCast(ray.Origin, ray.Direction, rayLength, hit) && hit.object->getShapeID() == BOX)
                         {
-                            isObjectGrabbed = true;
-                            //    grabOffset = intersectPoint - item->GetPosition();
-                            grabOffset = clickedPtsOnScene - item_box->GetPosition();
-                            grabbedPhysicsObject = item_box;
+                            pick->box = ObjectPool<BoxModel>::getInstance().HandleOf(static_cast<BoxModel*>(hit.object));
+                            pick->point = hit.point;
                         }
+                        pick->done.store(true, std::memory_order_release);
+                        });
+                }
+                if (!pendingPick->done.load(std::memory_order_acquire))
+                {
+                    return;
+                }
+                PoolHandle pickedBox = pendingPick->box;
+                glm::vec3 pickedPoint = pendingPick->point;
+                pendingPick.reset();
 
-                        if (isObjectGrabbed && grabbedPhysicsObject == item_box)
-                        {
-                            Log::info(item_box->GetInfo());
-
-
-                            const BoundingBox& bbox_item = item_box->GetBoundingBox();
-
-                            // Check for collisions with other objects in the scene
-                            /*bool collisionDetected = BoundingBox::CheckCollision(bbox_item, m_scene.getSceneBounds());
+                BoxModel* item_box = boxes.Get(pickedBox);
+                glm::vec3 itemPosition, itemRotation;
+                if (item_box == nullptr || !frame.GetTransform(item_box, 1.0f, itemPosition, itemRotation))
+                {
+                    return;
+                }
+                Log::info("Object Clicked!");
+                Log::info("Intersection Point: " +
+                    std::to_string(pickedPoint.x) + " " +
+                    std::to_string(pickedPoint.y) + " " +
+                    std::to_string(pickedPoint.z));
+                Log::info(item_box->GetInfo(itemPosition, itemRotation));
+                grabbedBox = pickedBox;
+                grabOffset = clickedPtsOnScene - itemPosition;
+            }
 
-                            if (collisionDetected)
-                            {
-                                Log::info("Object on the scene!!!");
-                            }*/
+            BoxModel* item_box = boxes.Get(grabbedBox);
+            glm::vec3 itemPosition, itemRotation;
+            if (item_box == nullptr || !frame.GetTransform(item_box, 1.0f, itemPosition, itemRotation))
+            {
+                grabbedBox = PoolHandle();
+                return;
+            }
 
-                            glm::vec3 newTarget(clickedPtsOnScene.x - grabOffset.x,
-                                clickedPtsOnScene.y - grabOffset.y,
-                                clickedPtsOnScene.z - grabOffset.z);
+            glm::vec3 newTarget = clickedPtsOnScene - grabOffset;
 
-                            // Ensure the object stays above the scene
-                            float minY = m_scene->getSceneBounds().GetMaxBounds().y + bbox_item.GetDimensions().y / 2.0f;
-                            newTarget.y = std::max(newTarget.y, minY);
-                            // Smoothly move the object
-                            static float moveSpeed = 0.05f;
-                            glm::vec3 newPos = glm::mix(item_box->GetPosition(), newTarget, moveSpeed);
+            // Ensure the object stays above the scene
+            float minY = m_scene->getSceneBounds().GetMaxBounds().y + item_box->GetBoundingBoxAt(itemPosition).GetDimensions().y / 2.0f;
+            newTarget.y = std::max(newTarget.y, minY);
+            // Smoothly move the object
+            static float moveSpeed = 0.05f;
+            glm::vec3 newPos = glm::mix(itemPosition, newTarget, moveSpeed);
 
-                            item_box->SetPosition(newPos);
-                        }
-                    }
+            PoolHandle handle = grabbedBox;
+            physics.Enqueue([handle, newPos](PhysicsScene& scene) {
+                if (BoxModel* box = ObjectPool<BoxModel>::getInstance().Get(handle))
+                {
+                    box->SetPosition(newPos);
+                    // the cubes are static, their tree is not refit on its own
+                    scene.updateStaticObject(box);
                 }
-            }
-
+                });
         }
         else
         {
-            // Reset isObjectGrabbed when the left mouse button is released
-            isObjectGrabbed = false;
+            // Release the grabbed box when the left mouse button is released, a pick still in flight is dropped
+            grabbedBox = PoolHandle();
+            pendingPick.reset();
         }
     }
 
-    bool Application::RayIntersectsBoundingBox(glm::vec2& mousePos, const BoundingBox& bbox, glm::vec3& intersectPoint)
+    Ray Application::MouseRay(const glm::vec2& mousePos, float& length)
     {
         // Convert mouse position to normalized device coordinates (NDC)
         float ndcX = (2.0f * mousePos.x) / m_camera->getViewportWidth() - 1.0f;
@@ -351,13 +386,19 @@ namespace ntn
         glm::vec4 farPointView = inverseView * (inverseProjection * farPoint);
         farPointView /= farPointView.w;
 
-        // Create the ray
+        // from the near plane to the far plane
         Ray ray;
         ray.Origin = glm::vec3(nearPointView);
-        ray.Direction = glm::normalize(glm::vec3(farPointView - nearPointView));
-        // Print statements for debugging
-        bool hit = RayIntersectsBoundingBox(ray, bbox, intersectPoint);
-        return hit;
+        glm::vec3 toFar = glm::vec3(farPointView - nearPointView);
+        length = glm::length(toFar);
+        ray.Direction = toFar / length;
+        return ray;
+    }
+
+    bool Application::RayIntersectsBoundingBox(glm::vec2& mousePos, const BoundingBox& bbox, glm::vec3& intersectPoint)
+    {
+        float length;
+        return RayIntersectsBoundingBox(MouseRay(mousePos, length), bbox, intersectPoint);
     }
 
     bool Application::RayIntersectsBoundingBox(const Ray& ray, const BoundingBox& bbox, glm::vec3& intersectPts)
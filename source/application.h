@@ -49,6 +49,8 @@ public:
 
 	//TODO for physcial objects interactions
 	void MoveObjects();
+	// world ray under the cursor, length is the distance between the near and far planes
+	Ray MouseRay(const glm::vec2& mousePos, float& length);
 	bool RayIntersectsBoundingBox(glm::vec2 &mousePos,const BoundingBox& bbox, glm::vec3& intersectPoint);
 	bool RayIntersectsBoundingBox(const Ray& ray, const BoundingBox& bbox,glm::vec3& intersectPts);
 
@@ -4,6 +4,34 @@
 namespace ntn
 {
 
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+	// rows of the matrix added to and subtracted from the w row (Gribb, Hartmann)
+	glm::mat4 m = glm::transpose(viewProjection);
+	planes[0] = m[3] + m[0];	// left
+	planes[1] = m[3] - m[0];	// right
+	planes[2] = m[3] + m[1];	// bottom
+	planes[3] = m[3] - m[1];	// top
+	planes[4] = m[3] + m[2];	// near
+	planes[5] = m[3] - m[2];	// far
+}
+
+bool Frustum::Intersects(const glm::vec3& minBounds, const glm::vec3& maxBounds) const
+{
+	for (const glm::vec4& plane : planes)
+	{
+		// the corner furthest along the normal
+		glm::vec3 corner(plane.x >= 0.0f ? maxBounds.x : minBounds.x,
+						 plane.y >= 0.0f ? maxBounds.y : minBounds.y,
+						 plane.z >= 0.0f ? maxBounds.z : minBounds.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 Camera::Camera(ViewMode typeView, float verticalFOV, float nearClip, float farClip)
 				:typeView(typeView), m_VerticalFOV(verticalFOV), 
 				 m_NearClip(nearClip), m_FarClip(farClip)
@@ -35,6 +35,19 @@ namespace ntn
 	const float ZOOM = 45.0f;
 	const float MOUSE_SENSITIVITY = 0.002f;
 
+	// the six planes of a view-projection matrix, normals pointing inside
+	struct Frustum
+	{
+		glm::vec4 planes[6];
+
+		Frustum() = default;
+		explicit Frustum(const glm::mat4& viewProjection);
+
+		// conservative: a box near a corner may pass although it is outside
+		bool Intersects(const glm::vec3& minBounds, const glm::vec3& maxBounds) const;
+		bool Intersects(const BoundingBox& bbox) const { return Intersects(bbox.GetMinBounds(), bbox.GetMaxBounds()); }
+	};
+
 	class Camera
 	{
 	public:
@@ -52,6 +65,7 @@ namespace ntn
 		const glm::mat4& getInverseProjectionMatrix() const { return m_InverseProjection; }
 		const glm::mat4& getViewMatrix() const { return m_View; }
 		const glm::mat4& getInverseViewMatrix() const { return m_InverseView; }
+		Frustum getFrustum() const { return Frustum(m_Projection * m_View); }
 
 		// Position and Direction
 		const glm::vec3& getPosition() const { return m_Position; }
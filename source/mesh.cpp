@@ -180,6 +180,39 @@ void Mesh::setupTessMesh()
     glPatchParameteri(GL_PATCH_VERTICES, 4);
 }
 void Mesh::render(Shader& shader)
+{
+    bindTextures(shader);
+
+    // draw mesh
+    glBindVertexArray(VAO);
+    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
+
+    // always good practice to set everything back to defaults once configured.
+    glActiveTexture(GL_TEXTURE0);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+    {
+        printf("OpenGL error in Mesh::Render, code: 0x%x\n", error);
+    }
+}
+
+void Mesh::renderRanges(Shader& shader, const std::vector<GLsizei>& counts, const std::vector<const void*>& offsets)
+{
+    if (counts.empty())
+    {
+        return;
+    }
+    bindTextures(shader);
+
+    glBindVertexArray(VAO);
+    glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(counts.size()));
+    glBindVertexArray(0);
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Mesh::bindTextures(Shader& shader)
 {
     // bind appropriate textures
     unsigned int diffuseNr = 1;
@@ -205,19 +238,6 @@ void Mesh::render(Shader& shader)
         // and finally bind the texture
         glBindTexture(GL_TEXTURE_2D, textures[i].id);
     }
-
-    // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    // always good practice to set everything back to defaults once configured.
-    glActiveTexture(GL_TEXTURE0);
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR)
-    {
-        printf("OpenGL error in Mesh::Render, code: 0x%x\n", error);
-    }
 }
 
 void Mesh::renderSkyBox(Shader& shader)
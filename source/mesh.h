@@ -70,9 +70,13 @@ public:
     void RenderSkyDome(Shader& shader);
     void RenderTesselation(Shader& shader);
     void RenderTerrain(Shader& shader, int res, int nInstances);
+    // one draw call for several ranges of the index buffer, offsets in bytes
+    void renderRanges(Shader& shader, const std::vector<GLsizei>& counts, const std::vector<const void*>& offsets);
 
 private:
 
+    void bindTextures(Shader& shader);
+
     void setupMesh();
     void setupMeshWithoutIndices();
     void setupTessMesh();
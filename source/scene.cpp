@@ -10,9 +10,9 @@
 
 #include "traceRay.h"
 #include "PhysicsEngine/RigidBody.h"
-#include "PhysicsEngine/Sphere.h"
-#include "PhysicsEngine/Plane.h"
-#include "PhysicsEngine/Box.h"
+#include "PhysicsEngine/SphereModel.h"
+#include "PhysicsEngine/PlaneModel.h"
+#include "PhysicsEngine/BoxModel.h"
 
 #include "Sky/SkyBox.h"
 #include "Sky/SkyDome.h"
@@ -22,18 +22,21 @@
 
 namespace ntn
 {
-	typedef bool(*fn)(PhysicsObject*, PhysicsObject*);
-
-	static fn collisionFuncs[] =
-	{
-		Scene::planeToPlane, Scene::planeToSphere, Scene::planeToBox,
-		Scene::sphereToPlane, Scene::sphereToSphere, Scene::sphereToBox,
-		Scene::boxToPlane, Scene::boxToSphere, Scene::boxToBox
-	};
-
 	Scene::Scene(SkyType typeSkye):m_typeSky(typeSkye)
 	{
+		m_physicsScene = std::make_unique<PhysicsScene>();
+		m_physicsScene->setGravity(m_gravity);
+		m_physicsScene->m_properties = PhysicsProperties(true, true, true);
+		m_physicsProperties = m_physicsScene->m_properties;
+		m_maxSubSteps = m_physicsScene->getMaxSubSteps();
+		m_physicsThread = std::make_unique<PhysicsThread>(*m_physicsScene);
+
 		loadScene();
+
+		if (m_threadedPhysics)
+		{
+			m_physicsThread->Start();
+		}
 	}
 
 	void Scene::loadScene()
@@ -49,14 +52,14 @@ namespace ntn
 		updateSky(m_typeSky);
 
 		m_terrain = std::make_unique<Terrain>(TerrainType::Raw);
+		m_physicsScene->addObject(m_terrain.get());
 	}
 
 	Scene::~Scene()
 	{
-		for (auto& item : m_allPhysicsObjects)
-		{
-			delete item;
-		}
+		m_physicsThread->Stop();
+		// physics objects are deleted by the physics scene, except the terrain the scene owns
+		m_physicsScene->removeObject(m_terrain.get());
 	}
 
 	void Scene::setGui()
@@ -67,9 +70,89 @@ namespace ntn
 		SkyType previousType = m_typeSky;
 		ImGui::Combo("Sky", reinterpret_cast<int*>(&m_typeSky), skyItems, IM_ARRAYSIZE(skyItems));
 
-		static const char* terrainItems[] = { "Raw", "Tesselation" };
+		static const char* terrainItems[] = { "Raw", "Tesselation", "CDLOD", "Raw (height texture)" };
+		// the panels below belong to the terrain as it is built, a new type only takes effect in updateTerrain
 		TerrainType previousTerrainType = m_terrain->m_typeRealTerrain;
-		ImGui::Combo("Terrain", reinterpret_cast<int*>(&m_terrain->m_typeRealTerrain), terrainItems, IM_ARRAYSIZE(terrainItems));
+		int terrainType = (int)previousTerrainType;
+		ImGui::Combo("Terrain", &terrainType, terrainItems, IM_ARRAYSIZE(terrainItems));
+		if (previousTerrainType == TerrainType::Raw || previousTerrainType == TerrainType::Compact)
+		{
+			ImGui::Text("Terrain chunks: %d / %d, %d triangles", m_terrain->getNumberOfDrawnChunks(), (int)m_terrain->getChunks().size(), m_terrain->getNumberOfDrawnTriangles());
+			ImGui::Text("Terrain GPU memory: %.1f MB", m_terrain->getGpuBytes() / (1024.0f * 1024.0f));
+		}
+		else if (previousTerrainType == TerrainType::Lod && m_terrain->getLod() != nullptr)
+		{
+			TerrainLod* lod = m_terrain->getLod();
+			ImGui::SliderFloat("LOD distance", &lod->m_lodDistance, 64.0f, 2048.0f);
+			ImGui::SliderFloat("Morph ratio", &lod->m_morphRatio, 0.05f, 1.0f);
+			ImGui::Text("Terrain nodes: %d, %d levels, %d triangles", lod->getNumberOfDrawnNodes(), lod->getNumberOfLevels(), lod->getNumberOfDrawnTriangles());
+		}
+
+		// the scene may be stepping on the physics thread, read what it published and queue the edits
+		const TransformFrame& frame = m_physicsThread->ReadFrame();
+		const CollisionStats& stats = frame.profile.stats;
+		ImGui::Text("Pairs: %lld candidates, %d tested, %d contacts", (long long)stats.candidatePairs, stats.testedPairs, stats.contacts);
+		ImGui::Text("Pruned: %.1f %%", stats.PruningRatio() * 100.0f);
+
+		if (ImGui::Checkbox("Physics thread", &m_threadedPhysics))
+		{
+			if (m_threadedPhysics)
+			{
+				m_physicsThread->Start();
+			}
+			else
+			{
+				m_physicsThread->Stop();
+			}
+		}
+		ImGui::Text("Physics step: %llu, %.2f ms", (unsigned long long)frame.step, frame.profile.timings.total);
+
+		bool propertiesChanged = false;
+		static const char* broadphaseItems[] = { "Sweep and prune", "AABB tree", "Spatial hash" };
+		propertiesChanged |= ImGui::Combo("Broadphase", reinterpret_cast<int*>(&m_physicsProperties.broadphase), broadphaseItems, IM_ARRAYSIZE(broadphaseItems));
+
+		if (ImGui::SliderInt("Max sub-steps", &m_maxSubSteps, 1, 16))
+		{
+			int maxSubSteps = m_maxSubSteps;
+			m_physicsThread->Enqueue([maxSubSteps](PhysicsScene& scene) { scene.setMaxSubSteps(maxSubSteps); });
+		}
+		ImGui::Text("Steps this frame: %d", frame.profile.steps);
+
+		propertiesChanged |= ImGui::Checkbox("Sleeping", &m_physicsProperties.sleeping);
+		ImGui::Text("Sleeping bodies: %d, islands: %d", frame.profile.sleepingBodies, frame.profile.islands);
+
+		propertiesChanged |= ImGui::Checkbox("Continuous collisions", &m_physicsProperties.continuousCollisions);
+		ImGui::Text("Swept bodies: %d, hits: %d", stats.sweptBodies, stats.sweptHits);
+
+		static const char* responseItems[] = { "Forces", "Sequential impulse" };
+		propertiesChanged |= ImGui::Combo("Response", reinterpret_cast<int*>(&m_physicsProperties.response), responseItems, IM_ARRAYSIZE(responseItems));
+		propertiesChanged |= ImGui::SliderInt("Velocity iterations", &m_physicsProperties.solver.velocityIterations, 1, 32);
+		propertiesChanged |= ImGui::Checkbox("Warm starting", &m_physicsProperties.solver.warmStarting);
+		ImGui::Text("Manifolds: %d, warm started: %d", stats.manifolds, stats.warmStarted);
+		ImGui::Text("Joints: %d, constraint colors: %d", stats.joints, stats.colors);
+
+		if (propertiesChanged)
+		{
+			PhysicsProperties properties = m_physicsProperties;
+			m_physicsThread->Enqueue([properties](PhysicsScene& scene) { scene.m_properties = properties; });
+		}
+
+		if (ImGui::Button("Save snapshot"))
+		{
+			std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
+			m_physicsScene->SaveSnapshot(m_snapshot);
+			m_snapshot.WriteFile("physics.snapshot");
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Restore snapshot"))
+		{
+			std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
+			if (!m_physicsScene->RestoreSnapshot(m_snapshot))
+			{
+				Log::warning("Snapshot does not match the physics scene");
+			}
+		}
+		ImGui::Text("Snapshot: %d bytes", (int)m_snapshot.size());
 
 		ImGui::End();
 
@@ -78,10 +161,83 @@ namespace ntn
 			updateSky(m_typeSky);
 		}
 
-		if (m_terrain->m_typeRealTerrain != previousTerrainType)
+		if ((TerrainType)terrainType != previousTerrainType)
 		{
-			updateTerrain(m_terrain->m_typeRealTerrain);
+			updateTerrain((TerrainType)terrainType);
 		}
+
+		setProfilerGui();
+	}
+
+	void Scene::setProfilerGui()
+	{
+		// one sample per drawn frame, the updates in between only reach the CSV written by the physics thread
+		const TransformFrame& frame = m_physicsThread->ReadFrame();
+		if (frame.profile.update != m_profiledUpdate)
+		{
+			m_profiler.Record(frame.profile);
+			m_profiledUpdate = frame.profile.update;
+		}
+
+		ImGui::Begin("Physics profiler");
+		if (m_profiler.numberOfSamples() == 0)
+		{
+			ImGui::Text("No physics update yet");
+			ImGui::End();
+			return;
+		}
+
+		struct Plot
+		{
+			const char* label;
+			float (*value)(const PhysicsProfileSample& sample);
+		};
+		static const Plot plots[] =
+		{
+			{ "Total ms", [](const PhysicsProfileSample& sample) { return sample.timings.total; } },
+			{ "Integrate ms", [](const PhysicsProfileSample& sample) { return sample.timings.integrate; } },
+			{ "Broadphase ms", [](const PhysicsProfileSample& sample) { return sample.timings.broadphase; } },
+			{ "Narrowphase ms", [](const PhysicsProfileSample& sample) { return sample.timings.narrowphase; } },
+			{ "Solver ms", [](const PhysicsProfileSample& sample) { return sample.timings.response; } },
+			{ "Islands ms", [](const PhysicsProfileSample& sample) { return sample.timings.islands; } },
+			{ "Tested pairs", [](const PhysicsProfileSample& sample) { return (float)sample.stats.testedPairs; } },
+			{ "Contacts", [](const PhysicsProfileSample& sample) { return (float)sample.stats.contacts; } },
+			{ "Allocations", [](const PhysicsProfileSample& sample) { return (float)sample.allocations; } },
+		};
+		std::vector<float> values(m_profiler.numberOfSamples());
+		for (const Plot& plot : plots)
+		{
+			for (int index = 0; index < (int)values.size(); index++)
+			{
+				values[index] = plot.value(m_profiler.getSample(index));
+			}
+			char overlay[32];
+			snprintf(overlay, sizeof(overlay), "last %.2f, mean %.2f", values.back(), m_profiler.Average(plot.value));
+			ImGui::PlotLines(plot.label, values.data(), (int)values.size(), 0, overlay, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+		}
+
+		const PhysicsProfileSample& last = m_profiler.getLast();
+		ImGui::Text("Bodies: %d, sleeping: %d, islands: %d", last.bodies, last.sleepingBodies, last.islands);
+		ImGui::Text("Allocations: %llu, %llu bytes", (unsigned long long)last.allocations, (unsigned long long)last.allocatedBytes);
+
+		if (!m_physicsThread->isStreamingProfile())
+		{
+			if (ImGui::Button("Start CSV") && !m_physicsThread->StartProfileCsv("physics_profile.csv"))
+			{
+				Log::warning("Could not create physics_profile.csv");
+			}
+		}
+		else if (ImGui::Button("Stop CSV"))
+		{
+			m_physicsThread->StopProfileCsv();
+		}
+		if (m_physicsThread->isStreamingProfile())
+		{
+			ImGui::SameLine();
+			ImGui::Text("Streaming to physics_profile.csv");
+		}
+
+		ImGui::End();
 	}
 
 	void Scene::updateSky(SkyType& skyType)
@@ -99,54 +255,58 @@ namespace ntn
 
 	void Scene::updateTerrain(TerrainType terrainType)
 	{
+		std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
+		m_physicsScene->removeObject(m_terrain.get());
 		m_terrain.reset();
 		m_terrain = std::make_unique<Terrain>(terrainType);
+		m_physicsScene->addObject(m_terrain.get());
 	}
 
 	void  Scene::resetScene()
 	{
+		std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
 		// reset all objects's position and velocity
 		for (auto& item : m_allPhysicsObjects)
 		{
 			item->ResetPosition();
 			item->ResetVelocity();
-			SphereModel* ball_item = dynamic_cast<SphereModel*>(item);
-			if (ball_item)
+			// the scene only holds models, the shape ID tells which one
+			if (item->getShapeID() == SPHERE)
 			{
-				ball_item->ComputeBoundingBox();
+				static_cast<SphereModel*>(item)->ComputeBoundingBox();
 			}
 		}
 
 		// reset all cubes's position and velocity
-		for (auto& item : m_cubes)
+		for (BoxModel* item : m_cubes)
 		{
 			item->ResetPosition();
 			item->ResetVelocity();
-			BoxModel* box_item = dynamic_cast<BoxModel*>(item);
-			if (box_item)
-			{
-				box_item->ComputeBoundingBox();
-			}
+			item->ComputeBoundingBox();
+			m_physicsScene->updateStaticObject(item);
 		}
 	}
 
 	void  Scene::clearScene()
 	{
+		std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
 		m_allPhysicsObjects.clear();
+		m_cubes.clear();
+		m_physicsScene->clearScene();
+		// the terrain stays, bodies spawned later still land on it
+		m_physicsScene->addObject(m_terrain.get());
 	}
 
 	void Scene::onUpdate(float deltaTime)
 	{
-		for (auto& item : m_allPhysicsObjects)
-		{
-			item->UpdatePhysics(m_properties.gravity ? m_gravity : glm::vec3(0.0f), deltaTime);
-		}
+		// integrates every body and runs the collision pass, unless the physics thread already does
+		m_physicsThread->Update(deltaTime);
+	}
 
-		// check for collisions
-		if (m_properties.collisions)
-		{
-			checkCollisions();
-		}
+	void Scene::setGravity(const glm::vec3 gravity)
+	{
+		m_gravity = gravity;
+		m_physicsThread->Enqueue([gravity](PhysicsScene& scene) { scene.setGravity(gravity); });
 	}
 
 	void Scene::render(ShadersManager& shadersManager, const std::unique_ptr<Camera>& camera)
@@ -178,6 +338,16 @@ namespace ntn
 			Shader& tessTerrainShader = shadersManager.getShader("TessTerrainShader");
 			RenderTerrain(tessTerrainShader, camera);
 		}
+		else if (m_terrain->m_typeRealTerrain == TerrainType::Compact)
+		{
+			Shader& compactTerrainShader = shadersManager.getShader("CompactTerrainShader");
+			RenderTerrain(compactTerrainShader, camera);
+		}
+		else if (m_terrain->m_typeRealTerrain == TerrainType::Lod)
+		{
+			Shader& lodTerrainShader = shadersManager.getShader("LodTerrainShader");
+			RenderTerrain(lodTerrainShader, camera);
+		}
 	}
 
 	void Scene::renderSkyBox(Shader& shaderSkybox, const std::unique_ptr<Camera>& camera)
@@ -243,7 +413,8 @@ namespace ntn
 		glm::mat4 view = camera->getViewMatrix();
 		glm::mat4 projection = camera->getProjectionMatrix();
 		shader_terrain.setMVP(model, view, projection);
-		m_terrain->Render(shader_terrain);
+		// the terrain is drawn where its vertices are, it is culled against the camera as it is
+		m_terrain->Render(shader_terrain, *camera);
 		// Check for OpenGL errors
 		if (glGetError() != GL_NO_ERROR)
 		{
@@ -276,7 +447,11 @@ namespace ntn
 	}
 	void Scene::UpdatePhysicsObjectToFitScene(PhysicsObject& object)
 	{
-		SphereModel* box = dynamic_cast<SphereModel*>(&object);
+		if (object.getShapeID() != SPHERE)
+		{
+			return;
+		}
+		SphereModel* box = static_cast<SphereModel*>(&object);
 
 		glm::vec3 sceneBoundsCenter = m_sceneBounds.GetCenter();
 		const BoundingBox& model_bbox = box->GetBoundingBox();
@@ -291,6 +466,12 @@ namespace ntn
 
 	void Scene::InitializeCubes(const std::string& filePath)
 	{
+		std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
+		for (BoxModel* cube : m_cubes)
+		{
+			m_physicsScene->removeObject(cube);
+			delete cube;
+		}
 		m_cubes.clear();
 
 		int numRows = 10;
@@ -307,7 +488,10 @@ namespace ntn
 				glm::vec3 position(col * (spacing + cubeSize), 50.0f, row * (spacing + cubeSize));
 				cube_i->SetPosition(position);
 				cube_i->SetCurrentPosAsOriginalPos();
+				// cubes are the ground, they are never integrated
+				cube_i->Rigidbody()->setStatic(true);
 				m_cubes.push_back(cube_i);
+				m_physicsScene->addObject(cube_i);
 			}
 		}
 		/*
@@ -356,6 +540,7 @@ namespace ntn
 
 	void Scene::InitializeBalls(const std::string& ballPath)
 	{
+		std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
 		SphereModel* ball1 = new SphereModel(ballPath, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 		SphereModel* ball2 = new SphereModel(ballPath, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 0.0f));
 		SphereModel* ball3 = new SphereModel(ballPath, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 0.0f));
@@ -364,6 +549,10 @@ namespace ntn
 		m_allPhysicsObjects.push_back(ball2);
 		m_allPhysicsObjects.push_back(ball3);
 
+		m_physicsScene->addObject(ball1);
+		m_physicsScene->addObject(ball2);
+		m_physicsScene->addObject(ball3);
+
 		UpdateAllObjectsToFitScene();
 
 		ball1->Translation(glm::vec3(3.0f, 5.0f, 3.0f));
@@ -393,18 +582,25 @@ namespace ntn
 		glm::mat4 projection = camera->getProjectionMatrix();
 		shader.setMVP(model, view, projection);
 
+		// draw between the last two published steps so motion stays smooth at any frame rate,
+		// objects spawned after the frame show up with the next one
+		const TransformFrame& frame = m_physicsThread->ReadFrame();
+		float alpha = m_physicsThread->RenderAlpha(frame);
+		glm::vec3 position, rotation;
 		for (BoxModel* cube : m_cubes)
 		{
-			cube->Render(shader);
+			if (frame.GetTransform(cube, alpha, position, rotation))
+			{
+				cube->Render(shader, position, rotation);
+			}
 		}
 
 
-		for (auto& item : AllPhysicsObjects())
+		for (PhysicsObject* item : m_allPhysicsObjects)
 		{
-			SphereModel* ball_item = dynamic_cast<SphereModel*>(item);
-			if (ball_item)
+			if (item->getShapeID() == SPHERE && frame.GetTransform(item, alpha, position, rotation))
 			{
-				ball_item->Render(shader);
+				static_cast<SphereModel*>(item)->Render(shader, position, rotation);
 			}
 		}
 
@@ -413,11 +609,13 @@ namespace ntn
 		{
 			m_sceneBounds.Render(shader);
 
-			for (auto& item : AllPhysicsObjects())
+			for (PhysicsObject* item : m_allPhysicsObjects)
 			{
-				SphereModel* ball = dynamic_cast<SphereModel*>(item);
-				BoundingBox bbox_item = ball->GetBoundingBox();
-				bbox_item.Render(shader);
+				if (item->getShapeID() == SPHERE && frame.GetTransform(item, alpha, position, rotation))
+				{
+					BoundingBox bbox_item = static_cast<SphereModel*>(item)->GetBoundingBoxAt(position);
+					bbox_item.Render(shader);
+				}
 			}
 
 			BoundingBox bbox_terrain = m_terrain->GetBoundingBox();
@@ -506,462 +704,8 @@ namespace ntn
 
 	void Scene::checkCollisions()
 	{
-		int nbrObjects = numberOfObjects();
-
-		// check for collisions between objects
-		for (int idx1 = 0; idx1 < nbrObjects - 1; idx1++)
-		{
-			for (int idx2 = idx1 + 1; idx2 < nbrObjects; idx2++)
-			{
-				PhysicsObject* objA = m_allPhysicsObjects[idx1];
-				PhysicsObject* objB = m_allPhysicsObjects[idx2];
-				int shapeIdA = objA->getShapeID();
-				int shapeIdB = objB->getShapeID();
-				// skip checking collisions for joints
-				if (shapeIdA < 0 || shapeIdB < 0)
-				{
-					continue;
-				}
-				// function pointers
-				int functionID = (shapeIdA * SHAPE_COUNT) + shapeIdB;
-				fn collisionFuncPtr = collisionFuncs[functionID];
-				if (collisionFuncPtr != nullptr)
-				{
-					collisionFuncPtr(objA, objB);
-				}
-			}
-		}
-
-		int nbrGrounds = m_cubes.size();
-		for (int objIdx = 0; objIdx < nbrObjects; objIdx++)
-		{
-			PhysicsObject* physObj = m_allPhysicsObjects[objIdx];
-
-			for (int groundIndex = 0; groundIndex < nbrGrounds; groundIndex++) {
-				BoxModel* ground = m_cubes[groundIndex];
-
-				// Check for collision between physics object and ground
-				int shapeIdA = physObj->getShapeID();
-				int shapeIdB = ground->getShapeID();
-				// skip checking collisions for joints
-				if (shapeIdA < 0 || shapeIdB < 0)
-				{
-					continue;
-				}
-				// function pointers
-				int functionID = (shapeIdA * SHAPE_COUNT) + shapeIdB;
-				fn collisionFuncPtr = collisionFuncs[functionID];
-				if (collisionFuncPtr != nullptr)
-				{
-					collisionFuncPtr(physObj, ground);
-				}
-			}
-		}
-	}
-	/*********************************************************************************************************
-	* Plane to Object collsions
-	**********************************************************************************************************/
-
-	bool Scene::planeToPlane(PhysicsObject* a_planeA, PhysicsObject* a_planeB)
-	{
-		Plane* planeA = dynamic_cast<Plane*>(a_planeA);
-		Plane* planeB = dynamic_cast<Plane*>(a_planeB);
-		// check if objects aren't null before testing
-		if (planeA != nullptr && planeB != nullptr) {
-			// check plane for collision
-			// if the normals are pointing in the same direction
-			//	- just check distance between and distance fom origin
-			// if the normal are at an angle
-			//	- could do some fancy trig or aabb stuff
-		}
-		return false;
-	}
-
-	bool Scene::planeToSphere(PhysicsObject* plane, PhysicsObject* sphere)
-	{
-		return sphereToPlane(sphere, plane);
-	}
-
-	bool Scene::planeToBox(PhysicsObject* plane, PhysicsObject* box)
-	{
-		return boxToPlane(box, plane);
-	}
-	/*********************************************************************************************************
-	* Sphere to Object collsions
-	**********************************************************************************************************/
-	bool Scene::sphereToSphere(PhysicsObject* a_sphereA, PhysicsObject* a_sphereB)
-	{
-		SphereModel* sphereA = dynamic_cast<SphereModel*>(a_sphereA);
-		SphereModel* sphereB = dynamic_cast<SphereModel*>(a_sphereB);
-
-		if (sphereA != nullptr && sphereB != nullptr)
-		{
-			// check sphere for collision
-			float distance = glm::distance(sphereA->GetPosition(), sphereB->GetPosition());
-			float totalRadius = sphereA->GetRadius() + sphereB->GetRadius();
-			// compare distance between centers to combined radius
-			if (distance < totalRadius)
-			{
-				// cahce bool values
-				bool kinematicA = sphereA->Rigidbody()->m_data.isKinematic;
-				bool kinematicB = sphereB->Rigidbody()->m_data.isKinematic;
-				bool onGroundA = sphereA->Rigidbody()->m_data.onGround;
-				bool onGroundB = sphereB->Rigidbody()->m_data.onGround;
-				// check either is kinematic
-				if (!kinematicA || !kinematicB)
-				{
-					// get the normal of the gap between objects
-					glm::vec3 collisionNormal = glm::normalize(sphereB->GetPosition() - sphereA->GetPosition());
-					// if both spheres are not on the ground
-					if (!onGroundA && !onGroundB) {
-						// calculate force vector
-						glm::vec3 relativeVelocity = sphereA->GetVelocity() - sphereB->GetVelocity();
-						glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
-						glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / sphereA->Rigidbody()->m_data.mass + 1.0f / sphereB->Rigidbody()->m_data.mass);
-
-						// combine elasticity
-						float combinedElasticity = (sphereA->Rigidbody()->m_data.elasticity +
-							sphereB->Rigidbody()->m_data.elasticity / 2.0f);
-						// use Newton's third law to apply collision forces to colliding bodies 
-						sphereA->Rigidbody()->applyForceToAnotherBody(sphereB->Rigidbody(), forceVector + (forceVector * combinedElasticity));
-
-						// apply torque
-						glm::vec3 centerPoint = sphereA->GetPosition() - sphereB->GetPosition();
-						glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
-
-						float torque = glm::dot(torqueLever, relativeVelocity) * 1.0f / (1.0f / sphereA->Rigidbody()->m_data.mass + 1.0f / sphereB->Rigidbody()->m_data.mass);
-
-						sphereA->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-						sphereB->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-						// move out spheres out of collision 
-						glm::vec3 separationVector = collisionNormal * distance * 0.5f;
-						sphereA->SetPosition(sphereA->GetPosition() - separationVector);
-						sphereB->SetPosition(sphereB->GetPosition() + separationVector);
-					}
-					// if one sphere is on the ground treat collsion as plane collision
-					if (onGroundA || onGroundB)
-					{
-						// determine moving sphere
-						Sphere* sphere = (onGroundA ? sphereB : sphereA);
-						Sphere* sphereGround = (onGroundA ? sphereA : sphereB);
-						// calculate force vector
-						glm::vec3 forceVector = -1 * sphere->Rigidbody()->m_data.mass * collisionNormal * (glm::dot(collisionNormal, sphere->GetVelocity()));
-						// apply force
-						sphere->Rigidbody()->applyForce(forceVector * 2.0f);
-						// apply torque
-						glm::vec3 torqueLever = glm::normalize(glm::vec3(collisionNormal.y, -collisionNormal.x, 0.0f));
-
-						float torque = glm::dot(torqueLever, sphere->GetVelocity()) * -1.0f / (1.0f / sphereA->Rigidbody()->m_data.mass);
-						sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-						// move out of collision
-						glm::vec3 separationVector = collisionNormal * distance * 0.5f;
-						sphere->SetPosition(sphere->GetPosition() - separationVector);
-						// stop other sphere from being on ground
-						sphereGround->Rigidbody()->m_data.onGround = false;
-					}
-				}
-				else
-				{
-					// object colliding yes, stop objects
-					sphereA->SetVelocity(glm::vec3(0.0f));
-					sphereB->SetVelocity(glm::vec3(0.0f));
-					if (onGroundA || onGroundB)
-					{
-						sphereA->Rigidbody()->m_data.onGround = true;
-						sphereB->Rigidbody()->m_data.onGround = true;
-					}
-				}
-				return true;
-			}
-		}
-		return false;
-	}
-
-	bool Scene::sphereToPlane(PhysicsObject* a_sphere, PhysicsObject* a_plane)
-	{
-		Sphere* sphere = dynamic_cast<Sphere*>(a_sphere);
-		Plane* plane = dynamic_cast<Plane*>(a_plane);
-
-		if (sphere != nullptr && plane != nullptr)
-		{
-			bool kinematic = sphere->Rigidbody()->m_data.isKinematic;
-			glm::vec3 planeNorm = plane->getNormal();
-			float planeDO = plane->getDistance();
-			// magnitude of sphere vector, plane normal
-			float mag = (dot(sphere->GetPosition(), planeNorm));
-
-			// if planeNorm is below 0 magnitude will be negative
-			if (mag < 0)
-			{
-				planeNorm *= -1;
-				mag *= -1;
-			}
-
-			float collision = mag - sphere->GetRadius();
-			// collision check
-			if (collision < 0.0f)
-			{
-				if (!kinematic)
-				{
-					// calculate force vector
-					glm::vec3 forceVector = -1 * sphere->Rigidbody()->m_data.mass * planeNorm * (glm::dot(planeNorm, sphere->GetVelocity()));
-					// combine elasticity
-					float combinedElasticity = (sphere->Rigidbody()->m_data.elasticity +
-						plane->getElasticity() / 2.0f);
-					// only bounce if not resting on the ground
-					if (!sphere->Rigidbody()->m_data.onGround)
-					{
-						sphere->Rigidbody()->applyForce(forceVector + (forceVector * combinedElasticity));
-						// apply torque
-						glm::vec3 centerPoint = sphere->GetPosition() - planeNorm;
-						glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
-
-						float torque = glm::dot(torqueLever, sphere->GetVelocity()) * 1.0f / (1.0f / sphere->Rigidbody()->m_data.mass);
-
-						sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-
-						// move out of collision
-						glm::vec3 separationVector = planeNorm * collision * 0.5f;
-						sphere->SetPosition(sphere->GetPosition() - separationVector);
-					}
-				}
-				else
-				{
-					// object colliding, stop object
-					sphere->SetVelocity(glm::vec3(0.0f));
-					sphere->Rigidbody()->m_data.onGround = true;
-				}
-				return true;
-			}
-		}
-		return false;
-	}
-
-	bool Scene::sphereToBox(PhysicsObject* a_sphere, PhysicsObject* a_box)
-	{
-		return boxToSphere(a_box, a_sphere);
-	}
-	/*********************************************************************************************************
-	* Box to Object collsions
-	**********************************************************************************************************/
-	bool Scene::boxToSphere(PhysicsObject* a_box, PhysicsObject* a_sphere)
-	{
-		Box* box = dynamic_cast<Box*>(a_box);
-		Sphere* sphere = dynamic_cast<Sphere*>(a_sphere);
-
-		if (box != nullptr && sphere != nullptr)
-		{
-			// collision check
-			if (box->checkCollision(sphere))
-			{
-				// cache some bools for later use
-				bool kinematicA = box->Rigidbody()->m_data.isKinematic;
-				bool kinematicB = sphere->Rigidbody()->m_data.isKinematic;
-				bool onGroundA = box->Rigidbody()->m_data.onGround;
-				bool onGroundB = sphere->Rigidbody()->m_data.onGround;
-				// check either is kinematic
-				if (!kinematicA || !kinematicB)
-				{
-					glm::vec3 centerDist = sphere->GetPosition() - box->GetPosition();
-					glm::vec3 boxesMaxSize = glm::vec3(box->GetSize() + sphere->GetRadius());
-					glm::vec3 collisionNormal = glm::normalize(centerDist);
-					glm::vec3 overlap = abs(centerDist - boxesMaxSize);
-					// if both boxs are not on the ground
-					if (!onGroundA && !onGroundB)
-					{
-						// calculate force vector
-						glm::vec3 relativeVelocity = box->GetVelocity() - sphere->GetVelocity();
-						glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
-						glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / box->Rigidbody()->m_data.mass + 1.0f / sphere->Rigidbody()->m_data.mass);
-						// combine elasticity
-						float combinedElasticity = (box->Rigidbody()->m_data.elasticity +
-							sphere->Rigidbody()->m_data.elasticity / 2.0f);
-						// use Newton's third law to apply collision forces to colliding bodies 
-						box->Rigidbody()->applyForceToAnotherBody(sphere->Rigidbody(), forceVector + (forceVector * combinedElasticity));
-						// apply torque
-						float torque = glm::dot(collisionVector, relativeVelocity) * 1.0f / (1.0f / box->Rigidbody()->m_data.mass + 1.0f / sphere->Rigidbody()->m_data.mass);
-
-						box->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-						sphere->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-						// move out boxs out of collision 
-						glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-						box->SetPosition(box->GetPosition() - separationVector);
-						sphere->SetPosition(sphere->GetPosition() + separationVector);
-					}
-					// if one box is on the ground treat collision as plane collision
-					if (onGroundA || onGroundB)
-					{
-						// determine moving box
-						PhysicsObject* obj = (onGroundA ? dynamic_cast<PhysicsObject*>(sphere) : dynamic_cast<PhysicsObject*>(box));
-						PhysicsObject* objGround = (onGroundA ? dynamic_cast<PhysicsObject*>(box) : dynamic_cast<PhysicsObject*>(sphere));
-						// calculate force vector
-						glm::vec3 forceVector = -1 * obj->Rigidbody()->m_data.mass * collisionNormal * (glm::dot(collisionNormal, obj->GetVelocity()));
-						// apply force
-						obj->Rigidbody()->applyForce(forceVector * 2.0f);
-						// move out of collision
-						glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-						obj->SetPosition(obj->GetPosition() - separationVector);
-						// stop other box from being on ground
-						objGround->Rigidbody()->m_data.onGround = objGround->Rigidbody()->m_data.isStatic ? true : false;
-					}
-				}
-				else
-				{
-					// object colliding yes, stop objects
-					box->SetVelocity(glm::vec3(0.0f));
-					sphere->SetVelocity(glm::vec3(0.0f));
-					if (onGroundA || onGroundB) {
-						box->Rigidbody()->m_data.onGround = true;
-						sphere->Rigidbody()->m_data.onGround = true;
-					}
-				}
-				return true;
-			}
-		}
-		return false;
-	}
-
-	bool Scene::boxToPlane(PhysicsObject* a_box, PhysicsObject* a_plane)
-	{
-		Box* box = dynamic_cast<Box*>(a_box);
-		Plane* plane = dynamic_cast<Plane*>(a_plane);
-
-		if (box != nullptr && plane != nullptr)
-		{
-			glm::vec3 planeNormal = plane->getNormal();
-			glm::vec3 center = box->GetPosition();
-			glm::vec3 extents(box->GetSize());
-			// magnitude of box center and plane vectors
-			float mag = dot(planeNormal, center);
-			// projection interval radius of box onto the plane
-			float radius = extents.x * abs(planeNormal.x) + extents.y * abs(planeNormal.y) + extents.z * abs(planeNormal.z);
-
-			// if planeNorm is below 0 magnitude will be negative
-			if (mag < 0)
-			{
-				planeNormal *= -1;
-				mag *= -1;
-			}
-
-			float collision = mag - radius;
-
-			// collision check
-			if (collision <= 0.0f)
-			{
-				// cache some data
-				bool kinematic = box->Rigidbody()->m_data.isKinematic;
-				if (!kinematic) {
-					// calculate force vector
-					glm::vec3 forceVector = -1 * box->Rigidbody()->m_data.mass * planeNormal * (glm::dot(planeNormal, box->GetVelocity()));
-					// combine elasticity
-					float combinedElasticity = (box->Rigidbody()->m_data.elasticity +
-						plane->getElasticity() / 2.0f);
-					// only bounce if not resting on the ground
-					if (!box->Rigidbody()->m_data.onGround) {
-						// apply force
-						box->Rigidbody()->applyForce(forceVector + (forceVector * combinedElasticity));
-
-						// apply torque
-						glm::vec3 centerPoint = box->GetPosition() - planeNormal;
-						glm::vec3 torqueLever = glm::normalize(glm::vec3(centerPoint.y, -centerPoint.x, 0.0f));
-						float torque = glm::dot(torqueLever, box->GetVelocity()) * 1.0f / (1.0f / box->Rigidbody()->m_data.mass);
-						box->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-
-						// move out of collision
-						glm::vec3 separationVector = planeNormal * collision * 0.5f;
-						box->SetPosition(box->GetPosition() - separationVector);
-					}
-				}
-				else {
-					// object colliding, stop object
-					box->SetVelocity(glm::vec3(0.0f));
-					box->Rigidbody()->m_data.onGround = true;
-				}
-				return true;
-			}
-		}
-		return false;
-	}
-
-	bool Scene::boxToBox(PhysicsObject* a_boxA, PhysicsObject* a_boxB)
-	{
-		Box* boxA = dynamic_cast<Box*>(a_boxA);
-		Box* boxB = dynamic_cast<Box*>(a_boxB);
-
-		if (boxA != nullptr && boxB != nullptr)
-		{
-			// collision check
-			if (boxA->checkCollision(boxB))
-			{
-				// cache some bools for later use
-				bool kinematicA = boxA->Rigidbody()->m_data.isKinematic;
-				bool kinematicB = boxB->Rigidbody()->m_data.isKinematic;
-				bool onGroundA = boxA->Rigidbody()->m_data.onGround;
-				bool onGroundB = boxB->Rigidbody()->m_data.onGround;
-				// check either is kinematic
-				if (!kinematicA || !kinematicB) {
-					glm::vec3 centerDist = boxB->GetPosition() - boxA->GetPosition();
-					glm::vec3 boxesMaxSize = glm::vec3(boxA->GetSize() + boxB->GetSize());
-					glm::vec3 collisionNormal = glm::normalize(centerDist);
-					glm::vec3 overlap = abs(centerDist - boxesMaxSize);
-					// if both boxs are not on the ground
-					if (!onGroundA && !onGroundB)
-					{
-						// calculate force vector
-						glm::vec3 relativeVelocity = boxA->GetVelocity() - boxB->GetVelocity();
-						glm::vec3 collisionVector = collisionNormal * (glm::dot(relativeVelocity, collisionNormal));
-						glm::vec3 forceVector = collisionVector * 1.0f / (1.0f / boxA->Rigidbody()->m_data.mass + 1.0f / boxB->Rigidbody()->m_data.mass);
-						// combine elasticity
-						float combinedElasticity = (boxA->Rigidbody()->m_data.elasticity +
-							boxB->Rigidbody()->m_data.elasticity / 2.0f);
-						// use Newton's third law to apply collision forces to colliding bodies 
-						boxA->Rigidbody()->applyForceToAnotherBody(boxB->Rigidbody(), forceVector + (forceVector * combinedElasticity));
-
-						// apply torque
-						float torque = glm::dot(collisionVector, relativeVelocity) * 1.0f / (1.0f / boxA->Rigidbody()->m_data.mass + 1.0f / boxB->Rigidbody()->m_data.mass);
-
-						boxA->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, -torque));
-						boxB->Rigidbody()->applyTorque(glm::vec3(0.0f, 0.0f, torque));
-
-						// move out boxs out of collision 
-						glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-						boxA->SetPosition(boxA->GetPosition() - separationVector);
-						boxB->SetPosition(boxB->GetPosition() + separationVector);
-					}
-					// if one box is on the ground treat collsion as plane collision
-					if (onGroundA || onGroundB)
-					{
-						// determine moving box
-						Box* box = (onGroundA ? boxB : boxA);
-						Box* boxGround = (onGroundA ? boxA : boxB);
-						// calculate force vector
-						glm::vec3 forceVector = -1 * box->Rigidbody()->m_data.mass * collisionNormal * (glm::dot(collisionNormal, box->GetVelocity()));
-						// apply force
-						box->Rigidbody()->applyForce(forceVector * 2.0f);
-						// move out of collision
-						glm::vec3 separationVector = collisionNormal * overlap * 0.5f;
-						box->SetPosition(box->GetPosition() - separationVector);
-						// stop other box from being on ground
-						boxGround->Rigidbody()->m_data.onGround = false;
-					}
-				}
-				else
-				{
-					// object colliding yes, stop objects
-					boxA->SetVelocity(glm::vec3(0.0f));
-					boxB->SetVelocity(glm::vec3(0.0f));
-					if (onGroundA || onGroundB) {
-						boxA->Rigidbody()->m_data.onGround = true;
-						boxB->Rigidbody()->m_data.onGround = true;
-					}
-				}
-				return true;
-			}
-		}
-		return false;
+		std::unique_lock<std::mutex> lock = m_physicsThread->LockScene();
+		m_physicsScene->checkCollisions();
 	}
 }
 
@@ -5,8 +5,10 @@
 #include"camera.h"
 #include"shadersManager.h"
 
-#include"PhysicsEngine/Box.h"
-#include"PhysicsEngine/Plane.h"
+#include"PhysicsEngine/BoxModel.h"
+#include"PhysicsEngine/PlaneModel.h"
+#include"PhysicsEngine/PhysicsScene.h"
+#include"PhysicsEngine/PhysicsThread.h"
 #include"Terrain/Terrain.h"
 #include"Terrain/TerrainSimul.h"
 #include"Sky/AbstractSky.h"
@@ -14,15 +16,6 @@
 namespace ntn
 {
 
-    struct PhysicsProperties
-    {
-        bool gravity;
-        bool collisions;
-        bool collisionResponse ;
-
-        PhysicsProperties(bool gravity_ = true, bool collisions_ = true, bool collisionResponse = true) :
-                            gravity(gravity_), collisions(collisions_), collisionResponse(collisionResponse) {};
-    };
     enum class SkyType
     {
         SkyBox = 0,
@@ -37,6 +30,7 @@ namespace ntn
 
         // Scene Management
         void setGui();
+        void setProfilerGui();
         void loadScene();
         void resetScene(); //reset objects's positions
         void clearScene(); //delete objects
@@ -78,23 +72,15 @@ namespace ntn
         void RenderPhysicsObjects(Shader& shader, const std::unique_ptr<Camera>& camera, bool isRender_BBoxes = false);
 
         /**************     COLLISIONS  ****************/
+        // collisions run through the physics scene so both share the broadphase
         void checkCollisions();
 
-        void setGravity(const glm::vec3 gravity) { m_gravity = gravity; }
+        void setGravity(const glm::vec3 gravity);
         glm::vec3 getGravity() const { return m_gravity; }
-        // plane
-        static bool planeToPlane(PhysicsObject* planeA, PhysicsObject* planeB);
-        static bool planeToSphere(PhysicsObject* plane, PhysicsObject* sphere);
-        static bool planeToBox(PhysicsObject* plane, PhysicsObject* box);
-        // sphere
-        static bool sphereToSphere(PhysicsObject* sphereA, PhysicsObject* sphereB);
-        static bool sphereToPlane(PhysicsObject* sphere, PhysicsObject* plane);
-        static bool sphereToBox(PhysicsObject* sphere, PhysicsObject* box);
-        // box
-        static bool boxToSphere(PhysicsObject* box, PhysicsObject* sphere);
-        static bool boxToPlane(PhysicsObject* box, PhysicsObject* plane);
-        static bool boxToBox(PhysicsObject* boxA, PhysicsObject* boxB);
 
+        // only touch the physics scene under getPhysicsThread().LockScene(), or through Enqueue
+        inline std::unique_ptr<PhysicsScene>& getPhysicsScene() { return m_physicsScene; }
+        inline PhysicsThread& getPhysicsThread() { return *m_physicsThread; }
 
     private:
         SkyType m_typeSky = SkyType::SkyBox;
@@ -110,7 +96,19 @@ namespace ntn
         BoundingBox m_sceneBounds;
 
         glm::vec3 m_gravity = glm::vec3(0.f, -2.0f, 0.0f);
-        PhysicsProperties m_properties = PhysicsProperties(true, true, true);
+        // owns every physics object of the scene, balls and cubes included
+        std::unique_ptr<PhysicsScene> m_physicsScene = nullptr;
+        // state saved from the Environment window, to replay the steps after it
+        PhysicsSnapshot m_snapshot;
+        // steps m_physicsScene away from the render loop, the renderer draws what it publishes
+        std::unique_ptr<PhysicsThread> m_physicsThread = nullptr;
+        bool m_threadedPhysics = true;
+        // edited by the Environment window, handed to the physics thread when they change
+        PhysicsProperties m_physicsProperties;
+        int m_maxSubSteps = 0;
+        // history of the published frames for the Physics profiler window
+        PhysicsProfiler m_profiler;
+        uint64_t m_profiledUpdate = 0;
 
     };
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 330
+
+// first sample of the chunk, the sample inside it comes from gl_VertexID
+layout (location = 0) in vec2 aChunkOffset;
+
+uniform float gMinHeight = 0.0f;
+uniform float gMaxHeight = 356.0f;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform sampler2D gHeightMap;
+// heights are normalized over gHeightRange.y from gHeightRange.x
+uniform vec2 gHeightRange;
+uniform ivec2 gSize;
+uniform vec2 gOrigin;
+uniform int gChunkSize;
+
+out vec4 Color;
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 WorldPos;
+
+float HeightAt(ivec2 samplePos)
+{
+    return gHeightRange.x + texelFetch(gHeightMap, clamp(samplePos, ivec2(0), gSize - 1), 0).r * gHeightRange.y;
+}
+
+void main()
+{
+    ivec2 local = ivec2(gl_VertexID % (gChunkSize + 1), gl_VertexID / (gChunkSize + 1));
+    // chunks on the far edges are cut short, their extra vertices collapse onto the border
+    ivec2 samplePos = min(ivec2(aChunkOffset) + local, gSize - 1);
+
+    vec3 Position = vec3(gOrigin.x + samplePos.x, HeightAt(samplePos), gOrigin.y + samplePos.y);
+    gl_Position = projection * view * model * vec4(Position, 1.0);
+    TexCoords = vec2(float(samplePos.x) / float(gSize.x - 1), 1.0 - float(samplePos.y) / float(gSize.y - 1));
+    WorldPos = Position;
+
+    // central differences, one-sided on the borders
+    ivec2 low = max(samplePos - 1, ivec2(0));
+    ivec2 high = min(samplePos + 1, gSize - 1);
+    float dx = (HeightAt(ivec2(low.x, samplePos.y)) - HeightAt(ivec2(high.x, samplePos.y))) / float(high.x - low.x);
+    float dz = (HeightAt(ivec2(samplePos.x, low.y)) - HeightAt(ivec2(samplePos.x, high.y))) / float(high.y - low.y);
+    Normal = normalize(vec3(dx, 1.0, dz));
+
+    float DeltaHeight = gMaxHeight - gMinHeight;
+    float HeightRatio = (Position.y - gMinHeight) / DeltaHeight;
+    float c = HeightRatio * 0.8 + 0.2;
+    Color = vec4(c, c, c, 1.0);
+}
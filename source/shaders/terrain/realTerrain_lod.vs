@@ -0,0 +1,61 @@
+#version 330
+
+layout (location = 0) in vec2 aGridPos;
+// first sample, sample size and level of the grid
+layout (location = 1) in vec4 aOffsetSizeLevel;
+
+uniform float gMinHeight = 0.0f;
+uniform float gMaxHeight = 356.0f;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform sampler2D gHeightMap;
+uniform vec2 gSize;
+uniform vec2 gOrigin;
+uniform float gGridSize;
+uniform vec3 gCameraPos;
+// distance where each level starts and ends morphing into the next one
+uniform vec2 gMorphRange[8];
+
+out vec4 Color;
+out vec2 TexCoords;
+out vec3 Normal;
+out vec3 WorldPos;
+
+float HeightAt(vec2 samplePos)
+{
+    return texture(gHeightMap, (samplePos + 0.5) / gSize).r;
+}
+
+void main()
+{
+    int level = int(aOffsetSizeLevel.w);
+    float spacing = aOffsetSizeLevel.z / gGridSize;
+    vec2 samplePos = min(aOffsetSizeLevel.xy + aGridPos * spacing, gSize - 1.0);
+
+    // odd vertices slide onto their even neighbours, the grid of the next level
+    vec3 unmorphed = vec3(gOrigin.x + samplePos.x, HeightAt(samplePos), gOrigin.y + samplePos.y);
+    vec2 range = gMorphRange[level];
+    float morph = clamp((distance(gCameraPos, unmorphed) - range.x) / (range.y - range.x), 0.0, 1.0);
+    vec2 odd = fract(aGridPos * 0.5) * 2.0;
+    samplePos = min(aOffsetSizeLevel.xy + (aGridPos - odd * morph) * spacing, gSize - 1.0);
+
+    vec3 Position = vec3(gOrigin.x + samplePos.x, HeightAt(samplePos), gOrigin.y + samplePos.y);
+    gl_Position = projection * view * model * vec4(Position, 1.0);
+    TexCoords = vec2(samplePos.x / (gSize.x - 1.0), 1.0 - samplePos.y / (gSize.y - 1.0));
+    WorldPos = Position;
+
+    // central differences of the heights
+    float left = HeightAt(samplePos - vec2(1.0, 0.0));
+    float right = HeightAt(samplePos + vec2(1.0, 0.0));
+    float down = HeightAt(samplePos - vec2(0.0, 1.0));
+    float up = HeightAt(samplePos + vec2(0.0, 1.0));
+    Normal = normalize(vec3(left - right, 2.0, down - up));
+
+    float DeltaHeight = gMaxHeight - gMinHeight;
+    float HeightRatio = (Position.y - gMinHeight) / DeltaHeight;
+    float c = HeightRatio * 0.8 + 0.2;
+    Color = vec4(c, c, c, 1.0);
+}
@@ -43,6 +43,16 @@ namespace ntn
             {
                 return Shader("terrain/realTerrain_raw.vs", "terrain/realTerrain_raw.frag");
             }
+            else if (shaderName == "LodTerrainShader")
+            {
+                // the raw terrain shading on vertices placed by the lod quadtree
+                return Shader("terrain/realTerrain_lod.vs", "terrain/realTerrain_raw.frag");
+            }
+            else if (shaderName == "CompactTerrainShader")
+            {
+                // the raw terrain rebuilt from its height texture
+                return Shader("terrain/realTerrain_compact.vs", "terrain/realTerrain_raw.frag");
+            }
             else if (shaderName == "TessTerrainShader") 
             {
                 return Shader("terrain/realTerrain_tess.vs", "terrain/realTerrain_tess.frag",